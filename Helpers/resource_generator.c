@@ -6,8 +6,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(NDEBUG) && defined(__GNUC__) && !defined(__clang__)
+  // xhl_files only knows clang's __builtin_debugtrap
+  #define XFILES_ASSERT(cond) (cond) ? (void)0 : __builtin_trap()
+#endif
 #define XHL_FILES_IMPL
 #include "../Source/Third Party/xhl/xhl_files.h"
+#ifdef __linux__
+  #include "../Source/Framework/xhl_files_linux.c"
+#endif
 
 #define STB_SPRINTF_IMPLEMENTATION
 #include "../Source/Third Party/stb/stb_sprintf.h"
@@ -2,13 +2,13 @@
 // Created: 2024-02-13 20:05:06
 
 #include "fourier_transform.hpp"
+#include "utils.hpp"
 #include "memory.hpp"
 
 #ifdef COMPLEX_INTEL_IPP
   #include "ipps.h"
 #else
   #include "Third Party/pffft/pffft.h"
-  #include "simd_values.hpp"
 #endif
 
 
@@ -16,159 +16,115 @@ namespace Framework
 {
 #ifdef COMPLEX_INTEL_IPP
 
-  void createFFTRoutines(FFT &instance, u32 minOrder, u32 maxOrder)
-  {
-    static constexpr int cachelLineAlignment = 64;
-
-    COMPLEX_ASSERT(minOrder <= maxOrder);
+  static constexpr int kCacheLineAlignment = 64;
 
-    // full array is needed so that extending FFT orders works
-    auto *ippSpecs = arranew(instance.arena, void *, maxOrder + 1);
-
-    auto orderCount = maxOrder - minOrder + 1;
-    // compute sizes for all specs and add padding so that the specBuffer is also 64-byte aligned just in case
-    int *tempData = arranew(instance.arena, int, orderCount * 4);
-    int *specSizes = tempData;
-    int *specSizesPadding = specSizes + orderCount;
-    int *specBufferSizes = specSizesPadding + orderCount;
-    int *specBufferSizesPadding = specBufferSizes + orderCount;
-    int totalSize = 0;
-    int maxBufferSize = 0;
+  static void *createPlan(utils::bumpArena *arena, u32 order, void *&memory, usize &planBytes)
+  {
+    int specSize, specBufferSize, bufferSize;
+    ippsFFTGetSize_R_32f((int)order, IPP_FFT_NODIV_BY_ANY, ippAlgHintNone, &specSize, &specBufferSize, &bufferSize);
 
-    for (u32 i = 0; i < orderCount; ++i)
-    {
-      int bufferSize;
-      ippsFFTGetSize_R_32f((int)(minOrder + i), IPP_FFT_DIV_INV_BY_N, ippAlgHintNone, &specSizes[i], &specBufferSizes[i], &bufferSize);
-      maxBufferSize = (maxBufferSize > bufferSize) ? maxBufferSize : bufferSize;
+    auto *spec = (Ipp8u *)arena->insert(arena, (usize)specSize, kCacheLineAlignment);
+    // the spec buffer is only needed during initialisation
+    auto *specBuffer = (specBufferSize > 0) ? (Ipp8u *)arena->insert(arena, (usize)specBufferSize, kCacheLineAlignment) : nullptr;
 
-      specSizesPadding[i] = (cachelLineAlignment - (specSizes[i] % cachelLineAlignment)) % cachelLineAlignment;
-      totalSize += specSizes[i] + specSizesPadding[i];
+    IppsFFTSpec_R_32f *plan = nullptr;
+    ippsFFTInit_R_32f(&plan, (int)order, IPP_FFT_NODIV_BY_ANY, ippAlgHintNone, spec, specBuffer);
 
-      specBufferSizesPadding[i] = (cachelLineAlignment - (specBufferSizes[i] % cachelLineAlignment)) % cachelLineAlignment;
-      totalSize += specBufferSizes[i] + specBufferSizesPadding[i];
-    }
+    if (specBuffer)
+      utils::bumpArena::remove(specBuffer);
 
-    totalSize += maxBufferSize;
+    memory = spec;
+    planBytes = (usize)specSize;
+    return plan;
+  }
 
-    Ipp8u *buffer = arranew(instance.arena, Ipp8u, totalSize);
-    Ipp8u *rest = buffer + maxBufferSize + (cachelLineAlignment - (maxBufferSize % cachelLineAlignment)) % cachelLineAlignment;
+  static void destroyPlan(void *memory)
+  {
+    utils::bumpArena::remove(memory);
+  }
 
-    for (u32 i = 0; i < orderCount; ++i)
+  static utils::pair<usize, usize> getWorkBufferSize(u32 minOrder, u32 maxOrder)
+  {
+    int maxBufferSize = 0;
+    for (u32 i = minOrder; i < maxOrder + 1; ++i)
     {
-      Ipp8u *spec = rest;
-      rest += specSizes[i] + specSizesPadding[i];
-      Ipp8u *specBuffer = rest;
-      rest += specBufferSizes[i] + specBufferSizesPadding[i];
-
-      IppsFFTSpec_R_32f *plan = nullptr;
-      ippsFFTInit_R_32f(&plan, (int)(minOrder + i), IPP_FFT_DIV_INV_BY_N, ippAlgHintNone, spec, specBuffer);
-      ippSpecs[minOrder + i] = plan;
+      int specSize, specBufferSize, bufferSize;
+      ippsFFTGetSize_R_32f((int)i, IPP_FFT_NODIV_BY_ANY, ippAlgHintNone, &specSize, &specBufferSize, &bufferSize);
+      maxBufferSize = (maxBufferSize > bufferSize) ? maxBufferSize : bufferSize;
     }
 
-    utils::bumpArena::remove(tempData);
-
-    instance.ippSpecs_.store(ippSpecs, satomi::memory_order_relaxed);
-    instance.buffer_.store(buffer, satomi::memory_order_relaxed);
-  }
-
-  static void destroyFFTRoutines(FFT &instance)
-  {
-    if (auto buffer = instance.buffer_.load(satomi::memory_order_relaxed))
-      utils::bumpArena::remove(buffer);
-    if (auto ippSpecs = instance.ippSpecs_.load(satomi::memory_order_relaxed))
-      utils::bumpArena::remove(ippSpecs);
+    return { (usize)maxBufferSize, (usize)kCacheLineAlignment };
   }
 
   void FFT::transformRealForward(u32 order, float *input, u32) const noexcept
   {
-    COMPLEX_ASSERT(order >= orders.load(satomi::memory_order_relaxed).first);
+    auto *routines = routines_.load(satomi::memory_order_acquire);
+    COMPLEX_ASSERT(order >= routines->minOrder && order <= routines->maxOrder);
     usize size = 1ULL << order;
 
     // zeroing out nyquist from previous transforms
     input[size] = 0.0f;
-    ippsFFTFwd_RToCCS_32f_I(input,
-      (IppsFFTSpec_R_32f *)ippSpecs_.load(satomi::memory_order_acquire)[order],
-      (Ipp8u *)buffer_.load(satomi::memory_order_relaxed));
+    ippsFFTFwd_RToCCS_32f_I(input, (IppsFFTSpec_R_32f *)routines->plans[order], (Ipp8u *)routines->workBuffer);
   }
 
   void FFT::transformRealInverse(u32 order, float *output, u32) const noexcept
   {
-    COMPLEX_ASSERT(order >= orders.load(satomi::memory_order_relaxed).first);
+    auto *routines = routines_.load(satomi::memory_order_acquire);
+    COMPLEX_ASSERT(order >= routines->minOrder && order <= routines->maxOrder);
     usize size = 1ULL << order;
 
     // clearing out dc and nyquist imaginary parts since they shouldn't exist
     // but you don't know what might have happened during processing
     output[1] = 0.0f;
     output[size + 1] = 0.0f;
-    ippsFFTInv_CCSToR_32f_I(output,
-      (IppsFFTSpec_R_32f *)ippSpecs_.load(satomi::memory_order_acquire)[order],
-      (Ipp8u *)buffer_.load(satomi::memory_order_relaxed));
+    ippsFFTInv_CCSToR_32f_I(output, (IppsFFTSpec_R_32f *)routines->plans[order], (Ipp8u *)routines->workBuffer);
   }
 
 #else
 
-  // pffft requires all inputs and outputs be aligned to the simd type at use
-  // so we can safely use aligned loads and stores
-  forceinline simd_float vectorcall toSimdFloat(const float *aligned) noexcept
+  static void *createPlan(utils::bumpArena *arena, u32 order, void *&memory, usize &planBytes)
   {
-  #if COMPLEX_SSE4_1
-    return _mm_load_ps(aligned);
-  #elif COMPLEX_NEON
-    return vld1q_f32(aligned);
-  #endif
+    struct Allocation
+    {
+      utils::bumpArena *arena;
+      usize bytes;
+    } allocation{ arena, 0 };
+
+    // userdata is only used for allocating, deallocation goes through the arena the memory came from
+    auto *plan = pffft_new_setup(1 << order, PFFFT_REAL,
+      [](void *ud, usize size, usize alignment) -> void *
+      {
+        auto *allocation = (Allocation *)ud;
+        allocation->bytes += size;
+        return utils::bumpArena::insert(allocation->arena, size, alignment);
+      },
+      [](void *, void *allocation) { utils::bumpArena::remove(allocation); },
+      &allocation);
+
+    memory = plan;
+    planBytes = allocation.bytes;
+    return plan;
   }
 
-  forceinline void vectorcall fromSimdFloat(float *aligned, simd_float value) noexcept
+  static void destroyPlan(void *memory)
   {
-  #if COMPLEX_SSE4_1
-    _mm_store_ps(aligned, value.value);
-  #elif COMPLEX_NEON
-    vst1q_f32(aligned, value.value);
-  #endif
+    pffft_destroy_setup((PFFFT_Setup *)memory);
   }
 
-  static void createFFTRoutines(FFT &instance, u32 minOrder, u32 maxOrder)
+  static utils::pair<usize, usize> getWorkBufferSize(u32, u32 maxOrder)
   {
-    // full array is needed so that extending FFT orders works
-    auto *plans = arranew(instance.arena, void *, maxOrder + 1);
-
-    for (usize i = minOrder; i < maxOrder + 1; ++i)
-      plans[i] = pffft_new_setup(1 << i, PFFFT_REAL, 
-        [](void *ud, usize size, usize alignment) -> void * { return utils::bumpArena::insert((utils::bumpArena *)ud, size, alignment); },
-        [](void *, void *allocation) { utils::bumpArena::remove(allocation); },
-        instance.arena);
-
-    instance.plans_.store(plans, satomi::memory_order_relaxed);
-
     // buffer needs to be 16 byte aligned for sse/neon
-    instance.scratchBuffers_.store((float *)instance.arena->insert(instance.arena, 
-      ((usize(1) << maxOrder) * sizeof(float)), pffft_simd_size() * alignof(float), true),
-      satomi::memory_order_relaxed);
-  }
-
-  static void destroyFFTRoutines(FFT &instance)
-  {
-    auto [minOrder, maxOrder] = instance.orders.load(satomi::memory_order_acquire);
-
-    if (auto *plans = instance.plans_.load(satomi::memory_order_relaxed))
-    {
-      for (usize i = minOrder; i < maxOrder + 1; ++i)
-        if (plans[i])
-          pffft_destroy_setup((PFFFT_Setup *)plans[i]);
-
-      utils::bumpArena::remove(plans);
-    }
-    if (auto *scratch = instance.scratchBuffers_.load(satomi::memory_order_relaxed))
-      utils::bumpArena::remove(scratch);
+    return { (usize(1) << maxOrder) * sizeof(float), pffft_simd_size() * alignof(float) };
   }
 
   void FFT::transformRealForward(u32 order, float *input, u32) const noexcept
   {
-    COMPLEX_ASSERT(order >= orders.load(satomi::memory_order_relaxed).first);
+    auto *routines = routines_.load(satomi::memory_order_acquire);
+    COMPLEX_ASSERT(order >= routines->minOrder && order <= routines->maxOrder);
     usize size = 1ULL << order;
 
-    auto plan = (PFFFT_Setup *)plans_.load(satomi::memory_order_acquire)[order];
-    auto scratch = scratchBuffers_.load(satomi::memory_order_relaxed);
+    auto plan = (PFFFT_Setup *)routines->plans[order];
+    auto scratch = (float *)routines->workBuffer;
 
     // zeroing out nyquist from previous transforms
     input[size] = 0.0f;
@@ -178,16 +134,12 @@ namespace Framework
 
   void FFT::transformRealInverse(u32 order, float *output, u32) const noexcept
   {
-    COMPLEX_ASSERT(order >= orders.load(satomi::memory_order_relaxed).first);
+    auto *routines = routines_.load(satomi::memory_order_acquire);
+    COMPLEX_ASSERT(order >= routines->minOrder && order <= routines->maxOrder);
     usize size = 1ULL << order;
 
-    COMPLEX_ASSERT((uintptr_t)output % sizeof(simd_float) == 0 && "Output buffer is not aligned");
-    simd_float scaling = 1.0f / (float)size;
-    for (usize i = 0; i < size; i += simd_float::size)
-      fromSimdFloat(output + i, toSimdFloat(output + i) * scaling);
-
-    auto plan = (PFFFT_Setup *)plans_.load(satomi::memory_order_acquire)[order];
-    auto scratch = scratchBuffers_.load(satomi::memory_order_relaxed);
+    auto plan = (PFFFT_Setup *)routines->plans[order];
+    auto scratch = (float *)routines->workBuffer;
 
     // separating dc and nyquist bins and cleaning accidental writes to nyquist imaginary part
     scratch[1] = 0.0f;
@@ -197,22 +149,138 @@ namespace Framework
 
 #endif
 
+  void *FFTPlanCache::acquire(u32 order, FFTBackend backend)
+  {
+    COMPLEX_ASSERT(backend == kFFTBackend, "Only plans for the compiled backend can be created");
+    COMPLEX_ASSERT(order <= kMaxFFTOrder);
+
+    utils::ScopedLock g{ lock, utils::WaitMechanism::WaitNotify };
+
+    auto &entry = entries[(usize)backend][order];
+    if (!entry.plan)
+    {
+      u64 start = utils::getMonotonicMicroseconds();
+      entry.plan = createPlan(arena, order, entry.memory, entry.planBytes);
+      creationMicroseconds += utils::getMonotonicMicroseconds() - start;
+    }
+
+    ++entry.references;
+    return entry.plan;
+  }
+
+  void FFTPlanCache::release(u32 order, FFTBackend backend)
+  {
+    utils::ScopedLock g{ lock, utils::WaitMechanism::WaitNotify };
+
+    auto &entry = entries[(usize)backend][order];
+    COMPLEX_ASSERT(entry.references > 0, "Releasing a plan that wasn't acquired");
+
+    if (--entry.references == 0)
+    {
+      destroyPlan(entry.memory);
+      entry = {};
+    }
+  }
+
+  usize FFTPlanCache::getSavedBytes() const
+  {
+    utils::ScopedLock g{ lock, utils::WaitMechanism::WaitNotify };
+
+    usize savedBytes = 0;
+    for (auto &backendEntries : entries)
+      for (auto &entry : backendEntries)
+        if (entry.references > 1)
+          savedBytes += (entry.references - 1) * entry.planBytes;
+
+    return savedBytes;
+  }
+
+  static FFT::Routines *createRoutines(FFT &instance, u32 minOrder, u32 maxOrder)
+  {
+    COMPLEX_ASSERT(minOrder <= maxOrder);
+
+    auto *routines = anew(instance.arena, FFT::Routines, { .minOrder = minOrder, .maxOrder = maxOrder });
+    routines->plans = arranew(instance.arena, void *, maxOrder + 1);
+    for (u32 i = minOrder; i < maxOrder + 1; ++i)
+      routines->plans[i] = instance.planCache->acquire(i);
+
+    // work buffer is the only per-instance memory
+    auto [size, alignment] = getWorkBufferSize(minOrder, maxOrder);
+    routines->workBuffer = instance.arena->insert(instance.arena, size, alignment, true);
+
+    return routines;
+  }
+
+  static void destroyRoutines(FFT &instance, FFT::Routines *routines)
+  {
+    utils::bumpArena::remove(routines->workBuffer);
+
+    for (u32 i = routines->minOrder; i < routines->maxOrder + 1; ++i)
+      instance.planCache->release(i);
+    utils::bumpArena::remove(routines->plans);
+
+    utils::bumpArena::remove(routines);
+  }
+
+  static void retireRoutines(FFT &instance, FFT::Routines *routines)
+  {
+    // if the audio thread was inside a block when the new routines were published
+    // it might still be using the old ones, so we wait for it to leave that block
+    if (u64 epoch = instance.epoch_.load(satomi::memory_order_seq_cst); epoch & 1)
+      while (instance.epoch_.load(satomi::memory_order_acquire) == epoch)
+        utils::millisleep();
+
+    destroyRoutines(instance, routines);
+  }
+
   FFT::~FFT() noexcept
   {
-    destroyFFTRoutines(*this);
+    releaseFFTOrders();
+  }
+
+  void FFT::releaseFFTOrders()
+  {
+    // waiting on any build in flight
+    builder_ = utils::thread{};
+
+    if (auto *routines = routines_.exchange(nullptr, satomi::memory_order_acq_rel))
+      destroyRoutines(*this, routines);
+  }
+
+  u32 FFT::getAvailableOrder(u32 order) const noexcept
+  {
+    auto *routines = routines_.load(satomi::memory_order_acquire);
+    COMPLEX_ASSERT(routines, "No FFT orders have been created yet");
+    return utils::clamp(order, routines->minOrder, routines->maxOrder);
   }
 
   void FFT::extendFFTOrders(u32 newMinOrder, u32 newMaxOrder)
   {
-    auto [minOrder, maxOrder] = orders.load(satomi::memory_order_acquire);
+    COMPLEX_ASSERT(planCache, "FFT needs a plan cache to get plans from");
 
-    // just performing an atomic swap after creating the new plans and buffer
-    if (newMinOrder >= minOrder && newMaxOrder <= maxOrder)
+    // only one build is in flight at a time, waiting on the previous one
+    builder_ = utils::thread{};
+
+    auto *current = routines_.load(satomi::memory_order_acquire);
+    // nothing to fall back on, so this has to be done right away
+    if (!current)
+    {
+      routines_.store(createRoutines(*this, newMinOrder, newMaxOrder), satomi::memory_order_release);
+      return;
+    }
+
+    if (newMinOrder >= current->minOrder && newMaxOrder <= current->maxOrder)
       return;
 
-    destroyFFTRoutines(*this);
-    createFFTRoutines(*this, newMinOrder, newMaxOrder);
+    // the current range is kept so that the order in use is still available after the swap
+    u32 minOrder = utils::min(newMinOrder, current->minOrder);
+    u32 maxOrder = utils::max(newMaxOrder, current->maxOrder);
 
-    orders.store({ newMinOrder, newMaxOrder }, satomi::memory_order_relaxed);
+    builder_ = [this, minOrder, maxOrder]()
+    {
+      auto *routines = createRoutines(*this, minOrder, maxOrder);
+      auto *previous = routines_.exchange(routines, satomi::memory_order_seq_cst);
+      retireRoutines(*this, previous);
+    };
   }
 }
@@ -4,8 +4,10 @@
 #pragma once
 
 #include "platform.hpp"
+#include "constants.hpp"
 #include "satomi.hpp"
 #include "stl_utils.hpp"
+#include "utils.hpp"
 
 namespace utils
 {
@@ -14,31 +16,80 @@ namespace utils
 
 namespace Framework
 {
+  enum class FFTBackend : u8 { Pffft, IntelIpp, Count };
+
+#ifdef COMPLEX_INTEL_IPP
+  inline constexpr FFTBackend kFFTBackend = FFTBackend::IntelIpp;
+#else
+  inline constexpr FFTBackend kFFTBackend = FFTBackend::Pffft;
+#endif
+
+  // process-wide cache of fft plans (pffft setups/ipp specs), keyed by order and backend
+  // plans are immutable once created so they're shared between all plugin instances,
+  // only the work buffers are per instance
+  struct FFTPlanCache
+  {
+    struct Entry
+    {
+      void *plan{};
+      // start of the allocation backing the plan, not always the same as plan
+      void *memory{};
+      usize planBytes{};
+      u32 references{};
+    };
+
+    void *acquire(u32 order, FFTBackend backend = kFFTBackend);
+    void release(u32 order, FFTBackend backend = kFFTBackend);
+    // memory that would have been taken if every instance created its own plans
+    usize getSavedBytes() const;
+
+    utils::bumpArena *arena{};
+    mutable satomi::atomic<bool> lock{};
+    // total time spent creating plans, for comparing instantiation costs
+    u64 creationMicroseconds{};
+    Entry entries[(usize)FFTBackend::Count][kMaxFFTOrder + 1]{};
+  };
+
   struct FFT
   {
+    // plans and work buffer for a contiguous range of orders, replaced as a whole
+    struct Routines
+    {
+      u32 minOrder{};
+      u32 maxOrder{};
+      // indexed by order, entries below minOrder are unused
+      void **plans{};
+      // pffft scratch buffer/ipp work buffer
+      void *workBuffer{};
+    };
+
     FFT() = default;
     ~FFT() noexcept;
 
+    // the first range is built immediately, any extension after that is built on a background thread
+    // and published once it's ready, until then the previous range stays in use
     void extendFFTOrders(u32 newMinOrder, u32 newMaxOrder);
+    // gives back all plans to the cache, safe to call more than once
+    void releaseFFTOrders();
+
+    // the audio thread brackets its use of the transforms with these
+    // so that replaced routines aren't freed from under it
+    void beginProcessing() noexcept { epoch_.fetch_add(1, satomi::memory_order_seq_cst); }
+    void endProcessing() noexcept { epoch_.fetch_add(1, satomi::memory_order_release); }
+    // closest order to the requested one that can currently be transformed
+    u32 getAvailableOrder(u32 order) const noexcept;
 
     void transformRealForward(u32 order, float *input, u32 channel) const noexcept;
+    // unnormalised, the 1/N scaling is left to the caller
     void transformRealInverse(u32 order, float *output, u32 channel) const noexcept;
 
-    // TODO: why are these even atomics 
-    // if a single instance of this struct can't be used by multiple states??
-    satomi::atomic<utils::pair<u32, u32>> orders{};
     utils::bumpArena *arena{};
+    FFTPlanCache *planCache{};
 
-  #ifdef COMPLEX_INTEL_IPP
-    // Intel IPP
-    satomi::atomic<void **> ippSpecs_{};
-    satomi::atomic<void *> buffer_{};
-  #else
-    // pffft
-    satomi::atomic<void **> plans_{};
-    satomi::atomic<float *> scratchBuffers_{};
-  #endif
+    satomi::atomic<Routines *> routines_{};
+    // odd while the audio thread is inside a block
+    satomi::atomic<u64> epoch_{};
+    utils::thread builder_{};
     // TODO: add vDSP FFT option
-
   };
 }
@@ -1,6 +1,8 @@
 
 // Created: 2022-12-03 01:46:31
 
+#include <stdio.h> // snprintf, for printing numbers exactly like cjson
+
 #include "load_save.hpp"
 
 #include "Third Party/cplug/config.h"
@@ -48,6 +50,321 @@ void initialiseCJSONHooks()
   cjson_InitHooks(&hooks);
 }
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+  #error "The binary state format is little-endian and values are copied as they are in memory"
+#endif
+
+namespace
+{
+  // binary state layout:
+  //   header:     magic, format version, plugin version
+  //   processor:  id, state id, name, parameters, (effect parameters for modules), children count, children
+  //   parameters: count, then every parameter prefixed with its size so that unknown ones can be skipped
+  //   strings:    size followed by the characters without a null terminator
+  // ids are the same numeric uuids the json uses as keys,
+  // everything is written in the order it's needed when loading so it can be read in a single pass
+  constexpr u32 kBinaryStateMagic = 'C' | ('P' << 8) | ('L' << 16) | ('X' << 24);
+  constexpr u32 kBinaryStateVersion = 1;
+  // options and processors nested deeper than this are treated as corrupted data instead of being recursed into
+  constexpr u32 kMaxBinaryNesting = 64;
+
+  // with a writeProc the bytes are handed over in chunks of about kFlushSize, otherwise they're all kept in bytes
+  // a chunk never ends inside a sized section since its size is filled in after the contents,
+  // those are single parameters so they stay small
+  struct BinaryWriter
+  {
+    static constexpr usize kFlushSize = COMPLEX_KB(4);
+
+    void
+    write(const void *data, usize size)
+    {
+      if (size)
+        ::memcpy(bytes.pushBack(size), data, size);
+
+      if (writeProc && !openSizedCount && bytes.size() >= kFlushSize)
+        flush();
+    }
+
+    template<typename T>
+    void write(T value) { write(&value, sizeof(T)); }
+
+    void
+    writeString(utils::string_view string)
+    {
+      write((u32)string.size());
+      write(string.data(), string.size());
+    }
+
+    // reserves space for a size that's filled in by endSized once the contents are written
+    usize
+    beginSized()
+    {
+      // counted first so that the placeholder isn't flushed before it's filled in
+      ++openSizedCount;
+      write(u32{});
+      return bytes.size();
+    }
+
+    void
+    endSized(usize start)
+    {
+      COMPLEX_ASSERT(openSizedCount, "Unbalanced sized sections");
+      u32 size = (u32)(bytes.size() - start);
+      ::memcpy(bytes.data() + start - sizeof(u32), &size, sizeof(u32));
+      --openSizedCount;
+    }
+
+    void
+    flush()
+    {
+      COMPLEX_ASSERT(writeProc && !openSizedCount, "Flushing a writer that keeps its bytes");
+      if (!bytes.empty())
+        writeProc(stateCtx, bytes.data(), bytes.size());
+      bytes.clear();
+    }
+
+    utils::vector<u8> bytes;
+    const void *stateCtx = nullptr;
+    cplug_writeProc writeProc = nullptr;
+    u32 openSizedCount = 0;
+  };
+
+  struct BinaryReader
+  {
+    void
+    read(void *data, usize size)
+    {
+      if (position + size > bytes.size())
+      {
+        // truncated save, keep returning zeroes so that all loops end
+        hasFailed = true;
+        position = bytes.size();
+        ::memset(data, 0, size);
+        return;
+      }
+
+      ::memcpy(data, bytes.data() + position, size);
+      position += size;
+    }
+
+    template<typename T>
+    T read() { T value; read(&value, sizeof(T)); return value; }
+
+    utils::string_view
+    readString()
+    {
+      u32 size = read<u32>();
+      if (position + size > bytes.size())
+      {
+        hasFailed = true;
+        position = bytes.size();
+        return {};
+      }
+
+      utils::string_view string{ bytes.data() + position, size };
+      position += size;
+      return string;
+    }
+
+    // everything after this reads as zeroes, so that all loops end
+    void
+    fail()
+    {
+      hasFailed = true;
+      position = bytes.size();
+    }
+
+    void
+    seek(usize newPosition)
+    {
+      hasFailed |= newPosition > bytes.size();
+      position = utils::min(newPosition, bytes.size());
+    }
+
+    utils::string_view bytes;
+    usize position = 0;
+    bool hasFailed = false;
+  };
+}
+
+namespace
+{
+  // writes the same text as cjson_Print(formatted) would for the equivalent tree
+  // but without building it, output is flushed through writeProc whenever the buffer fills up
+  struct JsonWriter
+  {
+    static constexpr usize kMaxDepth = 64;
+
+    void
+    write(const char *data, usize size)
+    {
+      while (size)
+      {
+        usize toCopy = utils::min(size, sizeof(buffer) - bufferSize);
+        ::memcpy(buffer + bufferSize, data, toCopy);
+        bufferSize += toCopy;
+        data += toCopy;
+        size -= toCopy;
+
+        if (bufferSize == sizeof(buffer))
+          flush();
+      }
+    }
+
+    void write(char character) { write(&character, 1); }
+
+    void
+    flush()
+    {
+      if (bufferSize)
+        writeProc(stateCtx, buffer, bufferSize);
+      bufferSize = 0;
+    }
+
+    void
+    writeTabs(usize count)
+    {
+      for (usize i = 0; i < count; ++i)
+        write('\t');
+    }
+
+    // same escaping as cjson's print_string_ptr
+    void
+    writeQuoted(const char *string)
+    {
+      write('\"');
+      for (auto *character = (const u8 *)string; *character; ++character)
+      {
+        if (*character > 31 && *character != '\"' && *character != '\\')
+        {
+          write((char)*character);
+          continue;
+        }
+
+        char escaped[8] = { '\\' };
+        usize escapedSize = 2;
+        switch (*character)
+        {
+        case '\\': escaped[1] = '\\'; break;
+        case '\"': escaped[1] = '\"'; break;
+        case '\b': escaped[1] = 'b'; break;
+        case '\f': escaped[1] = 'f'; break;
+        case '\n': escaped[1] = 'n'; break;
+        case '\r': escaped[1] = 'r'; break;
+        case '\t': escaped[1] = 't'; break;
+        default: escapedSize = 1 + (usize)::snprintf(escaped + 1, sizeof(escaped) - 1, "u%04x", *character); break;
+        }
+        write(escaped, escapedSize);
+      }
+      write('\"');
+    }
+
+    // separators and the key of the next item in the current object/array
+    void
+    beginItem(const char *key)
+    {
+      bool isFirst = !hasItems[depth];
+      hasItems[depth] = true;
+
+      if (isObject[depth])
+      {
+        if (!isFirst)
+          write(",\n", 2);
+        writeTabs(depth);
+        writeQuoted(key);
+        write(":\t", 2);
+      }
+      else if (depth && !isFirst)
+        write(", ", 2);
+    }
+
+    void
+    beginContainer(const char *key, bool object)
+    {
+      beginItem(key);
+      write((object) ? "{\n" : "[", (object) ? 2 : 1);
+
+      ++depth;
+      COMPLEX_ASSERT(depth < kMaxDepth);
+      isObject[depth] = object;
+      hasItems[depth] = false;
+    }
+
+    void
+    endContainer()
+    {
+      if (isObject[depth])
+      {
+        if (hasItems[depth])
+          write('\n');
+        writeTabs(depth - 1);
+        write('}');
+      }
+      else
+        write(']');
+
+      --depth;
+    }
+
+    void beginObject(const char *key = nullptr) { beginContainer(key, true); }
+    void beginArray(const char *key = nullptr) { beginContainer(key, false); }
+    void endObject() { COMPLEX_ASSERT(isObject[depth]); endContainer(); }
+    void endArray() { COMPLEX_ASSERT(!isObject[depth]); endContainer(); }
+
+    // cjson_Unsigned items are printed with %lli (and cjson_Integer ones with %llu), so values past i64 come out negative
+    void
+    addUnsigned(const char *key, u64 value)
+    {
+      char number[32];
+      int size = ::snprintf(number, sizeof(number), "%lli", (long long)value);
+      beginItem(key);
+      write(number, (usize)size);
+    }
+
+    void
+    addFloat(const char *key, double value)
+    {
+      char number[64];
+      int size = (value != value || value - value != value - value) ?
+        ::snprintf(number, sizeof(number), "null") : ::snprintf(number, sizeof(number), "%#g", value);
+      beginItem(key);
+      write(number, (usize)size);
+    }
+
+    void
+    addBool(const char *key, bool value)
+    {
+      beginItem(key);
+      if (value)
+        write("true", 4);
+      else
+        write("false", 5);
+    }
+
+    // cjson drops items with null strings, so they're skipped here as well
+    void
+    addString(const char *key, const char *value)
+    {
+      if (!value)
+        return;
+
+      beginItem(key);
+      writeQuoted(value);
+    }
+
+    const void *stateCtx;
+    cplug_writeProc writeProc;
+    usize bufferSize = 0;
+    usize depth = 0;
+    bool isObject[kMaxDepth]{};
+    bool hasItems[kMaxDepth]{};
+    char buffer[COMPLEX_KB(4)];
+  };
+}
+
+// set only while a binary state is being loaded, processors receive it as their serialised save
+thread_local BinaryReader *binaryReader{};
+
 extern Framework::ExecutableStaticData executableStaticData;
 
 utils::string_view
@@ -150,12 +467,16 @@ namespace Framework::LoadSave
       });
   }
 
-  void getStartupParameters(usize &parameterMappings, usize &inSidechains, usize &outSidechains, usize &undoSteps)
+  void getStartupParameters(usize &parameterMappings, usize &inSidechains, usize &outSidechains,
+    usize &undoSteps, usize &undoHistoryBudget, bool &isLowLatency, bool &isRenderingOffline)
   {
     parameterMappings = 100;
     inSidechains = 0;
     outSidechains = 0;
     undoSteps = 100;
+    undoHistoryBudget = Framework::UndoManager::defaultHistoryBudget;
+    isLowLatency = false;
+    isRenderingOffline = false;
 
     useConfigJson([&](cjson *json)
       {
@@ -170,6 +491,15 @@ namespace Framework::LoadSave
 
         if (cjson *item = cjson_GetObjectItem(json, "undo_steps"))
           undoSteps = (usize)item->vuint;
+
+        if (cjson *item = cjson_GetObjectItem(json, "undo_history_megabytes"))
+          undoHistoryBudget = (usize)item->vuint << 20;
+
+        if (cjson *item = cjson_GetObjectItem(json, "low_latency"))
+          isLowLatency = item->vbool;
+
+        if (cjson *item = cjson_GetObjectItem(json, "offline_rendering"))
+          isRenderingOffline = item->vbool;
       });
   }
 
@@ -215,19 +545,63 @@ namespace Framework::LoadSave
 
 thread_local utils::vector<Framework::IndexedData *> *dynamicOptionFixups{};
 
+static Framework::IndexedData *
+copyOptionWithoutChildren(utils::bumpArena *arena, Framework::IndexedData &option)
+{
+  auto *newOption = anew(arena, Framework::IndexedData, { option });
+  // lose the reference to the original parent so that we don't increment its count
+  newOption->parent = nullptr;
+  // lose the reference to the original children because we'll add copies of them back in
+  newOption->children = nullptr;
+  // break up child connecitons otherwise we will be duplicating everything after the first entry
+  newOption->next = nullptr;
+  return newOption;
+}
+
+static void addMissingOptions(utils::bumpArena *arena, bool isAutomated,
+  Framework::IndexedData &option, Framework::IndexedData *newOption)
+{
+  for (auto missingChild = option.children; missingChild; missingChild = missingChild->next)
+  {
+    bool isPresent = false;
+    for (auto newChild = newOption->children; newChild; newChild = newChild->next)
+      if ((isPresent = (newChild->id == missingChild->id)))
+        break;
+
+    if (!isPresent)
+    {
+      // if the parameter is automated we don't want to mess up the options, so we add them as untracked
+      newOption->addChildren({{ Framework::IndexedData::deepCopy(arena, missingChild) }}, isAutomated);
+    }
+  }
+}
+
+static Framework::IndexedData *
+addSavedStateIdOption(utils::bumpArena *arena, Framework::IndexedData *newOption, uuid savedId, u64 stateId)
+{
+  // this option points to some processor defined in the save file
+  // but because we haven't finished deserialising it might not exist yet
+  // for now we just copy the state_id defined in the save file
+  // and add this option to a list for a later fixup
+  // when the id of the deserialised processor in the current state will be assigned
+
+  auto *newChildOption = anew(arena, Framework::IndexedData, {});
+  newChildOption->id = savedId;
+  newChildOption->stateId = stateId;
+  newChildOption->flags = Framework::IndexedData::StateIdFlag;
+  newOption->addChildren({{ newChildOption }});
+
+  dynamicOptionFixups->emplaceBack(newChildOption);
+  return newChildOption;
+}
+
 static void handleIndexedData(utils::bumpArena *arena, bool isAutomated,
   Framework::ParameterDetails &details, cjson *indexedData)
 {
   // TODO: this adds duplicate options to IndexedData
   auto processSingle = [&](const auto &self, Framework::IndexedData &option, cjson *data) -> Framework::IndexedData *
   {
-    auto *newOption = anew(arena, Framework::IndexedData, { option });
-    // lose the reference to the original parent so that we don't increment its count
-    newOption->parent = nullptr;
-    // lose the reference to the original children because we'll add copies of them back in
-    newOption->children = nullptr;
-    // break up child connecitons otherwise we will be duplicating everything after the first entry
-    newOption->next = nullptr;
+    auto *newOption = copyOptionWithoutChildren(arena, option);
 
     cjson *children = cjson_GetObjectItem(data, "options");
     if (children)
@@ -272,20 +646,7 @@ static void handleIndexedData(utils::bumpArena *arena, bool isAutomated,
         // usually the option would not be present if it points to a processor (IndexedData::StateIdFlag)
         if (auto *stateIdEntry = cjson_GetObjectItem(value, "state_id"))
         {
-          // this option points to some processor defined in the save file
-          // but because we haven't finished deserialising it might not exist yet
-          // for now we just copy the state_id defined in the save file
-          // and add this option to a list for a later fixup
-          // when the id of the deserialised processor in the current state will be assigned
-
-          auto *newChildOption = anew(arena, Framework::IndexedData, {});
-          newChildOption->id = savedId;
-          newChildOption->stateId = stateIdEntry->vuint;
-          newChildOption->flags = Framework::IndexedData::StateIdFlag;
-          newOption->addChildren({{ newChildOption }});
-
-          dynamicOptionFixups->emplaceBack(newChildOption);
-
+          addSavedStateIdOption(arena, newOption, savedId, stateIdEntry->vuint);
           continue;
         }
 
@@ -294,25 +655,95 @@ static void handleIndexedData(utils::bumpArena *arena, bool isAutomated,
     }
 
     // second loop to add new/missing options from the save
-    for (auto missingChild = option.children; missingChild; missingChild = missingChild->next)
+    addMissingOptions(arena, isAutomated, option, newOption);
+
+    return *newOption;
+  };
+
+  details.options = processSingle(processSingle, *details.options, indexedData);
+  details.defaultOptionId = cjson_GetObjectItem(indexedData, "default_option_id")->vuint;
+}
+
+static void handleIndexedDataFromBinary(utils::bumpArena *arena, bool isAutomated,
+  Framework::ParameterDetails &details, BinaryReader &reader)
+{
+  // layout of every option: id, display name, value count, dynamic update uuid,
+  // state id flag (followed by the state id if set), children flag (followed by the children if set)
+  auto skipOptions = [&](const auto &self, u32 depth) -> void
+  {
+    if (depth > kMaxBinaryNesting)
+      return reader.fail();
+
+    u32 count = reader.read<u32>();
+    for (u32 i = 0; i < count && !reader.hasFailed; ++i)
     {
-      bool isPresent = false;
-      for (auto newChild = newOption->children; newChild; newChild = newChild->next)
-        if ((isPresent = (newChild->id == missingChild->id)))
+      (void)reader.read<uuid>();
+      (void)reader.readString();
+      (void)reader.read<u32>();
+      (void)reader.read<uuid>();
+      if (reader.read<u8>())
+        (void)reader.read<u64>();
+      if (reader.read<u8>())
+        self(self, depth + 1);
+    }
+  };
+
+  auto processSingle = [&](const auto &self, Framework::IndexedData &option,
+    bool hasChildren, u32 depth) -> Framework::IndexedData *
+  {
+    auto *newOption = copyOptionWithoutChildren(arena, option);
+    // failing makes the count read as 0
+    if (depth > kMaxBinaryNesting)
+      reader.fail();
+
+    u32 count = (hasChildren) ? reader.read<u32>() : 0;
+    for (u32 i = 0; i < count && !reader.hasFailed; ++i)
+    {
+      uuid savedId = reader.read<uuid>();
+      utils::string_view dataName = reader.readString();
+      u32 valueCount = reader.read<u32>();
+      // the dynamic update uuid is kept from the plugin's own option
+      (void)reader.read<uuid>();
+      bool hasStateId = reader.read<u8>();
+      u64 stateId = (hasStateId) ? reader.read<u64>() : 0;
+      bool hasSavedChildren = reader.read<u8>();
+
+      COMPLEX_ASSERT(savedId, "Option doesn't have an id so there's no way to identify it (this is really bad)");
+
+      auto *child = option.children;
+      for (; child; child = child->next)
+        if (child->id == savedId)
           break;
 
-      if (!isPresent)
+      if (child)
       {
-        // if the parameter is automated we don't want to mess up the options, so we add them as untracked
-        newOption->addChildren({{ Framework::IndexedData::deepCopy(arena, missingChild) }}, isAutomated);
+        auto *newChildOption = self(self, *child, hasSavedChildren, depth + 1);
+        if (dataName != newChildOption->displayName)
+          newChildOption->displayName = findOrAddPermanentString(dataName);
+        newChildOption->valueCount = valueCount;
+
+        newOption->addChildren({{ newChildOption }});
+        continue;
       }
+
+      // usually the option would not be present if it points to a processor (IndexedData::StateIdFlag)
+      if (hasStateId)
+        addSavedStateIdOption(arena, newOption, savedId, stateId);
+      else
+        COMPLEX_ASSERT_FALSE("Unhandled child option");
+
+      if (hasSavedChildren)
+        skipOptions(skipOptions, depth + 1);
     }
 
+    // second loop to add new/missing options from the save
+    addMissingOptions(arena, isAutomated, option, newOption);
+
     return *newOption;
   };
 
-  details.options = processSingle(processSingle, *details.options, indexedData);
-  details.defaultOptionId = cjson_GetObjectItem(indexedData, "default_option_id")->vuint;
+  details.defaultOptionId = reader.read<uuid>();
+  details.options = processSingle(processSingle, *details.options, true, 0);
 }
 
 static void fixDeserialisedProcessorsStateIds(Plugin::State *state)
@@ -339,61 +770,125 @@ static void fixDeserialisedProcessorsStateIds(Plugin::State *state)
 
 namespace Framework
 {
-  void ParameterValue::serialiseToJson(void *jsonData) const
+  void ParameterValue::applySavedRange(float minValue, float maxValue, bool isAutomated)
   {
-    cjson *data = (cjson *)jsonData;
-    cjson_AddTo(data, "id", cjson_Unsigned, details_.id);
-    cjson_AddTo(data, "display_name", cjson_String, details_.displayName.data());
-    cjson_AddTo(data, "value", cjson_Float, normalisedValue_);
-    cjson_AddTo(data, "scale", cjson_Unsigned, details_.scale);
-    cjson_AddTo(data, "is_stereo", cjson_Bool, (details_.flags & ParameterDetails::Stereo) != 0);
-    cjson_AddTo(data, "is_modulatable", cjson_Bool, (details_.flags & ParameterDetails::Modulatable) != 0);
-    cjson_AddTo(data, "is_extensible", cjson_Bool, (details_.flags & ParameterDetails::Extensible) != 0);
-    cjson_AddTo(data, "is_rounding_to_int", cjson_Bool, (details_.flags & ParameterDetails::RoundToInt) != 0);
+    float referenceMin = details_.minValue;
+    float referenceMax = details_.maxValue;
+
+    // if the save contains an expanded range but the parameter in this version isn't extensible
+    // then there's nothing we can do about it
+    if ((referenceMin > minValue || referenceMax < maxValue) &&
+      (details_.flags & ParameterDetails::Extensible) == 0)
+    {
+      //COMPLEX_ASSERT_FALSE();
+      // TODO: -inf db gets picked up by this condition which shouldn't happen
+      // TODO: log this
+    }
+
+    // bool changedMinMax = false;
+    if (referenceMin != minValue || referenceMax != maxValue)
+    {
+      // the range of the parameter was changed while being automated
+      // we mustn't change the range of the parameter otherwise we're going to ruin someone's project
+      if (isAutomated)
+      {
+        // if we're here then that means the range was changed but it's not larger than the range available
+        details_.minValue = minValue;
+        details_.maxValue = maxValue;
+        // changedMinMax = true;
+      }
+      else
+      {
+        minValue = referenceMin;
+        maxValue = referenceMax;
+      }
+
+      // always set min/max for dynamic indexed parameters,
+      // since it might be possible to check them at this time
+      if (details_.scale == ParameterScale::Indexed &&
+        (details_.flags & ParameterDetails::Extensible) != 0)
+      {
+        details_.minValue = minValue;
+        details_.maxValue = maxValue;
+        // changedMinMax = true;
+      }
+    }
+  }
+
+  void ParameterValue::applySavedValue(Generation::Processor *processor, float value, u64 automationSlot)
+  {
+    value = utils::clamp(value, 0.0f, 1.0f);
+    normalisedValue_ = value;
+    isDirty_ = true;
+    updateValue(processor->state->plugin->getSampleRate());
+
+    // paranoid check just in case
+    COMPLEX_ASSERT(normalisedValue_ == value);
+
+    if (automationSlot != u64(-1))
+    {
+      // if we don't have enough parameters then too bad, we only guarantee kMaxParameterMappings generic parameters
+      // TODO: report this to user
+      if (automationSlot < (u64)processor->state->parameterBridges.size())
+        processor->state->parameterBridges[automationSlot].resetParameterLink(getParameterLink(), true);
+    }
+  }
+
+  void ParameterValue::serialiseToJson(void *jsonWriter) const
+  {
+    auto &writer = *(JsonWriter *)jsonWriter;
+    writer.addUnsigned("id", details_.id);
+    writer.addString("display_name", details_.displayName.data());
+    writer.addFloat("value", normalisedValue_);
+    writer.addUnsigned("scale", details_.scale);
+    writer.addBool("is_stereo", (details_.flags & ParameterDetails::Stereo) != 0);
+    writer.addBool("is_modulatable", (details_.flags & ParameterDetails::Modulatable) != 0);
+    writer.addBool("is_extensible", (details_.flags & ParameterDetails::Extensible) != 0);
+    writer.addBool("is_rounding_to_int", (details_.flags & ParameterDetails::RoundToInt) != 0);
     if (parameterLink_.hostControl)
-      cjson_AddTo(data, "automation_slot", cjson_Unsigned, parameterLink_.hostControl->parameterIndex);
+      writer.addUnsigned("automation_slot", parameterLink_.hostControl->parameterIndex);
     if (details_.scale == ParameterScale::Indexed)
     {
-      auto recurseOptions = [&](const auto &self, cjson *optionData, IndexedData *option) -> void
+      auto recurseOptions = [&](const auto &self, IndexedData *option) -> void
       {
-        // this line is leaking technically at leaf nodes but because
-        cjson *children = cjson_Create(cjson_Array);
+        COMPLEX_ASSERT(option->children);
+
+        writer.beginArray("options");
         for (auto *child = option->children; child; child = child->next)
         {
-          cjson *childData = cjson_AddTo(children, nullptr, cjson_Object);
-          cjson_AddTo(childData, "id", cjson_Unsigned, child->id);
-          cjson_AddTo(childData, "display_name", cjson_String, child->displayName.data());
-          cjson_AddTo(childData, "children_count", cjson_Unsigned, child->childrenCount);
-          cjson_AddTo(childData, "value_count", cjson_Unsigned, child->valueCount);
+          writer.beginObject();
+          writer.addUnsigned("id", child->id);
+          writer.addString("display_name", child->displayName.data());
+          writer.addUnsigned("children_count", child->childrenCount);
+          writer.addUnsigned("value_count", child->valueCount);
 
-          if (child->dynamicUpdateUuid != uuid{})
-            cjson_AddTo(childData, "dynamic_update_uuid", cjson_Unsigned, child->dynamicUpdateUuid);
+          if (child->dynamicUpdateUuid)
+            writer.addUnsigned("dynamic_update_uuid", child->dynamicUpdateUuid);
 
           if (child->userFlags)
-            cjson_AddTo(childData, "user_flags", cjson_Unsigned, child->userFlags);
+            writer.addUnsigned("user_flags", child->userFlags);
 
-          if (child->flags == IndexedData::StateIdFlag)
-            cjson_AddTo(childData, "state_id", cjson_Unsigned, child->stateId);
+          if (child->flags == IndexedData::Flags::StateIdFlag)
+            writer.addUnsigned("state_id", child->stateId);
 
           if (child->children)
-            self(self, childData, child);
+            self(self, child);
+          writer.endObject();
         }
-
-        COMPLEX_ASSERT(option->children);
-        cjson_AddExistingTo(optionData, "options", children);
+        writer.endArray();
       };
 
-      cjson_AddTo(data, "min_value", cjson_Unsigned, (u64)0);
-      cjson_AddTo(data, "max_value", cjson_Unsigned, (u64)details_.options->valueCount);
-      cjson_AddTo(data, "default_option_id", cjson_Unsigned, details_.defaultOptionId);
-      recurseOptions(recurseOptions, data, details_.options);
+      writer.addUnsigned("min_value", 0);
+      writer.addUnsigned("max_value", details_.options->valueCount);
+      writer.addUnsigned("default_option_id", details_.defaultOptionId);
+      recurseOptions(recurseOptions, details_.options);
     }
     else
     {
-      cjson_AddTo(data, "min_value", cjson_Float, (double)details_.minValue);
-      cjson_AddTo(data, "max_value", cjson_Float, (double)details_.maxValue);
-      cjson_AddTo(data, "default_value", cjson_Float, (double)details_.defaultValue);
-      cjson_AddTo(data, "default_normalised_value", cjson_Float, (double)details_.defaultNormalisedValue);
+      writer.addFloat("min_value", details_.minValue);
+      writer.addFloat("max_value", details_.maxValue);
+      writer.addFloat("default_value", details_.defaultValue);
+      writer.addFloat("default_normalised_value", details_.defaultNormalisedValue);
     }
 
     // TODO: add modulators
@@ -446,106 +941,147 @@ namespace Framework
     {
       float minValue = (float)cjson_GetObjectItem(data, "min_value")->vdouble;
       float maxValue = (float)cjson_GetObjectItem(data, "max_value")->vdouble;
+      parameter->applySavedRange(minValue, maxValue, automationSlot != u64(-1));
+    }
+
+    // TODO: fit modulation here
 
-      float referenceMin = parameter->details_.minValue;
-      float referenceMax = parameter->details_.maxValue;
+    parameter->applySavedValue(processor, (float)cjson_GetObjectItem(data, "value")->vdouble, automationSlot);
 
-      // if the save contains an expanded range but the parameter in this version isn't extensible
-      // then there's nothing we can do about it
-      if ((referenceMin > minValue || referenceMax < maxValue) &&
-        (parameter->details_.flags & ParameterDetails::Extensible) == 0)
-      {
-        //COMPLEX_ASSERT_FALSE();
-        // TODO: -inf db gets picked up by this condition which shouldn't happen
-        // TODO: log this
-      }
+    return parameter;
+  }
 
-      // bool changedMinMax = false;
-      if (referenceMin != minValue || referenceMax != maxValue)
+  void ParameterValue::serialiseToBinary(void *writerData) const
+  {
+    auto &writer = *(BinaryWriter *)writerData;
+    writer.write(details_.id);
+    writer.write(normalisedValue_);
+    writer.write(details_.scale);
+    writer.write(details_.flags);
+    writer.write((parameterLink_.hostControl) ? (u64)parameterLink_.hostControl->parameterIndex : u64(-1));
+    if (details_.scale == ParameterScale::Indexed)
+    {
+      auto writeOptions = [&](const auto &self, IndexedData *option) -> void
       {
-        // the range of the parameter was changed while being automated
-        // we mustn't change the range of the parameter otherwise we're going to ruin someone's project
-        if (automationSlot != u64(-1))
-        {
-          // if we're here then that means the range was changed but it's not larger than the range available
-          parameter->details_.minValue = minValue;
-          parameter->details_.maxValue = maxValue;
-          // changedMinMax = true;
-        }
-        else
-        {
-          minValue = referenceMin;
-          maxValue = referenceMax;
-        }
+        u32 count = 0;
+        for (auto *child = option->children; child; child = child->next)
+          ++count;
 
-        // always set min/max for dynamic indexed parameters,
-        // since it might be possible to check them at this time
-        if (parameter->details_.scale == ParameterScale::Indexed &&
-          (parameter->details_.flags & ParameterDetails::Extensible) != 0)
+        writer.write(count);
+        for (auto *child = option->children; child; child = child->next)
         {
-          parameter->details_.minValue = minValue;
-          parameter->details_.maxValue = maxValue;
-          // changedMinMax = true;
+          writer.write(child->id);
+          writer.writeString(child->displayName);
+          writer.write(child->valueCount);
+          writer.write(child->dynamicUpdateUuid);
+          writer.write((u8)(child->flags == IndexedData::Flags::StateIdFlag));
+          if (child->flags == IndexedData::Flags::StateIdFlag)
+            writer.write(child->stateId);
+          writer.write((u8)(child->children != nullptr));
+          if (child->children)
+            self(self, child);
         }
-      }
+      };
+
+      writer.write(details_.defaultOptionId);
+      writeOptions(writeOptions, details_.options);
+    }
+    else
+    {
+      writer.write(details_.minValue);
+      writer.write(details_.maxValue);
+      writer.write(details_.defaultValue);
+      writer.write(details_.defaultNormalisedValue);
     }
+  }
 
-    // TODO: fit modulation here
+  ParameterValue *
+  ParameterValue::deserialiseFromBinary(Generation::Processor *processor, void *readerData,
+    ParameterDetails &reference, ParameterValue *memory)
+  {
+    COMPLEX_ASSERT(memory);
 
-    float value = utils::clamp((float)cjson_GetObjectItem(data, "value")->vdouble, 0.0f, 1.0f);
-    parameter->normalisedValue_ = value;
-    parameter->isDirty_ = true;
-    parameter->updateValue(processor->state->plugin->getSampleRate());
+    // the id was already read to find the reference
+    auto *parameter = new (memory) ParameterValue{ reference };
+    auto &reader = *(BinaryReader *)readerData;
 
-    // paranoid check just in case
-    COMPLEX_ASSERT(parameter->normalisedValue_ == value);
+    float value = reader.read<float>();
+    auto scale = reader.read<ParameterScale::Value>();
+    u32 flags = reader.read<u32>();
+    u64 automationSlot = reader.read<u64>();
 
-    if (automationSlot != u64(-1))
+    if (parameter->details_.scale != scale)
     {
-      // if we don't have enough parameters then too bad, we only guarantee kMaxParameterMappings generic parameters
-      // TODO: report this to user
-      if (automationSlot < (u64)processor->state->parameterBridges.size())
-        processor->state->parameterBridges[automationSlot].resetParameterLink(parameter->getParameterLink(), true);
+      // the rest of the entry is laid out for a different scale, it gets skipped by the caller
+      COMPLEX_ASSERT_FALSE();
+      // TODO: log this
+      return parameter;
     }
 
+    parameter->details_.flags &= ~ParameterDetails::RoundToInt;
+    parameter->details_.flags |= flags & ParameterDetails::RoundToInt;
+
+    COMPLEX_ASSERT((flags & ParameterDetails::Stereo) == (parameter->details_.flags & ParameterDetails::Stereo));
+
+    if (parameter->details_.scale == ParameterScale::Indexed)
+    {
+      handleIndexedDataFromBinary(processor->arena, automationSlot != u64(-1), parameter->details_, reader);
+      processor->state->registerDynamicParameter(parameter);
+    }
+    else
+    {
+      float minValue = reader.read<float>();
+      float maxValue = reader.read<float>();
+      parameter->applySavedRange(minValue, maxValue, automationSlot != u64(-1));
+    }
+
+    // TODO: fit modulation here
+
+    parameter->applySavedValue(processor, value, automationSlot);
+
     return parameter;
   }
 }
 
 namespace Generation
 {
-  void Processor::serialiseToJson(void *jsonData, utils::span<Framework::ParameterValue *> parametersToSerialise) const
+  void Processor::serialiseToJson(void *jsonWriter, utils::span<Framework::ParameterValue *> parametersToSerialise) const
   {
-    cjson *processorInfo = (cjson *)jsonData;
-    cjson_AddTo(processorInfo, "id", cjson_Unsigned, metadata->id);
-    cjson_AddTo(processorInfo, "state_id", cjson_Unsigned, stateId);
+    auto &writer = *(JsonWriter *)jsonWriter;
+    writer.addUnsigned("id", metadata->id);
+    writer.addUnsigned("state_id", stateId);
     if (!name.empty())
-      cjson_AddTo(processorInfo, "name", cjson_String, name.data());
+      writer.addString("name", name.data());
 
-    cjson *serialisedChildren = cjson_AddTo(processorInfo, "processors", cjson_Array);
+    writer.beginArray("processors");
     for (auto *child = children; child; child = child->next)
     {
-      cjson *subProcessorData = cjson_AddTo(serialisedChildren, nullptr, cjson_Object);
-      child->serialiseToJson(subProcessorData);
+      writer.beginObject();
+      child->serialiseToJson(&writer);
+      writer.endObject();
     }
+    writer.endArray();
 
-    cjson *serialisedParameters = cjson_AddTo(processorInfo, "parameters", cjson_Array);
+    writer.beginArray("parameters");
     if (parametersToSerialise.empty())
     {
       for (auto *parameter = parameters; parameter; parameter = parameter->next)
       {
-        cjson *parameterData = cjson_AddTo(serialisedParameters, nullptr, cjson_Object);
-        parameter->serialiseToJson(parameterData);
+        writer.beginObject();
+        parameter->serialiseToJson(&writer);
+        writer.endObject();
       }
     }
     else
     {
       for (auto &parameter : parametersToSerialise)
       {
-        cjson *parameterData = cjson_AddTo(serialisedParameters, nullptr, cjson_Object);
-        parameter->serialiseToJson(parameterData);
+        writer.beginObject();
+        parameter->serialiseToJson(&writer);
+        writer.endObject();
       }
     }
+    writer.endArray();
   }
 
   void deserialiseParametersFromJson(void *jsonData, Framework::ProcessorMetadata *metadata,
@@ -670,12 +1206,188 @@ namespace Generation
 
     errorPath->removeLast(newSize - oldSize);
   }
+
+  void serialiseParametersToBinary(void *writerData, utils::span<Framework::ParameterValue *> parametersToSerialise)
+  {
+    auto &writer = *(BinaryWriter *)writerData;
+    writer.write((u32)parametersToSerialise.size());
+    for (auto *parameter : parametersToSerialise)
+    {
+      usize start = writer.beginSized();
+      parameter->serialiseToBinary(&writer);
+      writer.endSized(start);
+    }
+  }
+
+  void Processor::serialiseToBinary(void *writerData, utils::span<Framework::ParameterValue *> parametersToSerialise) const
+  {
+    auto &writer = *(BinaryWriter *)writerData;
+    writer.write(metadata->id);
+    writer.write(stateId);
+    writer.writeString(name);
+
+    if (!parametersToSerialise.empty())
+    {
+      serialiseParametersToBinary(&writer, parametersToSerialise);
+      return;
+    }
+
+    auto allParameters = utils::vector<Framework::ParameterValue *>{ getLocalScratch(), parameterCount };
+    for (auto *parameter = parameters; parameter; parameter = parameter->next)
+      allParameters.emplaceBack(parameter);
+    serialiseParametersToBinary(&writer, allParameters);
+  }
+
+  void deserialiseParametersFromBinary(void *readerData, Framework::ProcessorMetadata *metadata,
+    Framework::ParameterValue *&parameters, Processor *processor, bool validateParameters)
+  {
+    auto &reader = *(BinaryReader *)readerData;
+
+    auto *memory = arranew(processor->arena, Framework::ParameterValue, metadata->parametersCount, {});
+    auto *isDeserialised = arranew(jsonArena, bool, metadata->parametersCount, {});
+
+    // entries can be in any order, so they're placed at the index of their parameter in the metadata
+    u32 savedCount = reader.read<u32>();
+    for (u32 i = 0; i < savedCount && !reader.hasFailed; ++i)
+    {
+      u32 entrySize = reader.read<u32>();
+      usize entryEnd = reader.position + entrySize;
+      uuid id = reader.read<uuid>();
+
+      usize index = 0;
+      auto *expectedParameter = metadata->parameters;
+      for (; expectedParameter; (expectedParameter = expectedParameter->next), ++index)
+        if (expectedParameter->details.id == id)
+          break;
+
+      if (expectedParameter && !isDeserialised[index])
+      {
+        Framework::ParameterValue::deserialiseFromBinary(processor,
+          &reader, expectedParameter->details, memory + index);
+        isDeserialised[index] = true;
+      }
+      else if (!expectedParameter && validateParameters)
+      {
+        auto errorString = utils::string::create(getLocalScratch(),
+          "%v\nUnexpected parameter (%zu).", utils::string_view{ *errorPath }, id);
+        Interface::showNativeMessageBox("Error opening preset", errorString.data(), Interface::MessageBoxType::Warning);
+      }
+
+      reader.seek(entryEnd);
+    }
+
+    auto insertParameter = [&](auto *parameter)
+    {
+      if (parameters)
+      {
+        parameters->previous->next = parameter;
+        parameter->previous = parameters->previous;
+        parameters->previous = parameter;
+      }
+      else
+      {
+        parameter->previous = parameter;
+        parameters = parameter;
+      }
+    };
+
+    usize index = 0;
+    for (auto *expectedParameter = metadata->parameters;
+      expectedParameter; (expectedParameter = expectedParameter->next), ++index)
+    {
+      if (!isDeserialised[index])
+      {
+        auto errorString = utils::string::create(getLocalScratch(),
+          "%v\nMissing Parameter %v (%zu), replacing with a default initialised one.",
+          utils::string_view{ *errorPath }, expectedParameter->details.displayName, expectedParameter->details.id);
+        Interface::showNativeMessageBox("Error opening preset", errorString.data(), Interface::MessageBoxType::Warning);
+
+        new (memory + index) Framework::ParameterValue{ expectedParameter->details };
+      }
+
+      insertParameter(memory + index);
+    }
+  }
+
+  void deserialiseParameters(void *serialisedSave, Framework::ProcessorMetadata *metadata,
+    Framework::ParameterValue *&parameters, Processor *processor, bool validateParameters)
+  {
+    if (serialisedSave == binaryReader)
+      deserialiseParametersFromBinary(serialisedSave, metadata, parameters, processor, validateParameters);
+    else
+      deserialiseParametersFromJson(serialisedSave, metadata, parameters, processor, validateParameters);
+  }
+
+  void Processor::deserialiseFromBinary(void *readerData)
+  {
+    auto oldSize = errorPath->size();
+    errorPath->appendFormat("Inside processor %v (%zu):\n", metadata->name, metadata->id);
+    auto newSize = errorPath->size();
+
+    auto &reader = *(BinaryReader *)readerData;
+    // the processor id was read before creating it, id fixup will happen later when deserialisation has finished
+    const_cast<u64 &>(stateId) = reader.read<u64>();
+    if (auto savedName = reader.readString(); !savedName.empty())
+      name = { arena, savedName.data(), savedName.size() };
+
+    parameterCount = (u32)metadata->parametersCount;
+    deserialiseParametersFromBinary(&reader, metadata, parameters, this,
+      (metadata->flags & Framework::ProcessorMetadata::NoParameterValidationTag) == 0);
+
+    errorPath->removeLast(newSize - oldSize);
+  }
+
+  void Processor::deserialise(void *serialisedSave)
+  {
+    if (serialisedSave == binaryReader)
+      deserialiseFromBinary(serialisedSave);
+    else
+      deserialiseFromJson(serialisedSave);
+  }
+
+  static void serialiseProcessorTreeToBinary(BinaryWriter &writer, const Processor *processor)
+  {
+    processor->serialiseToBinary(&writer);
+    writer.write(processor->childrenCount);
+    for (auto *child = processor->children; child; child = child->next)
+      serialiseProcessorTreeToBinary(writer, child);
+  }
+
+  static void deserialiseProcessorChildrenFromBinary(BinaryReader &reader, Processor *parent, u32 depth = 0)
+  {
+    if (depth > kMaxBinaryNesting)
+      return reader.fail();
+
+    auto oldSize = errorPath->size();
+    errorPath->appendFormat("Inside processor %v (%zu):\n", parent->metadata->name, parent->metadata->id);
+    auto newSize = errorPath->size();
+
+    u32 count = reader.read<u32>();
+    for (u32 i = 0; i < count && !reader.hasFailed; ++i)
+    {
+      uuid subProcessorsId = reader.read<uuid>();
+      if (reader.hasFailed)
+        break;
+
+      Generation::Processor *subProcessor = parent->state->createProcessor(subProcessorsId, &reader);
+      // a processor that can't go here would be left without a parent, so the save counts as corrupted
+      if (!parent->addChildProcessor(*subProcessor))
+      {
+        reader.fail();
+        break;
+      }
+      parent->state->registerProcessorForDynamicParameters(subProcessor);
+      deserialiseProcessorChildrenFromBinary(reader, subProcessor, depth + 1);
+    }
+
+    errorPath->removeLast(newSize - oldSize);
+  }
 }
 
 
 namespace Plugin
 {
-  void serialiseToJson(State *state, void *jsonData)
+  void serialiseToJson(State *state, void *jsonWriter)
   {
     utils::vector<Generation::Processor *> topLevelProcessors{ getLocalScratch(), 16 };
     for (auto &[id, processor] : state->allProcessors.data)
@@ -684,15 +1396,38 @@ namespace Plugin
 
     COMPLEX_ASSERT(!topLevelProcessors.empty());
 
-    cjson *data = (cjson *)jsonData;
-    cjson_AddTo(data, "version", cjson_String, CPLUG_PLUGIN_VERSION);
-    cjson *topLevelProcessorsSerialised = cjson_AddTo(data, "tree", cjson_Array);
+    auto &writer = *(JsonWriter *)jsonWriter;
+    writer.beginObject();
+    writer.addString("version", CPLUG_PLUGIN_VERSION);
+    writer.beginArray("tree");
 
     for (auto &topLevelProcessor : topLevelProcessors)
     {
-      cjson *topLevelData = cjson_AddTo(topLevelProcessorsSerialised, nullptr, cjson_Object);
-      topLevelProcessor->serialiseToJson(topLevelData);
+      writer.beginObject();
+      topLevelProcessor->serialiseToJson(&writer);
+      writer.endObject();
     }
+
+    writer.endArray();
+    writer.endObject();
+  }
+
+  void serialiseToBinary(State *state, BinaryWriter &writer)
+  {
+    utils::vector<Generation::Processor *> topLevelProcessors{ getLocalScratch(), 16 };
+    for (auto &[id, processor] : state->allProcessors.data)
+      if (!processor->parent)
+        topLevelProcessors.emplaceBack(processor);
+
+    COMPLEX_ASSERT(!topLevelProcessors.empty());
+
+    writer.write(kBinaryStateMagic);
+    writer.write(kBinaryStateVersion);
+    writer.writeString(CPLUG_PLUGIN_VERSION);
+    writer.write((u32)topLevelProcessors.size());
+
+    for (auto &topLevelProcessor : topLevelProcessors)
+      Generation::serialiseProcessorTreeToBinary(writer, topLevelProcessor);
   }
 
   static void checkForDynamicParameters(Plugin::State *state, Generation::Processor *processor)
@@ -732,6 +1467,15 @@ namespace Plugin
     return state;
   }
 
+  static void finishDeserialisation(State *state)
+  {
+    fixDeserialisedProcessorsStateIds(state);
+    for (auto &id : Framework::ParameterChangeReason::values)
+      state->updateDynamicParameters(id);
+
+    Framework::ParameterBridge::notifyParameterChange();
+  }
+
   utils::sp<State>
   deserialiseFromJson(ComplexPlugin *plugin, void *newSave)
   {
@@ -758,74 +1502,111 @@ namespace Plugin
     state->registerProcessorForDynamicParameters(state->soundEngine);
     Generation::deserialiseProcessorChildren(soundEngineJson, state->soundEngine);
 
-    fixDeserialisedProcessorsStateIds(state.get());
-    for (auto &id : Framework::ParameterChangeReason::values)
-      state->updateDynamicParameters(id);
-
-    Framework::ParameterBridge::notifyParameterChange();
+    finishDeserialisation(state.get());
 
     return state;
   }
 
-  void saveState(ComplexPlugin *plugin, const void *stateCtx, cplug_writeProc writeProc)
+  utils::sp<State>
+  deserialiseFromBinary(ComplexPlugin *plugin, BinaryReader &reader)
   {
-    if (!plugin->state_)
-      return;
+    // magic was checked to pick this format
+    (void)reader.read<u32>();
+    u32 formatVersion = reader.read<u32>();
+    if (formatVersion > kBinaryStateVersion)
+    {
+      Interface::showNativeMessageBox("Error opening preset",
+        "Preset was saved by a newer version of the plugin.", Interface::MessageBoxType::Error);
+      return nullptr;
+    }
 
-    Interface::getUiRelated() = &plugin->renderer.generalData;
-    defer{ Interface::getUiRelated() = nullptr; };
+    // the plugin version is only informative for now, upgrades are keyed on the format version
+    (void)reader.readString();
 
-    jsonArena = utils::bumpArena::createNested(getLocalScratch(), COMPLEX_KB(128));
+    auto state = utils::sp<State>::create(plugin);
 
-    cjson *data = cjson_Create(cjson_Object);
-    serialiseToJson(plugin->state_.get(), data);
-    usize size = 0;
-    char *dataString = cjson_Print(data, &size, true);
-    writeProc(stateCtx, dataString, size);
+    utils::string errorPath_{ jsonArena, 64 };
+    errorPath = &errorPath_;
 
-    utils::bumpArena::destroy(jsonArena);
-    jsonArena = nullptr;
-  }
+    utils::vector<Framework::IndexedData *> dynamicParameterFixups_{ jsonArena, 64 };
+    dynamicOptionFixups = &dynamicParameterFixups_;
 
-  struct PresetUpdate final : public Framework::UndoAction
-  {
-    PresetUpdate(Plugin::ComplexPlugin &plugin, utils::sp<Plugin::State> newSavedState) :
-      plugin(plugin), state{ COMPLEX_MOVE(newSavedState) }
-    {
-      redo = [](UndoAction *a)
-      {
-        auto *self = (PresetUpdate *)a;
+    binaryReader = &reader;
+    defer{ binaryReader = nullptr; };
 
-        auto g = self->state->plugin->acquireProcessingLock();
-        auto oldState = self->plugin.exchangeStates(COMPLEX_MOVE(self->state));
-        self->state = COMPLEX_MOVE(oldState);
-      };
+    // only the first top level processor is loaded, so anything after it isn't read
+    u32 topLevelCount = reader.read<u32>();
+    uuid type = reader.read<uuid>();
+    if (topLevelCount == 0 || type != Generation::Processors::SoundEngine)
+    {
+      Interface::showNativeMessageBox("Error opening preset",
+        "SoundEngine type doesn't match.", Interface::MessageBoxType::Error);
+      return nullptr;
+    }
 
-      undo = [](UndoAction *a)
-      {
-        auto *self = (PresetUpdate *)a;
+    state->soundEngine = (Generation::SoundEngine *)state->createProcessor(
+      Generation::Processors::SoundEngine, &reader);
+    state->registerProcessorForDynamicParameters(state->soundEngine);
+    Generation::deserialiseProcessorChildrenFromBinary(reader, state->soundEngine);
 
-        auto g = self->state->plugin->acquireProcessingLock();
-        auto newState = self->plugin.exchangeStates(COMPLEX_MOVE(self->state));
-        self->state = COMPLEX_MOVE(newState);
-      };
+    if (reader.hasFailed)
+    {
+      Interface::showNativeMessageBox("Error opening preset",
+        "Preset data is truncated or corrupted.", Interface::MessageBoxType::Error);
+      return nullptr;
     }
 
-    Plugin::ComplexPlugin &plugin;
-    utils::sp<Plugin::State> state;
-  };
+    finishDeserialisation(state.get());
 
-  void loadState(ComplexPlugin *plugin, utils::string_view data)
+    return state;
+  }
+
+  void saveState(ComplexPlugin *plugin, const void *stateCtx, cplug_writeProc writeProc, bool asJson)
   {
-    bool wasStateInitialised = plugin->wasStateInitialised;
-    plugin->wasStateInitialised = true;
+    // a preset that's still loading needs to be saved instead of the one it's replacing
+    plugin->stateLoader = utils::thread{};
+    plugin->installLoadedState();
 
-    utils::sp<State> state{};
+    if (!plugin->state_)
+      return;
 
     Interface::getUiRelated() = &plugin->renderer.generalData;
     defer{ Interface::getUiRelated() = nullptr; };
 
-    if (data.size() != 0)
+    if (!asJson)
+    {
+      BinaryWriter writer{ .bytes = { getLocalScratch(), BinaryWriter::kFlushSize + COMPLEX_KB(1) },
+        .stateCtx = stateCtx, .writeProc = writeProc };
+      serialiseToBinary(plugin->state_.get(), writer);
+      writer.flush();
+      return;
+    }
+
+    JsonWriter writer{ .stateCtx = stateCtx, .writeProc = writeProc };
+    serialiseToJson(plugin->state_.get(), &writer);
+    writer.flush();
+  }
+
+  static utils::sp<State>
+  deserialiseState(ComplexPlugin *plugin, utils::string_view data)
+  {
+    utils::sp<State> state{};
+
+    u32 magic = 0;
+    if (data.size() >= sizeof(magic))
+      ::memcpy(&magic, data.data(), sizeof(magic));
+
+    if (magic == kBinaryStateMagic)
+    {
+      // the json state arena also backs the temporary data of binary loading
+      jsonArena = utils::bumpArena::createNested(getLocalScratch(), COMPLEX_KB(128));
+      BinaryReader reader{ .bytes = data };
+      state = deserialiseFromBinary(plugin, reader);
+
+      utils::bumpArena::destroy(jsonArena);
+      jsonArena = nullptr;
+    }
+    else if (data.size() != 0)
     {
       jsonArena = utils::bumpArena::createNested(getLocalScratch(), COMPLEX_KB(128));
       const char *potentialError = nullptr;
@@ -848,21 +1629,192 @@ namespace Plugin
     if (!state)
       state = plugin->loadDefaultPreset();
 
+    // processor arenas are created with kProcessorArenaPageFlags,
+    // so all of their buffers are already prefaulted by the time we get here
     auto [minOrder, maxOrder] = state->soundEngine->getMinMaxFFTOrder();
     state->fft = plugin->getFFTConverter(minOrder, maxOrder);
 
+    return state;
+  }
+
+  static void showCurrentState(ComplexPlugin *plugin)
+  {
+    auto *newGui = plugin->state_->gui;
+    plugin->renderer.resetGui(newGui);
+
+    newGui->restartUI(plugin->state_.get());
+  }
+
+  // instead of keeping the whole replaced state (with all of its processors and buffers) alive,
+  // only its binary save is kept and the state is rebuilt from it when undone/redone
+  struct PresetUpdate final : public Framework::UndoAction
+  {
+    PresetUpdate(Plugin::ComplexPlugin &plugin, utils::sp<Plugin::State> newState) :
+      plugin(plugin), pendingState{ COMPLEX_MOVE(newState) }
+    {
+      redo = [](UndoAction *a) { ((PresetUpdate *)a)->exchangeWithSaved(); };
+      undo = [](UndoAction *a) { ((PresetUpdate *)a)->exchangeWithSaved(); };
+      destructor = [](UndoAction *a)
+      {
+        auto *self = (PresetUpdate *)a;
+        self->pendingState = nullptr;
+        if (self->savedState)
+          utils::deallocate(self->savedState);
+        self->savedState = nullptr;
+        self->heldBytes = 0;
+      };
+    }
+
+    void
+    exchangeWithSaved()
+    {
+      // the state going in is only built on the first redo
+      auto incomingState = (pendingState) ? COMPLEX_MOVE(pendingState) :
+        deserialiseState(&plugin, { (const char *)savedState, heldBytes });
+
+      BinaryWriter writer{ .bytes = { getLocalScratch(), COMPLEX_KB(16) } };
+      serialiseToBinary(plugin.state_.get(), writer);
+
+      if (savedState)
+        utils::deallocate(savedState);
+      savedState = (u8 *)utils::allocate(writer.bytes.size(), alignof(u64));
+      ::memcpy(savedState, writer.bytes.data(), writer.bytes.size());
+      heldBytes = writer.bytes.size();
+
+      // the outgoing state is kept by the plugin until its crossfade is done
+      (void)plugin.exchangeStates(COMPLEX_MOVE(incomingState));
+      showCurrentState(&plugin);
+    }
+
+    Plugin::ComplexPlugin &plugin;
+    utils::sp<Plugin::State> pendingState;
+    u8 *savedState = nullptr;
+  };
+
+  static void installState(ComplexPlugin *plugin, utils::sp<State> state, bool wasStateInitialised)
+  {
     if (wasStateInitialised && plugin->state_.get())
     {
       auto *storage = plugin->undoManager.beginNewTransaction();
       plugin->undoManager.perform(anew(storage, PresetUpdate,
         { *plugin, COMPLEX_MOVE(state) }));
+      return;
     }
+
+    if (plugin->state_.get())
+      (void)plugin->exchangeStates(COMPLEX_MOVE(state));
     else
+    {
       plugin->state_ = COMPLEX_MOVE(state);
+      plugin->publishState();
+    }
 
-    auto *newGui = plugin->state_->gui;
-    plugin->renderer.resetGui(newGui);
+    showCurrentState(plugin);
+  }
 
-    newGui->restartUI(plugin->state_.get());
+  void ComplexPlugin::installLoadedState()
+  {
+    if (!hasLoadedState.exchange(false, satomi::memory_order_acquire))
+      return;
+
+    // this can be called from inside the ui's own event handling
+    auto *uiRelated = Interface::getUiRelated();
+    Interface::getUiRelated() = &renderer.generalData;
+    defer{ Interface::getUiRelated() = uiRelated; };
+
+    installState(this, COMPLEX_MOVE(loadedState_), loadedWasInitialised_);
+
+    if (!loadMessages_.empty())
+    {
+      Interface::showNativeMessageBox("Loading preset", loadMessages_.data(), loadMessagesType_);
+      loadMessages_.clear();
+    }
+  }
+
+  void loadState(ComplexPlugin *plugin, utils::string_view data)
+  {
+    bool wasStateInitialised = plugin->wasStateInitialised;
+    plugin->wasStateInitialised = true;
+
+    // nothing can be processing before the first state exists, so it's built right away
+    if (!plugin->state_)
+    {
+      Interface::getUiRelated() = &plugin->renderer.generalData;
+      defer{ Interface::getUiRelated() = nullptr; };
+
+      installState(plugin, deserialiseState(plugin, data), wasStateInitialised);
+      return;
+    }
+
+    // a load requested before this one is installed first, so that they're applied in the order of the requests
+    plugin->stateLoader = utils::thread{};
+    plugin->installLoadedState();
+
+    // the caller frees the data as soon as we return
+    char *dataCopy = nullptr;
+    if (data.size())
+    {
+      dataCopy = (char *)utils::allocate(data.size(), alignof(u64));
+      ::memcpy(dataCopy, data.data(), data.size());
+    }
+
+    // only building the state happens off the calling thread, installing it (undo step, crossfade, gui, host rescan)
+    // is left to the main thread through installLoadedState
+    plugin->stateLoader = [plugin, dataCopy, size = data.size(), wasStateInitialised]()
+    {
+      Interface::getUiRelated() = &plugin->renderer.generalData;
+      defer{ Interface::getUiRelated() = nullptr; };
+
+      Interface::DeferredMessageBoxes messageBoxes{ .messages = &plugin->loadMessages_ };
+      Interface::getDeferredMessageBoxes() = &messageBoxes;
+      defer{ Interface::getDeferredMessageBoxes() = nullptr; };
+
+      auto state = deserialiseState(plugin, { dataCopy, size });
+      if (dataCopy)
+        utils::deallocate(dataCopy);
+
+      plugin->loadedState_ = COMPLEX_MOVE(state);
+      plugin->loadMessagesType_ = messageBoxes.type;
+      plugin->loadedWasInitialised_ = wasStateInitialised;
+      plugin->hasLoadedState.store(true, satomi::memory_order_release);
+    };
+  }
+
+  void loadStateImmediately(ComplexPlugin *plugin, utils::string_view data)
+  {
+    // a load that's still in flight or waiting to be installed would otherwise replace this state
+    plugin->stateLoader = utils::thread{};
+    if (plugin->hasLoadedState.exchange(false, satomi::memory_order_acquire))
+    {
+      plugin->loadedState_ = nullptr;
+      plugin->loadMessages_.clear();
+    }
+    plugin->wasStateInitialised = true;
+
+    Interface::getUiRelated() = &plugin->renderer.generalData;
+    defer{ Interface::getUiRelated() = nullptr; };
+
+    auto state = deserialiseState(plugin, data);
+    // orders outside the current range are built in the background, until then blocks
+    // would be transformed at the closest available size, so we wait for them here
+    plugin->fft.builder_ = utils::thread{};
+
+    utils::sp<State> retiringState{};
+    {
+      auto guard = plugin->acquireProcessingLock(true);
+      plugin->state_.swap(state);
+      plugin->publishState();
+
+      // there's nothing to fade out from
+      retiringState = COMPLEX_MOVE(plugin->retiringState_);
+      plugin->fadingState = nullptr;
+    }
+
+    // the state that was current until now is released right away, so it has to outlive 2 flips here
+    (void)plugin->waitForHostReaders();
+    (void)plugin->waitForHostReaders();
+
+    // the gui is switched before the previous states (and their guis) are released
+    showCurrentState(plugin);
   }
 }
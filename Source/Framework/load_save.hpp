@@ -19,7 +19,8 @@ namespace Framework
     // returns absolute window dimensions
     void getWindowSizeScale(u32 &windowWidth, u32 &windowHeight, float &windowScale);
     i32 getModuleWidth();
-    void getStartupParameters(usize &parameterMappings, usize &inSidechains, usize &outSidechains, usize &undoSteps);
+    void getStartupParameters(usize &parameterMappings, usize &inSidechains, usize &outSidechains,
+      usize &undoSteps, usize &undoHistoryBudget, bool &isLowLatency, bool &isRenderingOffline);
 
     void saveWindowSizeScale(u32 windowWidth, u32 windowHeight, float windowScale);
     void saveParameterMappings(usize parameterMappings);
@@ -62,9 +62,22 @@ namespace utils
       };
     };
 
+    // how the pages backing the arena are treated
+    // applied to the initial range on creation and to every range committed afterwards
+    enum PageFlags : u8
+    {
+      // fault in pages as soon as they're committed so that first use doesn't trap (i.e. on the audio thread)
+      PrefaultPages = 1 << 0,
+      // pin pages in physical memory, implies PrefaultPages
+      LockPages = 1 << 1,
+      // back the range with huge pages where possible
+      HugePages = 1 << 2,
+    };
+
     satomi::atomic<bool> lock{};
     bool threadSafe = true;
     u8 flags{};
+    u8 pageFlags{};
 
     // reserved and committed sizes stored are size - 1 to be able to represent up to 4 GB
     // but otherwise every other index represents its actual value
@@ -90,45 +103,77 @@ namespace utils
       return node->size - sizeof(bumpArena::node);
     }
 
-    [[nodiscard]] static byte *insert(bumpArena *arena, usize size, usize alignment, bool clean = false);
+    // call site locations are only used for audio thread instrumentation, see AudioThreadGuard
+    [[nodiscard]] static byte *insert(bumpArena *arena, usize size, usize alignment, bool clean = false,
+      sourceLocation location = sourceLocation::current());
     [[nodiscard]] static forceinline byte *
-    insert(const void *data, usize size, usize alignment, bool clean = false)
+    insert(const void *data, usize size, usize alignment, bool clean = false,
+      sourceLocation location = sourceLocation::current())
     {
-      return insert(fromAllocation(data), size, alignment, clean);
+      return insert(fromAllocation(data), size, alignment, clean, location);
     }
-    static void remove(const void *data);
-    [[nodiscard]] static byte *resize(const void *data, usize newSize, bool cleanNewSpace = false);
+    static void remove(const void *data, sourceLocation location = sourceLocation::current());
+    [[nodiscard]] static byte *resize(const void *data, usize newSize, bool cleanNewSpace = false,
+      sourceLocation location = sourceLocation::current());
     static void shrinkToFit(bumpArena *arena, bool shrinkToCommitted);
+    // applies PageFlags to an already committed range
+    static void preparePages(void *memory, usize size, u8 pageFlags);
+    // whether the arena or any arena it's nested in pins its pages
+    static bool hasLockedPages(bumpArena *arena);
 
     [[nodiscard]] static forceinline bumpArena *
-    create(usize reservedSize = COMPLEX_MB(64), usize commitSize = COMPLEX_KB(64))
+    create(usize reservedSize = COMPLEX_MB(64), usize commitSize = COMPLEX_KB(64), u8 pageFlags = 0)
     {
       reservedSize = utils::clamp(reservedSize, sizeof(bumpArena), usize(u32(-1)) + 1);
       commitSize = utils::clamp(commitSize, sizeof(bumpArena), reservedSize);
 
       byte *memory = reserveMemory(reservedSize);
+      // huge pages need to be requested for the whole reservation before anything is faulted in
+      if (pageFlags & HugePages)
+        adviseHugePages(memory, reservedSize);
       commitMemory(memory, commitSize);
+      preparePages(memory, commitSize, pageFlags & ~HugePages);
 
       (void)new(memory + sizeof(bumpArena)) node{ .size = (u32)(commitSize - sizeof(bumpArena)) };
 
-      return new(memory) bumpArena{ .reservedSize = (u32)(reservedSize - 1),
-        .committedSize = (u32)(commitSize - 1), .freeNodeStart = (u32)sizeof(bumpArena), 
+      return new(memory) bumpArena{ .pageFlags = pageFlags, .reservedSize = (u32)(reservedSize - 1),
+        .committedSize = (u32)(commitSize - 1), .freeNodeStart = (u32)sizeof(bumpArena),
         .lastUsedNode = (u32)sizeof(bumpArena) };
     }
     template<typename T>
     [[nodiscard]] static forceinline bumpArena *
-    createNested(T *differentArena, usize allocateSize) requires requires { T::insert(differentArena, usize(0), usize(0)); }
+    createNested(T *differentArena, usize allocateSize, u8 pageFlags = 0) requires requires { T::insert(differentArena, usize(0), usize(0)); }
     {
       allocateSize = utils::min(allocateSize + sizeof(bumpArena), usize(u32(-1)) + 1);
+      usize alignment = alignof(bumpArena);
+
+      // locks don't nest, the first munlock of a page unpins it for everyone
+      // so inside an arena that already pins its pages we leave locking to it,
+      // otherwise the arena gets whole pages to itself that no neighbour can unpin (or leave pinned)
+      if (pageFlags & LockPages)
+      {
+        bool isLockedByParent = false;
+        if constexpr (utils::is_same_v<T, bumpArena>)
+          isLockedByParent = hasLockedPages(differentArena);
+
+        if (isLockedByParent)
+          pageFlags = (u8)((pageFlags & ~LockPages) | PrefaultPages);
+        else
+        {
+          alignment = getPageSize();
+          allocateSize = utils::roundUpToMultiple(allocateSize, alignment);
+        }
+      }
 
-      byte *memory = T::insert(differentArena, allocateSize, alignof(bumpArena));
+      byte *memory = T::insert(differentArena, allocateSize, alignment);
+      preparePages(memory, allocateSize, pageFlags);
       (void)new(memory + sizeof(bumpArena)) node{ .size = (u32)(allocateSize - sizeof(bumpArena)) };
 
       u8 flags = (u8)T::type;
 
       // bumpArena is nested in an arena
-      return new(memory) bumpArena{ .flags = flags, .reservedSize = (u32)(allocateSize - 1),
-        .committedSize = (u32)(allocateSize - 1), .freeNodeStart = (u32)sizeof(bumpArena), 
+      return new(memory) bumpArena{ .flags = flags, .pageFlags = pageFlags, .reservedSize = (u32)(allocateSize - 1),
+        .committedSize = (u32)(allocateSize - 1), .freeNodeStart = (u32)sizeof(bumpArena),
         .lastUsedNode = (u32)sizeof(bumpArena) };
     }
 
@@ -183,7 +228,7 @@ namespace utils
       {
         .insert = [](void *allocator, usize size, usize alignment, bool clean)
         { return T::insert((T *)allocator, size, alignment, clean); },
-        .remove = T::remove,
+        .remove = [](const void *allocation) { T::remove(allocation); },
         .fromAllocation = +[](const void *allocation)
         {
           auto allocator = fromType(T::type);
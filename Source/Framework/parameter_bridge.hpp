@@ -6,6 +6,7 @@
 #include "satomi.hpp"
 #include "stl_utils.hpp"
 #include "memory.hpp"
+#include "parameter_types.hpp"
 
 namespace Plugin
 {
@@ -16,6 +17,16 @@ namespace Framework
 {
   struct ParameterLink;
 
+  // snapshot of everything a host can query about a bridge, it's never modified after being published
+  // indexed parameters get their options copied along, since the parameter's own can change while mapped out
+  // a new one replaces it whenever the mapping or name changes, see ParameterBridge::publishDescriptor
+  struct ParameterBridgeDescriptor
+  {
+    utils::string name{};
+    ParameterDetails details{};
+    bool isMapped = false;
+  };
+
   class ParameterBridge
   {
   public:
@@ -44,6 +55,9 @@ namespace Framework
     void setCustomName(utils::string name);
 
     bool isMappedToParameter() const { return parameterLinkPointer_.load(satomi::memory_order_acquire); }
+    const ParameterBridgeDescriptor *getDescriptor() const { return descriptor_.load(satomi::memory_order_acquire); }
+    // needs to be called whenever the details of the mapped parameter change
+    void refreshDescriptor();
 
     float getValue() const { return value_.load(satomi::memory_order_relaxed); }
     void setValue(float newValue)
@@ -66,7 +80,9 @@ namespace Framework
     Plugin::State *state = nullptr;
 
   private:
-    utils::pair<satomi::atomic<bool>, utils::string> name_{};
+    void publishDescriptor(ParameterLink *link, utils::stringnd name);
+
+    satomi::atomic<const ParameterBridgeDescriptor *> descriptor_ = nullptr;
     satomi::atomic<float> value_ = kDefaultParameterValue;
     satomi::atomic<bool> wasValueSet_ = false;
     satomi::atomic<ParameterLink *> parameterLinkPointer_ = nullptr;
@@ -6,6 +6,7 @@
 #include "constants.hpp"
 #include "utils.hpp"
 #include "memory.hpp"
+#include "fourier_transform.hpp"
 
 extern "C" typedef struct NSVGimage NSVGimage;
 
@@ -310,6 +311,8 @@ namespace Framework
       GroupTag = NoTag,
       ProcessorTag = 1U << 0,
       NoParameterValidationTag = 1U << 1,
+      // processor only ever reads the bin it is writing to, so its input can double as its output
+      InPlaceTag = 1U << 2,
 
       InactiveTag = 1U << 30,
       RuntimeAddedTag = 1U << 31,
@@ -422,6 +425,7 @@ namespace Framework
     utils::string_view configFolderPath{};
     utils::sll<utils::string_view> *strings{};
     utils::sll<Plugin::ComplexPlugin> *pluginInstances{};
+    FFTPlanCache fftPlans{};
   };
 
   inline usize printToggleValues(char *string, usize size, double value, const ParameterDetails &)
@@ -467,6 +471,10 @@ namespace Framework
     UndoAction *(*combineActions)(utils::bumpArena *transaction,
       UndoAction *currentAction, UndoAction *nextAction){};
 
+    // memory the action keeps alive outside of its transaction arena (i.e. saved presets),
+    // it's counted against the history budget and can change during undo/redo
+    usize heldBytes = 0;
+
     UndoAction *next{};
   };
 
@@ -474,6 +482,7 @@ namespace Framework
   {
   public:
     static constexpr auto storagePerTransaction = 512;
+    static constexpr usize defaultHistoryBudget = COMPLEX_MB(64);
 
     ~UndoManager();
 
@@ -481,6 +490,9 @@ namespace Framework
 
     void clear();
     void setTransationStorage(usize transactionsToKeep);
+    // the oldest transactions are dropped whenever the bytes held by actions exceed this
+    void setHistoryBudget(usize bytes);
+    usize getHeldBytes() const { return heldBytes; }
 
     // Performs an action and adds it to the undo history list.
     bool perform(UndoAction *action);
@@ -509,9 +521,14 @@ namespace Framework
     bool isPerformingUndoRedo() const { return isInsideUndoRedoCall; }
 
   private:
+    // destroys the actions of a transaction and frees everything they were holding
+    void destroyTransaction(usize index);
+    void trimToBudget();
+
     utils::bumpArena *storage{};
     utils::span<utils::pair<utils::bumpArena *, UndoAction *>> transactions{};
     usize currentIndex = 0, undoActionsCount = 0, redoActionsCount = 0;
+    usize historyBudget = defaultHistoryBudget, heldBytes = 0;
     bool isInsideUndoRedoCall = false;
   };
 }
@@ -274,21 +274,22 @@ namespace Framework
     }
     ParameterLink *getParameterLink() noexcept { return &parameterLink_; }
 
-    void setParameterDetails(const ParameterDetails &details, float *value = nullptr) noexcept
-    {
-      utils::ScopedLock g{ waitLock_, utils::WaitMechanism::Spin };
-      details_ = details;
-      if (value)
-        normalisedValue_ = *value;
-      isDirty_ = true;
-    }
+    void setParameterDetails(const ParameterDetails &details, float *value = nullptr) noexcept;
 
-    void serialiseToJson(void *jsonData) const;
+    void serialiseToJson(void *jsonWriter) const;
     static ParameterValue *
     deserialiseFromJson(Generation::Processor *processor, void *jsonData,
       ParameterDetails &reference, ParameterValue *memory = nullptr);
+    void serialiseToBinary(void *writer) const;
+    static ParameterValue *
+    deserialiseFromBinary(Generation::Processor *processor, void *reader,
+      ParameterDetails &reference, ParameterValue *memory = nullptr);
 
   private:
+    // shared between the json and binary deserialisation
+    void applySavedRange(float minValue, float maxValue, bool isAutomated);
+    void applySavedValue(Generation::Processor *processor, float value, u64 automationSlot);
+
     // after adding modulations and scaling
     simd_float internalValue_ = 0.0f;
     // after adding modulations
@@ -368,18 +368,60 @@ namespace Framework
     return result;
   }
 
+  // the whole tree goes into a single allocation so that it's removed together with the descriptor
+  static IndexedData *
+  copyOptionsForDescriptor(utils::bumpArena *arena, const IndexedData *options)
+  {
+    usize count = 1;
+    (void)IndexedData::visit(const_cast<IndexedData *>(options), [&](IndexedData &) { ++count; return false; });
+
+    auto *copies = arranew(arena, IndexedData, count, {});
+    usize used = 0;
+    auto copy = [&](const auto &self, const IndexedData *option, IndexedData *parent) -> IndexedData *
+    {
+      auto *newOption = &copies[used++];
+      *newOption = *option;
+      newOption->parent = parent;
+      newOption->children = nullptr;
+      newOption->next = nullptr;
+
+      IndexedData *previous = nullptr;
+      for (auto *child = option->children; child; child = child->next)
+      {
+        auto *newChild = self(self, child, newOption);
+        if (previous)
+          previous->next = newChild;
+        else
+          newOption->children = newChild;
+        previous = newChild;
+      }
+
+      return newOption;
+    };
+
+    return copy(copy, options, nullptr);
+  }
+
+  static void destroyDescriptor(const ParameterBridgeDescriptor *descriptor)
+  {
+    if (descriptor->isMapped && descriptor->details.scale == ParameterScale::Indexed)
+      utils::bumpArena::remove(descriptor->details.options);
+    descriptor->~ParameterBridgeDescriptor();
+    utils::bumpArena::remove(descriptor);
+  }
+
   ParameterBridge::ParameterBridge(Plugin::State *state, u64 parameterIndex,
     ParameterLink *link) : parameterIndex{ parameterIndex }, state{ state }
   {
     if (!link)
     {
-      name_.second = utils::string::create(state->miscStorage, "%zu", parameterIndex + 1);
+      publishDescriptor(nullptr, utils::string::create(state->miscStorage, "%zu", parameterIndex + 1));
       return;
     }
 
     parameterLinkPointer_.store(link, satomi::memory_order_release);
     auto name = link->parameter->getParameterDetails().displayName;
-    name_.second = utils::string::create(state->miscStorage, "%zu > %s", parameterIndex + 1, name.data());
+    publishDescriptor(link, utils::string::create(state->miscStorage, "%zu > %s", parameterIndex + 1, name.data()));
     link->hostControl = this;
     value_.store(link->parameter->getNormalisedValue());
   }
@@ -390,6 +432,54 @@ namespace Framework
       link->parameter->changeBridge(nullptr);
   }
 
+  // descriptors are only published from the thread that owns the state (the main thread once it's live),
+  // which is also the only one changing the options of its parameters
+  void ParameterBridge::publishDescriptor(ParameterLink *link, utils::stringnd name)
+  {
+    auto *descriptor = anew(state->miscStorage, ParameterBridgeDescriptor, {});
+    descriptor->name = COMPLEX_MOVE(name);
+    if (link)
+    {
+      descriptor->details = link->parameter->getParameterDetails();
+      if (descriptor->details.scale == ParameterScale::Indexed)
+        descriptor->details.options = copyOptionsForDescriptor(state->miscStorage, descriptor->details.options);
+      descriptor->isMapped = true;
+    }
+
+    auto *previous = descriptor_.exchange(descriptor);
+    if (!previous)
+      return;
+
+    // host readers only get descriptors through the published state,
+    // if this one isn't (or isn't anymore) nobody can be reading the previous descriptor
+    auto *plugin = state->plugin;
+    if (plugin->hostState.load() != state)
+    {
+      destroyDescriptor(previous);
+      return;
+    }
+
+    // the previous descriptor is kept until the flip after the one that follows its replacement,
+    // by which point every reader that could've loaded it has left (see ComplexPlugin::waitForHostReaders)
+    u32 epoch = plugin->waitForHostReaders();
+    state->retiredDescriptors.eraseIf([epoch](const auto &retired)
+      {
+        if (retired.first >= epoch)
+          return false;
+
+        destroyDescriptor(retired.second);
+        return true;
+      });
+    state->retiredDescriptors.emplaceBack(epoch, previous);
+  }
+
+  void ParameterBridge::refreshDescriptor()
+  {
+    auto *descriptor = descriptor_.load(satomi::memory_order_acquire);
+    publishDescriptor(parameterLinkPointer_.load(satomi::memory_order_acquire),
+      utils::stringnd{ state->miscStorage, descriptor->name });
+  }
+
   void ParameterBridge::resetParameterLink(ParameterLink *link, bool getValueFromParameter)
   {
     auto *oldLink = parameterLinkPointer_.load(satomi::memory_order_acquire);
@@ -398,29 +488,25 @@ namespace Framework
 
     parameterLinkPointer_.store(link, satomi::memory_order_release);
 
+    if (!link)
     {
-      utils::ScopedLock guard{ name_.first, utils::WaitMechanism::Spin };
-
-      if (!link)
+      if (oldLink)
+        oldLink->parameter->changeBridge(nullptr);
+      publishDescriptor(nullptr, utils::string::create(state->miscStorage, "%zu", parameterIndex + 1));
+    }
+    else
+    {
+      link->parameter->changeBridge(this);
+      if (getValueFromParameter)
       {
-        if (oldLink)
-          oldLink->parameter->changeBridge(nullptr);
-        name_.second = utils::string::create(state->miscStorage, "%zu", parameterIndex + 1);
+        auto newValue = link->parameter->getNormalisedValue();
+        value_.store(newValue, satomi::memory_order_release);
       }
-      else
-      {
-        link->parameter->changeBridge(this);
-        if (getValueFromParameter)
-        {
-          auto newValue = link->parameter->getNormalisedValue();
-          value_.store(newValue, satomi::memory_order_release);
-        }
-        else if (link->UIControl)
-          link->UIControl->setValue(value_.load(satomi::memory_order_relaxed));
+      else if (link->UIControl)
+        link->UIControl->setValue(value_.load(satomi::memory_order_relaxed));
 
-        auto name = link->parameter->getParameterDetails().displayName;
-        name_.second = utils::string::create(state->miscStorage, "%zu > %s", parameterIndex + 1, name.data());
-      }
+      auto name = link->parameter->getParameterDetails().displayName;
+      publishDescriptor(link, utils::string::create(state->miscStorage, "%zu > %s", parameterIndex + 1, name.data()));
     }
   }
 
@@ -446,53 +532,51 @@ namespace Framework
 
   void ParameterBridge::setCustomName(utils::string name)
   {
-    utils::ScopedLock guard{ name_.first, utils::WaitMechanism::Spin };
-    name_.second = COMPLEX_MOVE(name);
+    publishDescriptor(parameterLinkPointer_.load(satomi::memory_order_acquire), COMPLEX_MOVE(name));
   }
 
+  // everything the host can call from here on only reads the published descriptor,
+  // so the mapped parameter can be changed or destroyed at the same time
+
   float
   ParameterBridge::getDefaultValue() const
   {
-    if (auto pointer = parameterLinkPointer_.load(satomi::memory_order_acquire))
-      return utils::clamp(pointer->parameter->getParameterDetails().defaultNormalisedValue, 0.0f, 1.0f);
+    if (auto descriptor = getDescriptor(); descriptor->isMapped)
+      return utils::clamp(descriptor->details.defaultNormalisedValue, 0.0f, 1.0f);
     return kDefaultParameterValue;
   }
 
   void ParameterBridge::getName(utils::string &outString) const
   {
-    // this is hacky i know but there's no way to declare the atomic mutable inside the pair
-    utils::ScopedLock guard{ const_cast<satomi::atomic<bool> &>(name_.first), utils::WaitMechanism::Spin };
-
-    if (parameterLinkPointer_.load(satomi::memory_order_acquire))
+    auto descriptor = getDescriptor();
+    if (descriptor->isMapped)
     {
-      outString.copy(name_.second);
+      outString.copy(descriptor->name);
     }
     else
     {
-      auto index = name_.second.find(" ");
-      outString.copy({ name_.second, 0, index });
+      auto index = descriptor->name.find(" ");
+      outString.copy({ descriptor->name, 0, index });
     }
   }
 
   void ParameterBridge::getName(char *buffer, usize maximumStringLength) const
   {
-    // this is hacky i know but there's no way to declare the atomic mutable inside the pair
-    utils::ScopedLock guard{ const_cast<satomi::atomic<bool> &>(name_.first), utils::WaitMechanism::Spin };
-
-    usize size = utils::min(name_.second.size(), maximumStringLength - 1);
-    ::memcpy(buffer, name_.second.data(), size);
+    auto descriptor = getDescriptor();
+    usize size = utils::min(descriptor->name.size(), maximumStringLength - 1);
+    ::memcpy(buffer, descriptor->name.data(), size);
     buffer[size] = '\0';
   }
 
   void ParameterBridge::getText(float value, char *buffer, usize maximumStringLength) const
   {
-    auto pointer = parameterLinkPointer_.load(satomi::memory_order_acquire);
+    auto descriptor = getDescriptor();
     double internalValue;
-    if (!pointer)
+    if (!descriptor->isMapped)
       internalValue = value;
     else
     {
-      auto details = pointer->parameter->getParameterDetails();
+      auto &details = descriptor->details;
       auto sampleRate = state->plugin->getSampleRate();
       internalValue = scaleValue(value, details, sampleRate, true);
       if (details.scale == ParameterScale::Indexed)
@@ -520,8 +604,8 @@ namespace Framework
   float
   ParameterBridge::getValueForText(utils::string_view text) const
   {
-    if (auto pointer = parameterLinkPointer_.load(satomi::memory_order_acquire))
-      return (float)unscaleValue(::strtod(text.data(), nullptr), pointer->parameter->getParameterDetails(), true);
+    if (auto descriptor = getDescriptor(); descriptor->isMapped)
+      return (float)unscaleValue(::strtod(text.data(), nullptr), descriptor->details, true);
 
     return ::strtof(text.data(), nullptr);
   }
@@ -529,19 +613,34 @@ namespace Framework
   bool
   ParameterBridge::isDiscrete() const
   {
-    if (auto pointer = parameterLinkPointer_.load(satomi::memory_order_acquire))
-      return pointer->parameter->getScale() == ParameterScale::Indexed;
+    if (auto descriptor = getDescriptor(); descriptor->isMapped)
+      return descriptor->details.scale == ParameterScale::Indexed;
     return false;
   }
 
   bool
   ParameterBridge::isBoolean() const
   {
-    if (auto pointer = parameterLinkPointer_.load(satomi::memory_order_acquire))
-      return pointer->parameter->getScale() == ParameterScale::Toggle;
+    if (auto descriptor = getDescriptor(); descriptor->isMapped)
+      return descriptor->details.scale == ParameterScale::Toggle;
     return false;
   }
 
+  void ParameterValue::setParameterDetails(const ParameterDetails &details, float *value) noexcept
+  {
+    {
+      utils::ScopedLock g{ waitLock_, utils::WaitMechanism::Spin };
+      details_ = details;
+      if (value)
+        normalisedValue_ = *value;
+      isDirty_ = true;
+    }
+
+    // the host sees the new range/default through the bridge
+    if (auto *bridge = parameterLink_.hostControl)
+      bridge->refreshDescriptor();
+  }
+
   void ParameterValue::updateValue(float sampleRate)
   {
     utils::ScopedLock g{ waitLock_, utils::WaitMechanism::Spin };
@@ -575,6 +674,14 @@ namespace Framework
     isDirty_ = false;
   }
 
+  static usize sumHeldBytes(UndoAction *actions)
+  {
+    usize bytes = 0;
+    for (auto *action = actions; action; action = action->next)
+      bytes += action->heldBytes;
+    return bytes;
+  }
+
   UndoManager::UndoManager(utils::bumpArena *parentArena, usize transactionsToKeep)
   {
     storage = utils::bumpArena::createNested(parentArena, 
@@ -584,6 +691,8 @@ namespace Framework
 
   UndoManager::~UndoManager()
   {
+    for (usize i = 0; i < transactions.size(); ++i)
+      destroyTransaction(i);
     utils::bumpArena::destroy(storage);
   }
 
@@ -620,14 +729,10 @@ namespace Framework
       // in reverse, from newest to oldest
 
       for (usize i = redoActionsCount - newRedoActionsCount; i > 0; --i)
-        for (auto *action = transactions[currentIndex + newRedoActionsCount + i - 1].second; action; action = action->next)
-          if (action->destructor)
-            action->destructor(action);
+        destroyTransaction(currentIndex + newRedoActionsCount + i - 1);
 
       for (usize i = 0; i < undoActionsCount - newUndoActionsCount; ++i)
-        for (auto *action = transactions[currentIndex - newUndoActionsCount - i].second; action; action = action->next)
-          if (action->destructor)
-            action->destructor(action);
+        destroyTransaction(currentIndex - newUndoActionsCount - i);
 
       redoActionsCount = newRedoActionsCount;
       undoActionsCount = newUndoActionsCount;
@@ -644,8 +749,44 @@ namespace Framework
     transactions = { newTransactions, transactionsToKeep };
   }
 
+  void UndoManager::setHistoryBudget(usize bytes)
+  {
+    historyBudget = bytes;
+    trimToBudget();
+  }
+
+  void UndoManager::destroyTransaction(usize index)
+  {
+    auto &[arena, actions] = transactions[index];
+    heldBytes -= sumHeldBytes(actions);
+
+    for (auto *action = actions; action; action = action->next)
+      if (action->destructor)
+        action->destructor(action);
+
+    actions = {};
+    if (arena)
+      arena->clear(arena);
+  }
+
+  void UndoManager::trimToBudget()
+  {
+    // the current transaction is always kept, even if it alone goes over budget
+    while (heldBytes > historyBudget && undoActionsCount > 1)
+    {
+      destroyTransaction((currentIndex + 1 + transactions.size() - undoActionsCount) % transactions.size());
+      --undoActionsCount;
+    }
+  }
+
   void UndoManager::clear()
   {
+    // actions can be holding memory outside of storage
+    if (transactions.data())
+      for (usize i = 0; i < transactions.size(); ++i)
+        destroyTransaction(i);
+    heldBytes = 0;
+
     currentIndex = 0;
     undoActionsCount = 1; // for the currentIndex
     redoActionsCount = 0;
@@ -675,6 +816,8 @@ namespace Framework
     COMPLEX_ASSERT(redoActionsCount == 0, "You need to call beginNewTransaction() \
       if you want to overwrite undone actions");
 
+    usize previousHeldBytes = sumHeldBytes(transactions[currentIndex].second);
+
     UndoAction *previousAction{};
     auto [arena, action] = transactions[currentIndex];
     if (!action)
@@ -713,6 +856,9 @@ namespace Framework
       action = action->next;
     }
 
+    heldBytes += sumHeldBytes(transactions[currentIndex].second) - previousHeldBytes;
+    trimToBudget();
+
     return true;
   }
 
@@ -729,9 +875,7 @@ namespace Framework
         currentIndex = (currentIndex + 1) % transactions.size();
 
         // destroy transaction to be replaced
-        for (auto *action = transactions[currentIndex].second; action; action = action->next)
-          if (action->destructor)
-            action->destructor(action);
+        destroyTransaction(currentIndex);
 
         undoActionsCount = utils::min(undoActionsCount + 1, transactions.size());
         redoActionsCount = 0;
@@ -752,12 +896,17 @@ namespace Framework
 
     isInsideUndoRedoCall = true;
 
+    // actions can exchange what they're holding
+    heldBytes -= sumHeldBytes(transactions[currentIndex].second);
+
     COMPLEX_FOREACH_AND_REVERSE_SLL(action, transactions[currentIndex].second)
     {
       action->undo(action);
       transactions[currentIndex].second = action;
     }
 
+    heldBytes += sumHeldBytes(transactions[currentIndex].second);
+
     if (!undoCurrentTransactionOnly)
     {
       currentIndex = (currentIndex - 1 + transactions.size()) % transactions.size();
@@ -766,6 +915,7 @@ namespace Framework
     }
 
     isInsideUndoRedoCall = false;
+    trimToBudget();
     return true;
   }
 
@@ -776,17 +926,23 @@ namespace Framework
 
     isInsideUndoRedoCall = true;
 
-    COMPLEX_FOREACH_AND_REVERSE_SLL(action, transactions[(currentIndex + 1) % transactions.size()].second)
+    usize nextIndex = (currentIndex + 1) % transactions.size();
+    heldBytes -= sumHeldBytes(transactions[nextIndex].second);
+
+    COMPLEX_FOREACH_AND_REVERSE_SLL(action, transactions[nextIndex].second)
     {
       action->redo(action);
-      transactions[currentIndex].second = action;
+      transactions[nextIndex].second = action;
     }
 
-    currentIndex = (currentIndex + 1) % transactions.size();
+    heldBytes += sumHeldBytes(transactions[nextIndex].second);
+
+    currentIndex = nextIndex;
     --redoActionsCount;
     ++undoActionsCount;
 
     isInsideUndoRedoCall = false;
+    trimToBudget();
     return true;
   }
 
@@ -47,6 +47,7 @@
   #define NOSYSMETRICS
   #include <windows.h>
   #include <timeapi.h>
+  #include <psapi.h>
   #pragma comment(lib, "winmm.lib")
   #pragma comment(lib, "ntdll.lib")
 
@@ -60,8 +61,18 @@
 
   #include <stdio.h>
   #include <time.h>
-  #define _GNU_SOURCE
+  // g++ already defines it
+  #ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+  #endif
   #include <unistd.h>
+  #include <fcntl.h>
+  #include <dlfcn.h>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <sys/resource.h>
 
 #elif COMPLEX_MAC
 
@@ -74,10 +85,13 @@
   // https://catfox.life/2015/09/04/the-joys-of-unix-programming-map_anonymous/ 
   #define _DARWIN_C_SOURCE
   #include <sys/mman.h>
+  #include <sys/resource.h>
   #include <dlfcn.h>
   #include <time.h>
   #include <pthread.h>
   #include <unistd.h>
+  #include <fcntl.h>
+  #include <sys/stat.h>
 
   #include <CoreFoundation/CoreFoundation.h>
   #include <AppKit/AppKit.h>
@@ -206,7 +220,7 @@ namespace Interface
     return ret;
   }
 
-  bool showNativeMessageBox(const char *title, const char *message, MessageBoxType type)
+  static bool showPlatformMessageBox(const char *title, const char *message, MessageBoxType type)
   {
     int iconFlag;
 
@@ -262,7 +276,7 @@ namespace Interface
     return ret;
   }
 
-  bool showNativeMessageBox(const char *title, const char *message, MessageBoxType type)
+  static bool showPlatformMessageBox(const char *title, const char *message, MessageBoxType type)
   {
     CFOptionFlags cfAlertIcon;
 
@@ -296,8 +310,47 @@ namespace Interface
 
 #elif COMPLEX_LINUX
 
+namespace Interface
+{
+  MonitorInfo
+  getCurrentMonitorInfo(void *nativeHandle)
+  {
+    // TODO: query xrandr for the monitor the window is on
+    return MonitorInfo{ .nativeHandle = nativeHandle, .dpiScale = 1.0f, .isPrimary = true };
+  }
+
+  static bool showPlatformMessageBox(const char *title, const char *message, [[maybe_unused]] MessageBoxType type)
+  {
+    // there's no toolkit to show a dialog with, which also covers running headless
+    ::fprintf(stderr, "%s: %s\n", title, message);
+    return false;
+  }
+}
+
 #endif
 
+namespace Interface
+{
+  DeferredMessageBoxes *&
+  getDeferredMessageBoxes()
+  {
+    thread_local DeferredMessageBoxes *deferredMessageBoxes{};
+    return deferredMessageBoxes;
+  }
+
+  bool showNativeMessageBox(const char *title, const char *message, MessageBoxType type)
+  {
+    auto *deferred = getDeferredMessageBoxes();
+    if (!deferred)
+      return showPlatformMessageBox(title, message, type);
+
+    deferred->messages->appendFormat("%s: %s\n\n", title, message);
+    if ((u32)type > (u32)deferred->type)
+      deferred->type = type;
+    return false;
+  }
+}
+
 
 namespace utils
 {
@@ -322,6 +375,8 @@ namespace utils
 
   static constinit usize pageSize = 0;
 
+  usize getPageSize() { return pageSize; }
+
   byte *
   reserveMemory(usize &size)
   {
@@ -409,6 +464,165 @@ namespace utils
   #endif
   }
 
+  void prefaultMemory(void *memory, usize size)
+  {
+    if (!size)
+      return;
+
+  #if COMPLEX_LINUX && defined(MADV_POPULATE_WRITE)
+    {
+      usize begin = (usize)memory & ~(pageSize - 1);
+      if (madvise((void *)begin, (usize)memory + size - begin, MADV_POPULATE_WRITE) == 0)
+        return;
+      // older kernels don't support it, fall through to touching manually
+    }
+  #endif
+
+    // writing back what's already there, reading alone might only map the shared zero page
+    // the first touch is at memory itself and every next one is at a page start,
+    // so we never touch bytes that don't belong to the range
+    volatile byte *current = (volatile byte *)memory;
+    byte *end = (byte *)memory + size;
+    while ((byte *)current < end)
+    {
+      *current = *current;
+      current = (volatile byte *)(((usize)current & ~(pageSize - 1)) + pageSize);
+    }
+  }
+
+  bool lockMemory(void *memory, usize size)
+  {
+    if (!size)
+      return true;
+
+  #if COMPLEX_WINDOWS
+    return VirtualLock(memory, size) != 0;
+  #else
+    return mlock(memory, size) == 0;
+  #endif
+  }
+
+  void unlockMemory(void *memory, usize size)
+  {
+    usize begin = utils::roundUpToMultiple((usize)memory, pageSize);
+    usize end = ((usize)memory + size) & ~(pageSize - 1);
+    if (begin >= end)
+      return;
+
+  #if COMPLEX_WINDOWS
+    VirtualUnlock((void *)begin, end - begin);
+  #else
+    munlock((void *)begin, end - begin);
+  #endif
+  }
+
+  void adviseHugePages([[maybe_unused]] void *memory, [[maybe_unused]] usize size)
+  {
+  #if COMPLEX_LINUX && defined(MADV_HUGEPAGE)
+    usize begin = (usize)memory & ~(pageSize - 1);
+    madvise((void *)begin, (usize)memory + size - begin, MADV_HUGEPAGE);
+  #endif
+    // windows requires MEM_LARGE_PAGES together with SeLockMemoryPrivilege at reservation
+    // and mac only offers superpages through mach_vm_allocate, neither of which fits reserve/commit
+  }
+
+  u64 getPageFaultCount()
+  {
+  #if COMPLEX_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters{ .cb = sizeof(PROCESS_MEMORY_COUNTERS) };
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+      return 0;
+    return (u64)counters.PageFaultCount;
+  #else
+    struct rusage usage{};
+  #ifdef RUSAGE_THREAD
+    if (getrusage(RUSAGE_THREAD, &usage) != 0)
+  #else
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+  #endif
+      return 0;
+    return (u64)usage.ru_minflt + (u64)usage.ru_majflt;
+  #endif
+  }
+
+  const byte *
+  mapFile(const char *path, usize &size)
+  {
+    size = 0;
+  #if COMPLEX_WINDOWS
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return nullptr;
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+      CloseHandle(file);
+      return nullptr;
+    }
+
+    // the view keeps the mapping (and the mapping the file) alive after the handles are closed
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+      return nullptr;
+
+    void *memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!memory)
+      return nullptr;
+
+    size = (usize)fileSize.QuadPart;
+    return (const byte *)memory;
+  #else
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+      return nullptr;
+
+    struct stat status{};
+    if (fstat(file, &status) != 0 || status.st_size <= 0)
+    {
+      close(file);
+      return nullptr;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    void *memory = mmap(nullptr, (usize)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (memory == MAP_FAILED)
+      return nullptr;
+
+    // files are expected to be read front to back
+    madvise(memory, (usize)status.st_size, MADV_SEQUENTIAL);
+
+    size = (usize)status.st_size;
+    return (const byte *)memory;
+  #endif
+  }
+
+  void unmapFile(const void *memory, [[maybe_unused]] usize size)
+  {
+  #if COMPLEX_WINDOWS
+    [[maybe_unused]] auto result = UnmapViewOfFile(memory);
+    COMPLEX_ASSERT(result != 0);
+  #else
+    [[maybe_unused]] auto result = munmap((void *)memory, size);
+    COMPLEX_ASSERT(result == 0);
+  #endif
+  }
+
+  u32 getProcessorCount()
+  {
+  #if COMPLEX_WINDOWS
+    SYSTEM_INFO sysinfo{};
+    GetSystemInfo(&sysinfo);
+    return (u32)sysinfo.dwNumberOfProcessors;
+  #else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (u32)count : 1;
+  #endif
+  }
+
   // unlike the global allocation functions
   // you can set the arena for these with `getLocalMallocArena() = arena;`
   extern "C" void *arena_malloc(size_t size)
@@ -631,6 +845,80 @@ namespace utils
   #endif
   }
 
+  u64 getMonotonicMicroseconds() noexcept
+  {
+  #if COMPLEX_WINDOWS
+    LARGE_INTEGER largeInt;
+    QueryPerformanceCounter(&largeInt);
+    return (u64)largeInt.QuadPart * 1'000'000 / systemFrequency;
+  #else
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (u64)time.tv_sec * 1'000'000 + (u64)time.tv_nsec / 1'000;
+  #endif
+  }
+
+#if COMPLEX_AUDIO_THREAD_GUARD
+  thread_local bool AudioThreadGuard::isAudioThread_ = false;
+  AudioThreadGuard::Entry AudioThreadGuard::log_[kLogSize]{};
+
+  void AudioThreadGuard::record(ViolationType type, sourceLocation location, u64 waitUs) noexcept
+  {
+    violationCount_.fetch_add(1, satomi::memory_order_relaxed);
+
+    u64 index = writeIndex_.fetch_add(1, satomi::memory_order_relaxed);
+    auto &entry = log_[index % kLogSize];
+
+    // seqlock style publishing, readers discard entries whose sequence changes while copying
+    entry.sequence.store(0, satomi::memory_order_relaxed);
+    satomi::atomic_thread_fence(satomi::memory_order_release);
+    entry.violation = { .location = location, .waitUs = waitUs, .type = type };
+    entry.sequence.store(index + 1, satomi::memory_order_release);
+  }
+
+  usize AudioThreadGuard::drain(span<Violation> destination) noexcept
+  {
+    usize copied = 0;
+    while (copied < destination.size())
+    {
+      // read index first, a write index loaded before it could be behind what other readers have already claimed
+      // and the distance between them would wrap around and send the read index back
+      u64 readIndex = readIndex_.load(satomi::memory_order_acquire);
+      u64 writeIndex = writeIndex_.load(satomi::memory_order_acquire);
+      // entries older than kLogSize have been overwritten
+      u64 index = (writeIndex - readIndex > kLogSize) ? writeIndex - kLogSize : readIndex;
+      if (index >= writeIndex)
+        break;
+
+      // an index is handed out before its entry is written, so it can still be unpublished
+      // we stop there and leave it to the next drain, unless a newer write has already lapped it
+      auto &entry = log_[index % kLogSize];
+      u64 sequence = entry.sequence.load(satomi::memory_order_acquire);
+      if (sequence < index + 1)
+      {
+        if (writeIndex_.load(satomi::memory_order_relaxed) - index > kLogSize)
+          continue;
+        break;
+      }
+
+      Violation violation = entry.violation;
+      satomi::atomic_thread_fence(satomi::memory_order_acquire);
+      bool isIntact = sequence == index + 1 && entry.sequence.load(satomi::memory_order_relaxed) == sequence;
+
+      // every instance drains from its own ui thread, claiming the index only after the copy
+      // makes sure an entry is handed out to only one of them and that it's only claimed once it's readable
+      // an entry that got overwritten while it was read is lost, the index is claimed to move past it
+      if (!readIndex_.compare_exchange_weak(readIndex, index + 1, satomi::memory_order_acq_rel))
+        continue;
+
+      if (isIntact)
+        destination[copied++] = violation;
+    }
+
+    return copied;
+  }
+#endif
+
   void setHighResolutionClock(bool isHighResolution)
   {
   #if COMPLEX_WINDOWS
@@ -738,7 +1026,9 @@ namespace utils
   extern "C" __declspec(dllexport) void
   initialiseHotreloadDylib(DWORD tlsIndex, utils::bumpArena *global)
 #else
-  constinit pthread_key_t gTlsKey{};
+  // 0 is a valid key on linux (the first one created) so it can't double as "no key"
+  constexpr pthread_key_t kNoTlsKey = (pthread_key_t)-1;
+  constinit pthread_key_t gTlsKey = kNoTlsKey;
   extern "C" __attribute__((visibility("default"))) void
   initialiseHotreloadDylib(pthread_key_t tlsKey, utils::bumpArena *global)
 #endif
@@ -773,7 +1063,7 @@ namespace utils
     if (gDwTlsIndex != TLS_OUT_OF_INDEXES)
       return TlsGetValue(gDwTlsIndex);
   #else
-    if (gTlsKey)
+    if (gTlsKey != kNoTlsKey)
       return pthread_getspecific(gTlsKey);
   #endif
     return nullptr;
@@ -785,7 +1075,7 @@ namespace utils
     if (gDwTlsIndex != TLS_OUT_OF_INDEXES)
       TlsSetValue(gDwTlsIndex, context);
   #else
-    if (gTlsKey)
+    if (gTlsKey != kNoTlsKey)
       pthread_setspecific(gTlsKey, context);
   #endif
   }
@@ -966,7 +1256,7 @@ namespace utils
       if (gDwTlsIndex != TLS_OUT_OF_INDEXES)
         TlsFree(gDwTlsIndex);
     #else
-      if (gTlsKey)
+      if (gTlsKey != kNoTlsKey)
         pthread_key_delete(gTlsKey);
     #endif
     }
@@ -980,6 +1270,31 @@ namespace utils
     globalArena = nullptr;
   }
 
+  void bumpArena::preparePages(void *memory, usize size, u8 pageFlags)
+  {
+    if (pageFlags & HugePages)
+      adviseHugePages(memory, size);
+    if (pageFlags & (PrefaultPages | LockPages))
+      prefaultMemory(memory, size);
+    if (pageFlags & LockPages)
+    {
+      [[maybe_unused]] bool result = lockMemory(memory, size);
+      COMPLEX_ASSERT(result, "Couldn't lock arena pages, locked memory limit was probably reached");
+    }
+  }
+
+  bool bumpArena::hasLockedPages(bumpArena *arena)
+  {
+    while (true)
+    {
+      if (arena->pageFlags & LockPages)
+        return true;
+      if ((AllocatorType)arena->flags != AllocatorType::BumpArena)
+        return false;
+      arena = fromAllocation(arena);
+    }
+  }
+
   usize
   bumpArena::getUsedSize(bumpArena *arena)
   {
@@ -1041,8 +1356,10 @@ namespace utils
   }
 
   byte *
-  bumpArena::insert(bumpArena *arena, usize size, usize alignment, bool clean)
+  bumpArena::insert(bumpArena *arena, usize size, usize alignment, bool clean,
+    [[maybe_unused]] sourceLocation location)
   {
+    COMPLEX_AUDIO_THREAD_RECORD(ArenaInsert, location);
     COMPLEX_HARD_ASSERT(arena);
     COMPLEX_HARD_ASSERT(utils::isPowerOfTwo(alignment));
 
@@ -1113,6 +1430,7 @@ namespace utils
           (usize)((memory + size) - ((byte *)arena + committedSize)));
 
         utils::commitMemory((byte *)arena + committedSize, commitSize);
+        preparePages((byte *)arena + committedSize, commitSize, arena->pageFlags);
         arena->committedSize += (u32)commitSize;
 
         if (isLastFreeNodeAtEnd)
@@ -1143,18 +1461,18 @@ namespace utils
           //  break;
 
           case AllocatorType::BumpArena:
-            arena->nextArena = bumpArena::createNested(bumpArena::fromAllocation(arena), nextCommittedSize);
+            arena->nextArena = bumpArena::createNested(bumpArena::fromAllocation(arena), nextCommittedSize, arena->pageFlags);
             break;
 
           case AllocatorType::General:
-            arena->nextArena = bumpArena::create(nextReservedSize, nextCommittedSize);
+            arena->nextArena = bumpArena::create(nextReservedSize, nextCommittedSize, arena->pageFlags);
             break;
           }
         }
 
         auto *nextArena = arena->nextArena;
         g.~ScopedLock();
-        return bumpArena::insert(nextArena, size, alignment, clean);
+        return bumpArena::insert(nextArena, size, alignment, clean, location);
       }
     }
 
@@ -1215,8 +1533,11 @@ namespace utils
   }
 
   byte *
-  bumpArena::resize(const void *data, usize newSize, bool cleanNewSpace)
+  bumpArena::resize(const void *data, usize newSize, bool cleanNewSpace,
+    [[maybe_unused]] sourceLocation location)
   {
+    COMPLEX_AUDIO_THREAD_RECORD(ArenaResize, location);
+
     auto *node = utils::launder((bumpArena::node *)((byte *)data - sizeof(bumpArena::node)));
     auto *arena = utils::launder((bumpArena *)((byte *)node - node->offsetToArena));
 
@@ -1250,6 +1571,7 @@ namespace utils
           usize commitSize = utils::min(reservedSize - committedSize,
             (usize)(endOfAllocation - endOfCommitted));
           utils::commitMemory(endOfCommitted, commitSize);
+          preparePages(endOfCommitted, commitSize, arena->pageFlags);
 
           arena->committedSize += (u32)commitSize;
           committedSize += commitSize;
@@ -1286,19 +1608,21 @@ namespace utils
       }
 
       // allocation cannot be expanded in-place, allocate again and copy data over
-      auto *newAllocation = bumpArena::insert(arena, newSize, utils::getAlignment(data));
+      auto *newAllocation = bumpArena::insert(arena, newSize, utils::getAlignment(data), false, location);
       usize copiedBytes = node->size - sizeof(bumpArena::node);
       valcpy(newAllocation, (byte *)data, copiedBytes);
       if (cleanNewSpace)
         zeroset(newAllocation + copiedBytes, newSize - copiedBytes);
-      bumpArena::remove(data);
+      bumpArena::remove(data, location);
 
       return newAllocation;
     }
   }
 
-  void bumpArena::remove(const void *data)
+  void bumpArena::remove(const void *data, [[maybe_unused]] sourceLocation location)
   {
+    COMPLEX_AUDIO_THREAD_RECORD(ArenaRemove, location);
+
     auto *toRemove = utils::launder((bumpArena::node *)((byte *)data - sizeof(bumpArena::node)));
     auto *arena = utils::launder((bumpArena *)((byte *)toRemove - toRemove->offsetToArena));
 
@@ -1386,6 +1710,9 @@ namespace utils
     //  break;
 
     case AllocatorType::BumpArena:
+      // pages of the parent arena stay resident otherwise
+      if (arena->pageFlags & LockPages)
+        unlockMemory(arena, (usize)arena->committedSize + 1);
       bumpArena::remove(arena);
       break;
 
@@ -169,6 +169,16 @@
   #define COMPLEX_INVARIANT_ASSERT(...) ((void)0)
 #endif
 
+// records realtime-unsafe operations done on the audio thread, see utils::AudioThreadGuard
+// on in debug builds and complex-render, define it to 1 to use it in optimised builds for profiling
+#ifndef COMPLEX_AUDIO_THREAD_GUARD
+  #ifdef COMPLEX_RENDER_CLI
+    #define COMPLEX_AUDIO_THREAD_GUARD 1
+  #else
+    #define COMPLEX_AUDIO_THREAD_GUARD COMPLEX_DEBUG
+  #endif
+#endif
+
 #define COMPLEX_HARD_ASSERT(condition, ...) (void)((!!(condition)) || (::common::complexPrintAssertMessage(#condition, \
   __FILE__, __func__, __LINE__ __VA_OPT__(, true,) __VA_ARGS__), COMPLEX_TRAP(), false))
 #define COMPLEX_HARD_ASSERT_FALSE(...) (void)(::common::complexPrintAssertMessage(nullptr, \
@@ -257,12 +267,20 @@ extern "C"
   CRT_LINKAGE double log10(double arg);
   CRT_LINKAGE double pow(double base, double exponent);
   CRT_LINKAGE double sqrt(double arg);
+  CRT_LINKAGE double sin(double arg);
+  CRT_LINKAGE double cos(double arg);
 
-  CRT_LINKAGE unsigned long strtoul(const char *string, char **string_end, int base);
   #if COMPLEX_MAC
+    unsigned long strtoul(const char *string, char **string_end, int base);
     float         strtof(const char *string, char **string_end) __asm("_strtof");
     double        strtod(const char *string, char **string_end) __asm("_strtod");
+  #elif COMPLEX_LINUX
+    // glibc declares these as nothrow, which has to match if <stdlib.h> is included later
+    unsigned long strtoul(const char *string, char **string_end, int base) noexcept;
+    float         strtof(const char *string, char **string_end) noexcept;
+    double        strtod(const char *string, char **string_end) noexcept;
   #else
+    CRT_LINKAGE unsigned long strtoul(const char *string, char **string_end, int base);
     CRT_LINKAGE float         strtof(const char *string, char **string_end);
     CRT_LINKAGE double        strtod(const char *string, char **string_end);
   #endif
@@ -0,0 +1,229 @@
+// Copyright 2012-2023 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+// Platform implementation without a windowing system, for programs that link
+// the interface code but never show it. Realizing a view always fails.
+
+#include "Third Party/pugl/src/internal.h"
+#include "Third Party/pugl/src/platform.h"
+#include "Third Party/pugl/src/stub.h"
+
+#include "Third Party/pugl/gl.h"
+#include "Third Party/pugl/pugl.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <time.h>
+#endif
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+struct PuglWorldInternalsImpl {
+  int unused;
+};
+
+struct PuglInternalsImpl {
+  int unused;
+};
+
+PuglWorldInternals*
+puglInitWorldInternals(PuglWorldType type, PuglWorldFlags flags)
+{
+  (void)type;
+  (void)flags;
+  return (PuglWorldInternals*)PUGL_CALLOC(1, sizeof(PuglWorldInternals));
+}
+
+void
+puglFreeWorldInternals(PuglWorld* world)
+{
+  PUGL_FREE(world->impl);
+}
+
+PuglInternals*
+puglInitViewInternals(PuglWorld* world)
+{
+  (void)world;
+  return (PuglInternals*)PUGL_CALLOC(1, sizeof(PuglInternals));
+}
+
+void
+puglFreeViewInternals(PuglView* view)
+{
+  if (view) {
+    PUGL_FREE(view->impl);
+  }
+}
+
+PuglStatus
+puglRealize(PuglView* view)
+{
+  (void)view;
+  return PUGL_UNSUPPORTED;
+}
+
+PuglStatus
+puglUnrealize(PuglView* view)
+{
+  (void)view;
+  return PUGL_FAILURE;
+}
+
+PuglStatus
+puglShow(PuglView* view, PuglShowCommand command)
+{
+  (void)view;
+  (void)command;
+  return PUGL_UNSUPPORTED;
+}
+
+PuglStatus
+puglHide(PuglView* view)
+{
+  (void)view;
+  return PUGL_UNSUPPORTED;
+}
+
+PuglStatus
+puglViewStringChanged(PuglView* view, PuglStringHint key, const char* value)
+{
+  (void)view;
+  (void)key;
+  (void)value;
+  return PUGL_SUCCESS;
+}
+
+PuglStatus
+puglSetSizeHint(PuglView*    view,
+                PuglSizeHint hint,
+                unsigned     width,
+                unsigned     height)
+{
+  return puglStoreSizeHint(view, hint, width, height);
+}
+
+PuglPoint
+puglGetAncestorCenter(const PuglView* view)
+{
+  (void)view;
+  const PuglPoint center = {0, 0};
+  return center;
+}
+
+double
+puglGetTime(const PuglWorld* world)
+{
+#ifdef _WIN32
+  LARGE_INTEGER count;
+  LARGE_INTEGER frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart / (double)frequency.QuadPart - world->startTime;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0) -
+         world->startTime;
+#endif
+}
+
+PuglStatus
+puglStartTimer(PuglView* view, uintptr_t id, double timeout)
+{
+  (void)view;
+  (void)id;
+  (void)timeout;
+  return PUGL_UNSUPPORTED;
+}
+
+PuglStatus
+puglStopTimer(PuglView* view, uintptr_t id)
+{
+  (void)view;
+  (void)id;
+  return PUGL_UNSUPPORTED;
+}
+
+PuglStatus
+puglSetCursor(PuglView* view, PuglCursor cursor)
+{
+  (void)view;
+  (void)cursor;
+  return PUGL_UNSUPPORTED;
+}
+
+PuglStatus
+puglSetClipboard(PuglView*   view,
+                 const char* type,
+                 const void* data,
+                 size_t      len)
+{
+  (void)view;
+  (void)type;
+  (void)data;
+  (void)len;
+  return PUGL_UNSUPPORTED;
+}
+
+const void*
+puglGetClipboard(PuglView* view, uint32_t typeIndex, size_t* len)
+{
+  (void)view;
+  (void)typeIndex;
+  *len = 0;
+  return NULL;
+}
+
+static PuglStatus
+puglHeadlessChange(PuglView*                    oldView,
+                   PuglView*                    newView,
+                   const PuglExposeEvent* const expose)
+{
+  (void)oldView;
+  (void)newView;
+  (void)expose;
+  return PUGL_SUCCESS;
+}
+
+PuglGlFunc
+puglGetProcAddress(const char* name)
+{
+  (void)name;
+  return NULL;
+}
+
+PuglStatus
+puglEnterContext(PuglView* view)
+{
+  (void)view;
+  return PUGL_UNSUPPORTED;
+}
+
+PuglStatus
+puglLeaveContext(PuglView* view)
+{
+  (void)view;
+  return PUGL_UNSUPPORTED;
+}
+
+void
+puglSwapBuffers(PuglView* view)
+{
+  (void)view;
+}
+
+const PuglBackend*
+puglGlBackend(void)
+{
+  static const PuglBackend backend = {puglStubConfigure,
+                                      puglStubCreate,
+                                      puglStubDestroy,
+                                      puglStubEnter,
+                                      puglStubLeave,
+                                      puglHeadlessChange,
+                                      puglStubGetContext};
+
+  return &backend;
+}
@@ -1176,8 +1176,6 @@ namespace satomi
     else if constexpr (sizeof(T) == 8) { SATOMI_ATOMIC_ASM(__UINT64_TYPE__, "q"); }
     else if constexpr (sizeof(T) == 16)
     {
-      struct alignas(16) uint128__ { SATOMI_U64 v[2]; } v;
-
     #if defined(__AVX__)
 
       // Intel Software Developer Manual Volume 3, Guaranteed Atomic Operations
@@ -1206,7 +1204,8 @@ namespace satomi
 
     #else
 
-      v = SATOMI_BIT_CAST(uint128__, value);
+      struct alignas(16) uint128__ { SATOMI_U64 v[2]; };
+      auto v = SATOMI_BIT_CAST(uint128__, value);
       __asm__ __volatile__
       (
         "movq %[target_lo], %%rax\n\t"
@@ -1788,7 +1787,8 @@ namespace satomi
         : [syscall_number] "Z" (SATOMI_SYS_FUTEX), [a] "r" (address),\
           [futex_op] "Z" (1 /*wake op*/ | 128 /*private flag*/),     \
           [count] "r" (waiters_to_wake_up)                           \
-        : "rax", "rdi", "rsi", "rdx", "r10"                          \
+        /* syscall overwrites rcx and r11 with the return address and flags */ \
+        : "rax", "rdi", "rsi", "rdx", "r10", "rcx", "r11", "memory"  \
       );
 
   #elif (defined (LINUX) || defined (__linux__)) && defined(__aarch64__)
@@ -1920,7 +1920,8 @@ namespace satomi
         : [result] "=r" (result)
         : [syscall_number] "Z" (SATOMI_SYS_FUTEX), [address] "r" (address),
           [futex_op] "Z" (SATOMI_WAIT_OP), [compare] "r" (compare), [timeout] "Z" (nullptr)
-        : "rax", "rdi", "rsi", "rdx", "r10"
+        // syscall overwrites rcx and r11 with the return address and flags
+        : "rax", "rdi", "rsi", "rdx", "r10", "rcx", "r11", "memory"
       );
 
     #elif defined(__aarch64__)
@@ -1945,7 +1946,8 @@ namespace satomi
 
       #undef SATOMI_WAIT_OP
 
-      if (!result && (-result) != 11 /*EAGAIN*/)
+      // 0 is a wakeup, EAGAIN means the value changed before we slept and EINTR is a signal
+      if (result && (-result) != 11 /*EAGAIN*/ && (-result) != 4 /*EINTR*/)
         __builtin_trap();
 
     #elif defined (__APPLE__)
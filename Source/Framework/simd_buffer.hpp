@@ -55,7 +55,11 @@ namespace Framework
       byte *memory = allocator.insert(totalSize, alignof(simd_float), clean);
       (void)new(memory + extra) simd_float[dataSize];
 
-      return new(memory) Framework::SimdBuffer{ .channels = channels, .size = size };
+      // not aggregate initialised because gcc refuses to do that for types with FAMs
+      auto *buffer = new(memory) Framework::SimdBuffer;
+      buffer->channels = channels;
+      buffer->size = size;
+      return buffer;
     }
   };
 
@@ -161,8 +165,21 @@ namespace Framework
     // SoundEngine::blockPosition_ copy to store in buffers
     u32 blockPosition = 0;
     const SimdBuffer *sourceBuffer = nullptr;
+    // same as sourceBuffer if it's owned by a module earlier in the chain and nobody else reads it,
+    // null if it's shared (input buffers, other lanes' outputs)
+    // InPlaceTag effects write into it directly, so bins they don't touch are carried forward without copying
+    SimdBuffer *writableBuffer = nullptr;
     u32 simdChannelOffset = 0;
     // scratch buffer for to be used during processing, initial data is undefined
     SimdBuffer *scratchBuffer = nullptr;
+    // squared magnitudes of sourceBuffer's bins, filled by the first reader (see utils::getSourcePowers)
+    // and shared by the rest until a module writes new data
+    SimdBuffer *powerBuffer = nullptr;
+    // which simd channel of sourceBuffer the powers are for, kNoPowers if they are stale
+    u32 powersSimdChannel = kNoPowers;
+
+    static constexpr u32 kNoPowers = (u32)-1;
+
+    void invalidatePowers() noexcept { powersSimdChannel = kNoPowers; }
   };
 }
@@ -77,20 +77,24 @@ namespace utils
   }
 
   // [cos(angle[0]), sin(angle[1]), cos(angle[2]), sin(angle[3])]
+  // both lanes of a pair have to hold the same angle, they're swapped around depending on its quadrant
+  // max error of either component over [-pi, pi]: Fast - 26 ulp, Medium - 2 ulp, Accurate - 1.9 ulp
+  // Fast/Medium only hold that for components down to 2^-15, closer to a multiple of 90 degrees the error of
+  // the range reduction doubles with every halving, and within an ulp of it the exact 0/1 of that multiple comes out
+  // over [-100pi, 100pi] the reduction error grows with the angle, Fast/Medium hold their bounds for components
+  // down to 2^-7 and Accurate for components down to 2^-19
+  template<MathPrecision Precision = MathPrecision::Medium>
   forceinline simd_float vectorcall
   cis(simd_float angle)
   {
-    // split pi / 2 into multiple parts to take advantage of the
+    // split -pi / 2 into multiple parts to take advantage of the
     // hidden GRS bits during subtraction for more accurate radian wrapping
-    static constexpr simd_float kHalfPiPart1 = 1.5703125f;
-    static constexpr simd_float kHalfPiPart2 = 0.0004838267953f;
-
-    // modified taylor coefficients of { cos, sin }
-    static constexpr simd_float k0 = { 1.0f, 0.0f };
-    static constexpr simd_float k1 = { -0.5f, 1.0f };
-    static constexpr simd_float k2 = { 0.0416666459f, -0.166666518f };
-    static constexpr simd_float k3 = { -0.0013887321f, 0.00833202855f };
-    static constexpr simd_float k4 = { 0.000024433157f, -0.0001950085f };
+    // negated so that each part is subtracted with a single fused multiply-add
+    static constexpr simd_float kNegHalfPiPart1 = -1.5703125f;
+    static constexpr simd_float kNegHalfPiPart2 = -0.0004838267953f;
+    // the second part is split once more for the accurate version
+    static constexpr simd_float kNegHalfPiPart2Rounded = -4.837512969970703125e-4f;
+    static constexpr simd_float kNegHalfPiPart3 = -7.54978995489188216e-8f;
 
     static constexpr simd_float k2InvPi = 2.0f / kPi;
     // adding this forces the value to get rounded to int (only the lower 23 bits are valid) and
@@ -106,7 +110,14 @@ namespace utils
     // extra masking is to guard against nefarious bits left by fast math
     simd_mask exactMask = simd_float::equal(roundedFloat, normalisedInput & simd_mask{ ~1U });
 
-    simd_float position = angle - (roundedFloat * kHalfPiPart1) - (roundedFloat * kHalfPiPart2);
+    // fused explicitly, the bounds above don't hold if the products are rounded on their own
+    // and whether the compiler contracts them depends on the optimisation level
+    simd_float position = simd_float::mulAdd(angle, roundedFloat, kNegHalfPiPart1);
+    if constexpr (Precision == MathPrecision::Accurate)
+      position = simd_float::mulAdd(simd_float::mulAdd(position, roundedFloat, kNegHalfPiPart2Rounded),
+        roundedFloat, kNegHalfPiPart3);
+    else
+      position = simd_float::mulAdd(position, roundedFloat, kNegHalfPiPart2);
     simd_float position2 = position * position;
 
     // LSB/LSB+1 represents a 90/180 degree rotation
@@ -114,10 +125,51 @@ namespace utils
     simd_mask signs = shiftLeft<30>((roundedInt + (lowestMantissaBit & kRealMask)) & 2);
     simd_mask quadrantMask = simd_int::equal(lowestMantissaBit, 0);
 
-    // simple taylor series
-    simd_float values = simd_float::mulAdd(k0, merge(position, position2, kRealMask),
-      simd_float::mulAdd(k1, position2, simd_float::mulAdd(k2, position2, simd_float::mulAdd(k3, position2, k4))));
-    values = merge(values, kExact, exactMask);
+    // polynomials of { cos, sin } evaluated together, sin has an extra multiplication by position
+    simd_float polynomial;
+    if constexpr (Precision == MathPrecision::Fast)
+    {
+      // minimax coefficients of { cos, sin } one degree lower than the medium ones
+      static constexpr simd_float k0 = { 0.999999972f, 0.0f };
+      static constexpr simd_float k1 = { -0.499998567f, 0.999998569f };
+      static constexpr simd_float k2 = { 0.0416550269f, -0.166624802f };
+      static constexpr simd_float k3 = { -0.00135859085f, 0.00815163558f };
+
+      polynomial = simd_float::mulAdd(k0, merge(position, position2, kRealMask),
+        simd_float::mulAdd(k1, position2, simd_float::mulAdd(k2, position2, k3)));
+    }
+    else if constexpr (Precision == MathPrecision::Medium)
+    {
+      // modified taylor coefficients of { cos, sin }
+      static constexpr simd_float k0 = { 1.0f, 0.0f };
+      static constexpr simd_float k1 = { -0.5f, 1.0f };
+      static constexpr simd_float k2 = { 0.0416666459f, -0.166666518f };
+      static constexpr simd_float k3 = { -0.0013887321f, 0.00833202855f };
+      static constexpr simd_float k4 = { 0.000024433157f, -0.0001950085f };
+
+      polynomial = simd_float::mulAdd(k0, merge(position, position2, kRealMask),
+        simd_float::mulAdd(k1, position2, simd_float::mulAdd(k2, position2, simd_float::mulAdd(k3, position2, k4))));
+    }
+    else
+    {
+      // minimax coefficients of { cos, sin } one degree higher than the medium ones
+      static constexpr simd_float k0 = { 1.0f, 0.0f };
+      static constexpr simd_float k1 = { -0.5f, 1.0f };
+      static constexpr simd_float k2 = { 0.0416666665f, -0.166666666f };
+      static constexpr simd_float k3 = { -0.00138888804f, 0.00833332879f };
+      static constexpr simd_float k4 = { 2.47989297e-05f, -0.000198392031f };
+      static constexpr simd_float k5 = { -2.71734888e-07f, 2.71735322e-06f };
+
+      polynomial = simd_float::mulAdd(k0, merge(position, position2, kRealMask),
+        simd_float::mulAdd(k1, position2, simd_float::mulAdd(k2, position2,
+          simd_float::mulAdd(k3, position2, simd_float::mulAdd(k4, position2, k5)))));
+    }
+
+    // the exact check also catches angles within an ulp of a multiple of 90 degrees,
+    // the accurate version reduces them well enough to not need it
+    simd_float values = polynomial;
+    if constexpr (Precision != MathPrecision::Accurate)
+      values = merge(values, kExact, exactMask);
     values = merge(switchInner(values), values, quadrantMask) ^ signs;
     return values;
   }
@@ -215,6 +267,25 @@ namespace utils
     return (toSqrt) ? simd_float::sqrt(one) : one;
   }
 
+  // squared magnitudes of the source's bins, as given by complexMagnitude(bin, false)
+  // the first caller after the source has changed pays for them, later ones reuse them
+  inline utils::ca<const simd_float>
+  getSourcePowers(Framework::ComplexDataSource &source, u32 binCount, u32 simdChannel = 0)
+  {
+    COMPLEX_ASSERT(source.powerBuffer && source.powerBuffer->size >= binCount);
+
+    auto powers = source.powerBuffer->get();
+    if (source.powersSimdChannel != simdChannel)
+    {
+      auto data = source.sourceBuffer->get(simdChannel);
+      for (u32 i = 0; i < binCount; ++i)
+        powers[i] = complexMagnitude(data[i], false);
+      source.powersSimdChannel = simdChannel;
+    }
+
+    return { powers.pointer, binCount };
+  }
+
   forceinline simd_float vectorcall
   complexPhase(simd_float value)
   {
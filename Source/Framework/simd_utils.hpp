@@ -57,6 +57,24 @@ namespace utils
   #endif
   }
 
+  forceinline simd_float vectorcall toSimdFloatFromAligned(const float *aligned) noexcept
+  {
+  #if COMPLEX_SSE4_1
+    return _mm_load_ps(aligned);
+  #elif COMPLEX_NEON
+    return vld1q_f32(aligned);
+  #endif
+  }
+
+  forceinline void vectorcall storeSimdFloatToAligned(float *aligned, simd_float value) noexcept
+  {
+  #if COMPLEX_SSE4_1
+    _mm_store_ps(aligned, value.value);
+  #elif COMPLEX_NEON
+    vst1q_f32(aligned, value.value);
+  #endif
+  }
+
   forceinline void vectorcall transpose(utils::array<simd_float, simd_float::size> &rows)
   {
   #if COMPLEX_SSE4_1
@@ -551,17 +569,18 @@ namespace utils
 
 
 
+  // precision tiers of the transcendental approximations, chosen at compile time by the caller
+  //   Fast     - lowest degree polynomials, for values that get smoothed or only need to be in the ballpark
+  //   Medium   - default, same cost as the original approximations but refitted
+  // every tier is exact at whole exponents of exp2 and powers of 2 of log2, so pow(1, x) is exactly 1
+  //   Accurate - minimax polynomials with finer range reduction, close to what libm gives
+  // max errors are documented next to every function in ulp of the exact result, checked by the transcendental-accuracy test
+  enum class MathPrecision : u8 { Fast, Medium, Accurate };
+
+  // max error over [-126, 127]: Fast - 1350 ulp, Medium - 43 ulp, Accurate - 2.1 ulp
+  template<MathPrecision Precision = MathPrecision::Medium>
   forceinline simd_float vectorcall exp2(simd_float exponent) noexcept
   {
-    // taylor expansion of 2^x at 0
-    // coefficients are (ln(2)^n) / n!
-    static constexpr simd_float kCoefficient0 = 1.0f;
-    static constexpr simd_float kCoefficient1 = 16970.0f / 24483.0f;
-    static constexpr simd_float kCoefficient2 = 1960.0f / 8161.0f;
-    static constexpr simd_float kCoefficient3 = 1360.0f / 24483.0f;
-    static constexpr simd_float kCoefficient4 = 80.0f / 8161.0f;
-    static constexpr simd_float kCoefficient5 = 32.0f / 24483.0f;
-
     // the closer the exponent is to a whole number, the more accurate it's going to be
     // since it only requires to add it the overall floating point exponent
     simd_float rounded = simd_float::round(exponent);
@@ -569,51 +588,162 @@ namespace utils
     // clamp the lowest value otherwise get garbage results when shifting left
     simd_float power = reinterpretToFloat(shiftLeft<23>(simd_int::maxSigned((u32)-127, toInt(rounded)) + 127));
 
-    // we exp2 whatever decimal number is left with the taylor series
-    // the domain we're in is [0.0f, 0.5f], we don't expect negative numbers
-    simd_float interpolate = simd_float::mulAdd(kCoefficient0, t,
-      simd_float::mulAdd(kCoefficient1, t, simd_float::mulAdd(kCoefficient2, t,
-        simd_float::mulAdd(kCoefficient3, t, simd_float::mulAdd(kCoefficient4, t, kCoefficient5)))));
+    // we exp2 whatever decimal number is left with a polynomial
+    // the domain we're in is [-0.5f, 0.5f], the constant term is exactly 1 so that whole exponents are exact
+    simd_float interpolate;
+    if constexpr (Precision == MathPrecision::Fast)
+    {
+      // minimax fit of (2^x - 1) / x
+      static constexpr simd_float kCoefficient0 = 1.0f;
+      static constexpr simd_float kCoefficient1 = 0.693282962f;
+      static constexpr simd_float kCoefficient2 = 0.242211208f;
+      static constexpr simd_float kCoefficient3 = 0.0550090298f;
+
+      interpolate = simd_float::mulAdd(kCoefficient0, t,
+        simd_float::mulAdd(kCoefficient1, t, simd_float::mulAdd(kCoefficient2, t, kCoefficient3)));
+    }
+    else if constexpr (Precision == MathPrecision::Medium)
+    {
+      // minimax fit of (2^x - 1) / x
+      static constexpr simd_float kCoefficient0 = 1.0f;
+      static constexpr simd_float kCoefficient1 = 0.693124175f;
+      static constexpr simd_float kCoefficient2 = 0.240240991f;
+      static constexpr simd_float kCoefficient3 = 0.0559064522f;
+      static constexpr simd_float kCoefficient4 = 0.00958286412f;
+
+      interpolate = simd_float::mulAdd(kCoefficient0, t,
+        simd_float::mulAdd(kCoefficient1, t, simd_float::mulAdd(kCoefficient2, t,
+          simd_float::mulAdd(kCoefficient3, t, kCoefficient4))));
+    }
+    else
+    {
+      // minimax fit of (2^x - 1) / x
+      static constexpr simd_float kCoefficient0 = 1.0f;
+      static constexpr simd_float kCoefficient1 = 0.693147004f;
+      static constexpr simd_float kCoefficient2 = 0.240222424f;
+      static constexpr simd_float kCoefficient3 = 0.0555073358f;
+      static constexpr simd_float kCoefficient4 = 0.00967151579f;
+      static constexpr simd_float kCoefficient5 = 0.00132647355f;
+
+      interpolate = simd_float::mulAdd(kCoefficient0, t,
+        simd_float::mulAdd(kCoefficient1, t, simd_float::mulAdd(kCoefficient2, t,
+          simd_float::mulAdd(kCoefficient3, t, simd_float::mulAdd(kCoefficient4, t, kCoefficient5)))));
+    }
 
     return power * interpolate;
   }
 
+  // max error over normal numbers: Fast - 43000 ulp, Medium - 850 ulp, Accurate - 1.5 ulp
+  template<MathPrecision Precision = MathPrecision::Medium>
   forceinline simd_float vectorcall log2(simd_float value) noexcept
   {
-    // i have no idea how these coefficients were derived
-    static constexpr simd_float kCoefficient0 = -1819.0f / 651.0f;
-    static constexpr simd_float kCoefficient1 = 5.0f;
-    static constexpr simd_float kCoefficient2 = -10.0f / 3.0f;
-    static constexpr simd_float kCoefficient3 = 10.0f / 7.0f;
-    static constexpr simd_float kCoefficient4 = -1.0f / 3.0f;
-    static constexpr simd_float kCoefficient5 = 1.0f / 31.0f;
-
     static constexpr simd_mask mantissaMask = kFloatMantissaMask;
     static constexpr simd_mask exponentOffset = 0x7f << 23;
 
-    // effectively log2s only the exponent; gets it in terms an int
-    simd_int flooredLog2 = shiftRight<23>(reinterpretToInt(value)) - 0x7f;
-    // 0x7fffff masks the entire mantissa
-    // then we bring the exponent to 2^0 to get the entire number between [1, 2]
-    simd_float t = (value & mantissaMask) | exponentOffset;
+    // offsetting by sqrt(0.5) moves the mantissa into [sqrt(0.5), sqrt(2)),
+    // where log(1 + x) is centered around 0 and converges much quicker
+    // values on either side of 1 then come out relative to their (small) result
+    // instead of -1 + log2(mantissa) cancelling out for values just below it
+    static constexpr u32 kSqrtHalfOffset = 0x3f800000 - 0x3f3504f3;
+
+    simd_int offsetValue = reinterpretToInt(value) + kSqrtHalfOffset;
+    simd_int flooredLog2 = shiftRight<23>(offsetValue) - 0x7f;
+    simd_float x = reinterpretToFloat((offsetValue & mantissaMask) - kSqrtHalfOffset + exponentOffset) - 1.0f;
 
-    // we log2 the mantissa with the taylor series coefficients
-    simd_float interpolate = simd_float::mulAdd(kCoefficient2, t, simd_float::mulAdd(kCoefficient3, t,
-      simd_float::mulAdd(kCoefficient4, t, kCoefficient5)));
-    interpolate = simd_float::mulAdd(kCoefficient0, t, simd_float::mulAdd(kCoefficient1, t, interpolate));
+    if constexpr (Precision == MathPrecision::Accurate)
+    {
+      // minimax coefficients of (log(1 + x) - x + x^2 / 2) / x^3
+      static constexpr simd_float kCoefficient0 = 3.3333331174e-1f;
+      static constexpr simd_float kCoefficient1 = -2.4999993993e-1f;
+      static constexpr simd_float kCoefficient2 = 2.0000714765e-1f;
+      static constexpr simd_float kCoefficient3 = -1.6668057665e-1f;
+      static constexpr simd_float kCoefficient4 = 1.4249322787e-1f;
+      static constexpr simd_float kCoefficient5 = -1.2420140846e-1f;
+      static constexpr simd_float kCoefficient6 = 1.1676998740e-1f;
+      static constexpr simd_float kCoefficient7 = -1.1514610310e-1f;
+      static constexpr simd_float kCoefficient8 = 7.0376836292e-2f;
+
+      simd_float x2 = x * x;
+
+      simd_float interpolate = simd_float::mulAdd(kCoefficient4, x, simd_float::mulAdd(kCoefficient5, x,
+        simd_float::mulAdd(kCoefficient6, x, simd_float::mulAdd(kCoefficient7, x, kCoefficient8))));
+      interpolate = simd_float::mulAdd(kCoefficient0, x, simd_float::mulAdd(kCoefficient1, x,
+        simd_float::mulAdd(kCoefficient2, x, simd_float::mulAdd(kCoefficient3, x, interpolate))));
+      interpolate = simd_float::mulAdd(x, x2, simd_float::mulAdd(-0.5f, x, interpolate));
+
+      return simd_float::mulAdd(toFloat(flooredLog2), interpolate, kExpConversionMult);
+    }
+    else
+    {
+      // the polynomial is a multiple of x, which is exactly 0 at powers of 2
+      simd_float interpolate;
+      if constexpr (Precision == MathPrecision::Fast)
+      {
+        // minimax fit of log2(1 + x) / x over [sqrt(0.5) - 1, sqrt(2) - 1], in relative error
+        static constexpr simd_float kCoefficient0 = 1.44417703f;
+        static constexpr simd_float kCoefficient1 = -0.751134753f;
+        static constexpr simd_float kCoefficient2 = 0.449609697f;
+
+        interpolate = simd_float::mulAdd(kCoefficient0, x, simd_float::mulAdd(kCoefficient1, x, kCoefficient2));
+      }
+      else
+      {
+        // minimax fit of log2(1 + x) / x over [sqrt(0.5) - 1, sqrt(2) - 1], in relative error
+        static constexpr simd_float kCoefficient0 = 1.44264627f;
+        static constexpr simd_float kCoefficient1 = -0.720554948f;
+        static constexpr simd_float kCoefficient2 = 0.485306501f;
+        static constexpr simd_float kCoefficient3 = -0.390892446f;
+        static constexpr simd_float kCoefficient4 = 0.254751861f;
+
+        interpolate = simd_float::mulAdd(kCoefficient0, x, simd_float::mulAdd(kCoefficient1, x,
+          simd_float::mulAdd(kCoefficient2, x, simd_float::mulAdd(kCoefficient3, x, kCoefficient4))));
+      }
 
-    // we add the int with the mantissa to get our final result
-    return toFloat(flooredLog2) + interpolate;
+      // we add the int with the mantissa to get our final result
+      return simd_float::mulAdd(toFloat(flooredLog2), x, interpolate);
+    }
   }
 
+  template<MathPrecision Precision = MathPrecision::Medium>
   forceinline simd_float vectorcall exp(simd_float exponent) noexcept
-  { return exp2(exponent * kExpConversionMult); }
+  { return exp2<Precision>(exponent * kExpConversionMult); }
 
+  template<MathPrecision Precision = MathPrecision::Medium>
   forceinline simd_float vectorcall log(simd_float value) noexcept
-  { return log2(value) * kLogConversionMult; }
+  { return log2<Precision>(value) * kLogConversionMult; }
 
+  // the error of log2 gets scaled by the exponent, so large exponents need higher precision
+  template<MathPrecision Precision = MathPrecision::Medium>
   forceinline simd_float vectorcall pow(simd_float base, simd_float exponent) noexcept
-  { return exp2(log2(base) * exponent); }
+  { return exp2<Precision>(log2<Precision>(base) * exponent); }
+
+  // max error over normal numbers: Fast - 5000 ulp on sse / 2^-8 relative on neon,
+  // Medium - 4 ulp on sse / 2^-16 relative on neon, Accurate - 1.5 ulp
+  template<MathPrecision Precision = MathPrecision::Medium>
+  forceinline simd_float vectorcall invSqrt(simd_float value) noexcept
+  {
+    if constexpr (Precision == MathPrecision::Fast)
+      return simd_float::invSqrt(value);
+    else if constexpr (Precision == MathPrecision::Medium)
+    {
+      // single newton-raphson step on top of the estimate
+      simd_float estimate = simd_float::invSqrt(value);
+      return estimate * simd_float::mulAdd(1.5f, value * -0.5f, estimate * estimate);
+    }
+    else
+      return simd_float{ 1.0f } / simd_float::sqrt(value);
+  }
+
+  // max error over normal numbers: Fast - 4100 ulp on sse, Medium - 4.1 ulp on sse, Accurate - 0.5 ulp
+  template<MathPrecision Precision = MathPrecision::Medium>
+  forceinline simd_float vectorcall sqrt(simd_float value) noexcept
+  {
+    if constexpr (Precision == MathPrecision::Accurate)
+      return simd_float::sqrt(value);
+    else
+      // the estimate of 0 is inf
+      return (value * invSqrt<Precision>(value)) & simd_float::greaterThan(value, 0.0f);
+  }
 
   forceinline simd_float vectorcall midiOffsetToRatio(simd_float note_offset) noexcept
   { return exp2(note_offset * (1.0f / kNotesPerOctave)); }
@@ -622,12 +752,17 @@ namespace utils
   { return midiOffsetToRatio(note) * kMidi0Frequency; }
 
   // fast approximation of the original equation
+  // max error over normal numbers: Fast - 43000 ulp, Medium - 850 ulp, Accurate - 2.1 ulp
+  template<MathPrecision Precision = MathPrecision::Medium>
   forceinline simd_float vectorcall amplitudeToDb(simd_float magnitude) noexcept
-  { return log2(magnitude) * kAmplitudeToDbConversionMult; }
+  { return log2<Precision>(magnitude) * kAmplitudeToDbConversionMult; }
 
   // fast approximation of the original equation
+  // max error over [-120, 24] dB: Fast - 1400 ulp, Medium - 54 ulp, Accurate - 12.5 ulp
+  // more than exp2's because rounding the scaled decibels gets amplified by the size of the exponent
+  template<MathPrecision Precision = MathPrecision::Medium>
   forceinline simd_float vectorcall dbToAmplitude(simd_float decibels) noexcept
-  { return exp2(decibels * kDbToAmplitudeConversionMult); }
+  { return exp2<Precision>(decibels * kDbToAmplitudeConversionMult); }
 
   forceinline simd_float vectorcall normalisedToDb(simd_float normalised, float maxDb) noexcept
   { return pow(maxDb + 1.0f, normalised) - 1.0f; }
@@ -11,11 +11,16 @@
 #if COMPLEX_SSE4_1
   #include <smmintrin.h>
 
-  extern "C"
-  {
-    __m128 _mm_fmadd_ps(__m128, __m128, __m128);
-    __m128 _mm_fmsub_ps(__m128, __m128, __m128);
-  }
+  #if COMPLEX_FMA && COMPLEX_GCC
+    // gcc only defines these as inline functions in its own headers
+    #include <immintrin.h>
+  #else
+    extern "C"
+    {
+      __m128 _mm_fmadd_ps(__m128, __m128, __m128);
+      __m128 _mm_fmsub_ps(__m128, __m128, __m128);
+    }
+  #endif
 #elif COMPLEX_NEON
   #include <arm_neon.h>
 #else
@@ -203,10 +203,13 @@ namespace utils
   inline constexpr bool is_base_of_v = __is_base_of(Base, Derived);
   template<typename From, typename To>
   inline constexpr bool is_convertible_v =
-#if defined(__GNUC__) && !defined(__clang__)
+#if __has_builtin(__is_convertible)
     __is_convertible(From, To);
-#else
+#elif __has_builtin(__is_convertible_to)
     __is_convertible_to(From, To);
+#else
+    // gcc < 13 has neither builtin
+    requires (void (&sink)(To), From (&source)()) { sink(source()); };
 #endif
   template<class T, template<typename ...> class Template>
   inline constexpr bool is_specialization_v = false;
@@ -356,7 +359,8 @@ namespace utils
   template<typename T>
   struct deferAtHome
   {
-    const T &f;
+    // held by value, the lambda is a temporary that dies at the end of the defer statement
+    T f;
     deferAtHome(const T &f) : f{ f } { }
     ~deferAtHome() { f(); }
   };
@@ -1267,6 +1271,8 @@ namespace utils
   // free replacement
   void deallocate(const void *memory);
 
+  // granularity of reserve/commit/lock operations
+  usize getPageSize();
   // acquires a contiguous block of virtual memory
   // cannot be used as a resource yet
   //
@@ -1291,4 +1297,26 @@ namespace utils
   // tries to lower private memory pages (memory usage) as much as possible
   // useful for getting rid of pages that are never accessed again (i.e. OpenGl init resources)
   void shrinkWorkingSet();
+  // touches every page overlapping [memory, memory + size) so that the first real access doesn't fault
+  //
+  // memory must be committed, contents are preserved and only bytes inside the range are touched
+  void prefaultMemory(void *memory, usize size);
+  // pins the pages overlapping the range in physical memory
+  // best effort, fails if the OS limit on locked memory is reached
+  bool lockMemory(void *memory, usize size);
+  // unpins only the pages fully contained in the range, edge pages might be shared with other allocations
+  void unlockMemory(void *memory, usize size);
+  // hints that the range should be backed by huge pages
+  // only transparent huge pages on linux are supported, no-op everywhere else
+  void adviseHugePages(void *memory, usize size);
+  // total number of page faults (soft + hard) so far,
+  // counted for the calling thread where supported (linux) and for the whole process otherwise
+  u64 getPageFaultCount();
+  // maps a whole file read-only, size is set to the size of the file
+  // returns nullptr if the file can't be opened or is empty
+  const byte *mapFile(const char *path, usize &size);
+  // size MUST be equal to the size returned by mapFile
+  void unmapFile(const void *memory, usize size);
+  // number of logical processors that are currently online
+  u32 getProcessorCount();
 }
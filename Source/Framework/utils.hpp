@@ -957,6 +957,8 @@ namespace utils
 
 
   void millisleep() noexcept;
+  // monotonic timestamp, only useful for measuring durations
+  u64 getMonotonicMicroseconds() noexcept;
 
   void setHighResolutionClock(bool isHighResolution);
 
@@ -1022,6 +1024,99 @@ namespace utils
   template<typename T>
   struct ReentrantLock : LockBlame<T> { };
 
+#if COMPLEX_AUDIO_THREAD_GUARD
+  // while a thread is marked as the audio thread, every arena insert/resize/remove,
+  // non-Spin lock and lock wait longer than maxLockWaitUs is recorded with its call site
+  //
+  // recording is lock-free and doesn't allocate, entries past kLogSize unread ones are dropped
+  // but still counted in violationCount
+  struct AudioThreadGuard
+  {
+    enum ViolationType : u8 { ArenaInsert, ArenaResize, ArenaRemove, BlockingLock, LongLockWait };
+
+    struct Violation
+    {
+      sourceLocation location{};
+      u64 waitUs{};
+      ViolationType type{};
+    };
+
+    static constexpr usize kLogSize = 256;
+
+    static inline satomi::atomic<u64> maxLockWaitUs = 50;
+
+    static bool isAudioThread() noexcept { return isAudioThread_; }
+    static void record(ViolationType type, sourceLocation location, u64 waitUs = 0) noexcept;
+    // copies unread violations to destination and returns how many were copied
+    // safe to call from several threads, every violation is copied by only one of them
+    static usize drain(span<Violation> destination) noexcept;
+    static u64 getViolationCount() noexcept { return violationCount_.load(satomi::memory_order_relaxed); }
+
+    // reports blocking locks and times the acquisition for the lifetime of the object
+    // only locks that were already held are timed, otherwise the thread being preempted
+    // while taking a free lock would show up as a wait
+    struct LockWatch
+    {
+      LockWatch(WaitMechanism mechanism, bool isHeld, sourceLocation location) noexcept : location{ location }
+      {
+        if (!isAudioThread_)
+          return;
+
+        if (mechanism != WaitMechanism::Spin)
+          record(BlockingLock, location);
+        if (isHeld)
+          start = getMonotonicMicroseconds();
+      }
+      ~LockWatch() noexcept
+      {
+        if (!start)
+          return;
+
+        u64 waitUs = getMonotonicMicroseconds() - start;
+        if (waitUs > maxLockWaitUs.load(satomi::memory_order_relaxed))
+          record(LongLockWait, location, waitUs);
+      }
+      LockWatch(const LockWatch &) = delete;
+      LockWatch &operator=(const LockWatch &) = delete;
+
+      sourceLocation location;
+      u64 start = 0;
+    };
+
+    // marks the current thread as the audio thread for the lifetime of the scope
+    struct Scope
+    {
+      Scope() noexcept : wasAudioThread{ isAudioThread_ } { isAudioThread_ = true; }
+      ~Scope() noexcept { isAudioThread_ = wasAudioThread; }
+      Scope(const Scope &) = delete;
+      Scope &operator=(const Scope &) = delete;
+
+      bool wasAudioThread;
+    };
+
+  private:
+    struct Entry
+    {
+      // index + 1 of the write that last published this entry, 0 if never written
+      satomi::atomic<u64> sequence{};
+      Violation violation{};
+    };
+
+    static thread_local bool isAudioThread_;
+    static inline satomi::atomic<u64> violationCount_{};
+    static inline satomi::atomic<u64> writeIndex_{};
+    static inline satomi::atomic<u64> readIndex_{};
+    static Entry log_[kLogSize];
+  };
+
+  #define COMPLEX_AUDIO_THREAD_RECORD(type, location) \
+    do { if (::utils::AudioThreadGuard::isAudioThread()) ::utils::AudioThreadGuard::record(::utils::AudioThreadGuard::type, location); } while (false)
+  #define COMPLEX_AUDIO_THREAD_WATCH_LOCK(mechanism, isHeld, location) ::utils::AudioThreadGuard::LockWatch lockWatch__{ mechanism, isHeld, location }
+#else
+  #define COMPLEX_AUDIO_THREAD_RECORD(type, location) ((void)0)
+  #define COMPLEX_AUDIO_THREAD_WATCH_LOCK(mechanism, isHeld, location) ((void)0)
+#endif
+
   inline void lockAtomic(satomi::atomic<bool> &atomic, WaitMechanism mechanism, bool expected = false)
   {
     bool state = expected;
@@ -1097,18 +1192,33 @@ namespace utils
       lock.lastLockId.store({}, satomi::memory_order_relaxed);
   }
 
+  // whether taking the lock right now would have to wait
+  inline bool isLockHeld(const satomi::atomic<i32> &atomic, bool isExclusive) noexcept
+  {
+    i32 state = atomic.load(satomi::memory_order_relaxed);
+    return (isExclusive) ? state != 0 : state < 0;
+  }
+
   class ScopedLock
   {
   public:
     ScopedLock() : type_{ Empty }, mechanism_{ WaitMechanism::Spin }, bool_{} { }
 
-    ScopedLock(satomi::atomic<bool> &atomic, WaitMechanism mechanism, bool expected = false) noexcept :
+    // call site locations are only used for audio thread instrumentation, see AudioThreadGuard
+
+    ScopedLock(satomi::atomic<bool> &atomic, WaitMechanism mechanism, bool expected = false,
+      [[maybe_unused]] sourceLocation location = sourceLocation::current()) noexcept :
       type_(BoolEnum), mechanism_(mechanism), bool_{ &atomic, expected }
-    { lockAtomic(atomic, mechanism, expected); }
+    {
+      COMPLEX_AUDIO_THREAD_WATCH_LOCK(mechanism, atomic.load(satomi::memory_order_relaxed) != expected, location);
+      lockAtomic(atomic, mechanism, expected);
+    }
 
-    ScopedLock(ReentrantLock<bool> &reentrantLock, WaitMechanism mechanism, bool expected = false) noexcept :
+    ScopedLock(ReentrantLock<bool> &reentrantLock, WaitMechanism mechanism, bool expected = false,
+      [[maybe_unused]] sourceLocation location = sourceLocation::current()) noexcept :
       type_(ReentrantBoolEnum), mechanism_(mechanism), reentrantBool_{ &reentrantLock, false, expected }
     {
+      COMPLEX_AUDIO_THREAD_WATCH_LOCK(mechanism, reentrantLock.lock.load(satomi::memory_order_relaxed) != expected, location);
       auto threadId = utils::thread::getCurrentId();
       reentrantBool_.wasLocked = threadId == reentrantLock.lastLockId.load(satomi::memory_order_relaxed);
 
@@ -1119,17 +1229,29 @@ namespace utils
       }
     }
 
-    ScopedLock(satomi::atomic<i32> &atomic, bool isExclusive, WaitMechanism mechanism) noexcept :
+    ScopedLock(satomi::atomic<i32> &atomic, bool isExclusive, WaitMechanism mechanism,
+      [[maybe_unused]] sourceLocation location = sourceLocation::current()) noexcept :
       type_{ I32LockEnum }, mechanism_{ mechanism }, i32_{ &atomic, isExclusive }
-    { lockAtomic(atomic, isExclusive, mechanism); }
+    {
+      COMPLEX_AUDIO_THREAD_WATCH_LOCK(mechanism, isLockHeld(atomic, isExclusive), location);
+      lockAtomic(atomic, isExclusive, mechanism);
+    }
 
-    ScopedLock(ReentrantLock<i32> &reentrantLock, bool isExclusive, WaitMechanism mechanism) noexcept :
+    ScopedLock(ReentrantLock<i32> &reentrantLock, bool isExclusive, WaitMechanism mechanism,
+      [[maybe_unused]] sourceLocation location = sourceLocation::current()) noexcept :
       type_{ I32LockEnum }, mechanism_{ mechanism }, i32Lock_{ &reentrantLock, isExclusive }
-    { i32Lock_.previousValue = lockAtomic(reentrantLock, true, isExclusive, mechanism); }
+    {
+      COMPLEX_AUDIO_THREAD_WATCH_LOCK(mechanism, isLockHeld(reentrantLock.lock, isExclusive), location);
+      i32Lock_.previousValue = lockAtomic(reentrantLock, true, isExclusive, mechanism);
+    }
 
-    ScopedLock(LockBlame<i32> &lock, bool isExclusive, WaitMechanism mechanism) noexcept : 
+    ScopedLock(LockBlame<i32> &lock, bool isExclusive, WaitMechanism mechanism,
+      [[maybe_unused]] sourceLocation location = sourceLocation::current()) noexcept :
       type_{ I32LockEnum }, mechanism_{ mechanism }, i32Lock_{ &lock, isExclusive }
-    { i32Lock_.previousValue = lockAtomic(lock, false, isExclusive, mechanism); }
+    {
+      COMPLEX_AUDIO_THREAD_WATCH_LOCK(mechanism, isLockHeld(lock.lock, isExclusive), location);
+      i32Lock_.previousValue = lockAtomic(lock, false, isExclusive, mechanism);
+    }
 
     ScopedLock(ScopedLock &&other) noexcept = delete;
     ScopedLock &operator=(ScopedLock &&other) noexcept
@@ -1178,11 +1300,26 @@ namespace utils
   };
 }
 
+namespace utils
+{
+  class string;
+}
+
 namespace Interface
 {
   // adapted from https://github.com/thegabman/native_message_box/blob/master/include/NMB/NMB.h
   enum class MessageBoxType { Info, Warning, Error };
   bool showNativeMessageBox(const char *title, const char *message, MessageBoxType type);
+
+  // while a thread has one of these set, its message boxes are appended to messages instead of being shown,
+  // so that work done on a background thread can have them shown by the main thread
+  struct DeferredMessageBoxes
+  {
+    utils::string *messages;
+    // the most severe of the collected ones
+    MessageBoxType type = MessageBoxType::Info;
+  };
+  DeferredMessageBoxes *&getDeferredMessageBoxes();
 }
 
 // https://github.com/colugomusic/snd/blob/master/include/snd/const_math.hpp
@@ -4,6 +4,7 @@
 #include "windows.hpp"
 
 #include "utils.hpp"
+#include "memory.hpp"
 #include "simd_utils.hpp"
 #include "buffer.hpp"
 
@@ -74,11 +75,46 @@ namespace Framework
   float getLanczosWindow(float position, float alpha) noexcept
   { return utils::pow(utils::clamp(lanczosWindowLookup.linearLookup(position), 0.0f, 1.0f), alpha); }
 
-  static void applyDefaultWindows(Buffer &buffer, u32 channels, utils::span<bool> channelsToProcess,
+  static float getWindowValue(uuid windowType, float position, float alpha) noexcept
+  {
+    switch (windowType)
+    {
+    case Window::Hann:
+      return getHannWindow(position);
+    case Window::Hamming:
+      return getHammingWindow(position);
+    case Window::Triangle:
+      return getTriangleWindow(position);
+    case Window::Sine:
+      return getSineWindow(position);
+    case Window::Exponential:
+      return getExponentialWindow(position, alpha);
+    case Window::HannExp:
+      return getHannExponentialWindow(position, alpha);
+    case Window::Lanczos:
+      return getLanczosWindow(position, alpha);
+    case Window::Rectangle:
+    case Window::Lerp:
+    default:
+      return 1.0f;
+    }
+  }
+
+  static float quantiseAlpha(uuid windowType, float alpha) noexcept
+  {
+    // windows without an alpha all share the same table
+    if (windowType != Window::Exponential && windowType != Window::HannExp && windowType != Window::Lanczos)
+      return 0.0f;
+
+    return ::roundf(alpha * Window::kAlphaQuantisation) / Window::kAlphaQuantisation;
+  }
+
+  // returns the sum of the window over the whole frame
+  static float applyDefaultWindows(Buffer &buffer, u32 channels, utils::span<bool> channelsToProcess,
     u32 samples, uuid windowType, float alpha) noexcept
   {
-    if (windowType == Window::Lerp || windowType == Window::Rectangle)
-      return;
+    if (windowType == Window::Rectangle)
+      return (float)samples;
 
     float increment = 1.0f / (float)samples;
 
@@ -86,49 +122,13 @@ namespace Framework
     // omit the centre sample and we scale both explicitly
     // we can take advantage of window symmetry and do 2 multiplications with 1 lookup
     u32 halfLength = (samples - 2) / 2;
-
-    float window = 1.0f;
-    float position = 0.0f;
+    float windowSum = 0.0f;
 
     // applying window to first sample and middle
     {
-      float centerWindow = 1.0f;
+      float window = getWindowValue(windowType, 0.0f, alpha);
+      float centerWindow = getWindowValue(windowType, 0.5f, alpha);
       u32 centerSample = samples / 2;
-      switch (windowType)
-      {
-      case Window::Hann:
-        window = getHannWindow(position);
-        centerWindow = getHannWindow(0.5f);
-        break;
-      case Window::Hamming:
-        window = getHammingWindow(position);
-        centerWindow = getHammingWindow(0.5f);
-        break;
-      case Window::Triangle:
-        window = getTriangleWindow(position);
-        centerWindow = getTriangleWindow(0.5f);
-        break;
-      case Window::Sine:
-        window = getSineWindow(position);
-        centerWindow = getSineWindow(0.5f);
-        break;
-      case Window::Exponential:
-        window = getExponentialWindow(position, alpha);
-        centerWindow = getExponentialWindow(0.5f, alpha);
-        break;
-      case Window::HannExp:
-        window = getHannExponentialWindow(position, alpha);
-        centerWindow = getHannExponentialWindow(0.5f, alpha);
-        break;
-      case Window::Lanczos:
-        window = getLanczosWindow(position, alpha);
-        centerWindow = getLanczosWindow(0.5f, alpha);
-        break;
-      case Window::Rectangle:
-      case Window::Lerp:
-      default:
-        break;
-      }
       for (u32 j = 0; j < channels; j++)
       {
         if (!channelsToProcess[j])
@@ -138,39 +138,13 @@ namespace Framework
         data[0] *= window;
         data[centerSample] *= centerWindow;
       }
-      position += increment;
+      windowSum += window + centerWindow;
     }
 
-    for (u32 i = 1; i < halfLength; i++)
+    float position = increment;
+    for (u32 i = 1; i <= halfLength; i++)
     {
-      switch (windowType)
-      {
-      case Window::Hann:
-        window = getHannWindow(position);
-        break;
-      case Window::Hamming:
-        window = getHammingWindow(position);
-        break;
-      case Window::Triangle:
-        window = getTriangleWindow(position);
-        break;
-      case Window::Sine:
-        window = getSineWindow(position);
-        break;
-      case Window::Exponential:
-        window = getExponentialWindow(position, alpha);
-        break;
-      case Window::HannExp:
-        window = getHannExponentialWindow(position, alpha);
-        break;
-      case Window::Lanczos:
-        window = getLanczosWindow(position, alpha);
-        break;
-      case Window::Rectangle:
-      case Window::Lerp:
-      default:
-        break;
-      }
+      float window = getWindowValue(windowType, position, alpha);
 
       for (u32 j = 0; j < channels; j++)
       {
@@ -181,121 +155,251 @@ namespace Framework
         data[i] *= window;
         data[samples - i] *= window;
       }
+      windowSum += 2.0f * window;
       position += increment;
     }
-  }
 
-  void Window::applyWindow(Buffer &buffer, u32 channels, utils::span<bool> channelsToProcess,
-    u32 samples, uuid windowType, float alpha)
-  {
-    applyDefaultWindows(buffer, channels, channelsToProcess, samples, windowType, alpha);
+    return windowSum;
   }
 
-  void Window::addOverlap(CircularBuffer &destination, Buffer &source, u32 channels,
-    utils::span<bool> channelsToProcess, u32 samples, u32 destinationBegin, uuid windowType)
+  static void multiplyChannels(Buffer &buffer, u32 channels, utils::span<bool> channelsToProcess,
+    u32 samples, const float *multipliers, float gain) noexcept
   {
-    auto bufferSize = destination.size;
-    if (windowType == Lerp)
-    {
-      Framework::applyToBuffer(
-        [](float &destination, const float &source, float t) { destination = (1.0f - t) * destination + t * source; },
-        destination, source, channels, samples, destinationBegin, 0, channelsToProcess);
-    }
-    else
+    simd_float simdGain = gain;
+    for (u32 i = 0; i < channels; i++)
     {
-      // fading edges and overlapping
-      u32 fadeSamples = samples / 4;
-
-      // fade in overlap
-      Framework::applyToBuffer(
-        [](float &destination, const float &source, float t) { destination = (1.0f - t) * destination + t * (destination + source); },
-        destination, source, channels, fadeSamples, destinationBegin, 0, channelsToProcess);
-
-      // overlap
-      Framework::applyToBuffer(
-        [](float &destination, const float &source, float) { destination += source; },
-        destination, source, channels, samples - 2 * fadeSamples,
-        (destinationBegin + fadeSamples) % bufferSize, fadeSamples, channelsToProcess);
+      if (!channelsToProcess[i])
+        continue;
 
-      // fade out overlap
-      Framework::applyToBuffer(
-        [](float &destination, const float &source, float t) { destination = (1.0f - t) * (destination + source) + t * source; },
-        destination, source, channels, fadeSamples, (destinationBegin + samples - fadeSamples) % bufferSize,
-        samples - fadeSamples, channelsToProcess);
+      auto data = buffer.get(i);
+      for (u32 j = 0; j < samples; j += simd_float::size)
+        utils::storeSimdFloatToAligned(data + j, utils::toSimdFloatFromAligned(data + j) *
+          utils::toSimdFloatFromAligned(multipliers + j) * simdGain);
     }
   }
 
-  void Window::scaleDown(Buffer &buffer, u32 channels, utils::span<bool> channelsToProcess,
-    u32 start, u32 samples, uuid windowType, float overlap, float alpha)
+  // the window is normalised so that its overlapping copies sum to unity, where they overlap less than that too
+  static float getNormalisation(float overlappingSum) noexcept
+  { return 1.0f / utils::max(overlappingSum, Window::kMinOverlappingSum); }
+
+  void Window::applyWindow(Buffer &buffer, u32 channels, utils::span<bool> channelsToProcess,
+    u32 samples, uuid windowType, float alpha, u32 hop, bool waitForTable)
   {
-    // TODO: use an extra overlap_ variable to store the overlap param
-    // from previous scaleDown run in order to apply extra attenuation
-    // when moving the overlap control (essentially becomes linear interpolation)
+    COMPLEX_ASSERT(!activeTable_, "Previous frame wasn't normalised");
 
-    float mult;
-    switch (windowType)
+    fallbackNormalisation_ = 1.0f;
+    // crossfading doesn't need any normalisation
+    if (windowType == Lerp)
+      return;
+
+    alpha = quantiseAlpha(windowType, alpha);
+    ++useCounter_;
+
+    while (true)
     {
-    case Lerp: return;
-    case Rectangle:
-      mult = 1.0f - overlap;
-      break;
-    case Hann:
-    case Triangle:
-      if (overlap <= 0.5f)
-        return;
+      for (auto &table : tables_)
+      {
+        u32 expected = Table::Ready;
+        if (!table.state.compare_exchange_strong(expected, Table::InUse, satomi::memory_order_acquire))
+          continue;
 
-      mult = (1.0f - overlap) * 2.0f;
-      break;
-    case Hamming:
-      if (overlap <= 0.5f)
-        return;
+        if (table.samples != samples || table.hop != hop ||
+          table.windowType != windowType || table.alpha != alpha)
+        {
+          table.state.store(Table::Ready, satomi::memory_order_relaxed);
+          continue;
+        }
 
-      // https://www.desmos.com/calculator/z21xz7r2c9
-      mult = (1.0f - overlap) * 1.84f;
-      break;
-    case Sine:
-      if (overlap <= 0.33333333f)
-        return;
+        // contiguous per channel and 1 multiply per sample
+        if (windowType != Rectangle)
+          multiplyChannels(buffer, channels, channelsToProcess, samples, table.data, 1.0f);
 
-      // https://www.desmos.com/calculator/mmjwlj0gqe
-      mult = (1.0f - overlap) * 1.57f;
-      break;
-    case Exponential:
-      if (overlap <= 0.1235f)
+        table.lastUsed.store(useCounter_, satomi::memory_order_relaxed);
+        // released after the frame is normalised
+        activeTable_ = &table;
         return;
+      }
 
-      // not optimal but it works somewhat ok
-      // https://www.desmos.com/calculator/ozcckbnyvl
-      mult = (1.0f - overlap) * 3.25f * sqrtf(alpha * overlap);
-      break;
-    case HannExp:
-    case Lanczos:
-      if (overlap <= 0.1235f)
-        return;
+      if (samples > maxTableSamples_)
+        break;
 
-      // TODO: add optimal scaling for these
-      mult = (1.0f - overlap) * 3.25f * sqrtf(alpha * overlap);
-      break;
-    default:
-      COMPLEX_ASSERT_FALSE("Missing case");
+      if (!hasRequest_.load(satomi::memory_order_acquire))
+      {
+        requestedSamples_ = samples;
+        requestedHop_ = hop;
+        requestedWindowType_ = windowType;
+        requestedAlpha_ = alpha;
+        hasRequest_.store(true, satomi::memory_order_release);
+
+        // only syscalls if the builder is asleep, which is once per missing table
+        requestSignal_.fetch_add(1, satomi::memory_order_release);
+        requestSignal_.notify_one();
+      }
+
+      if (!waitForTable)
+        break;
+
+      // either our request or one that was still pending, in which case ours is made on the next iteration
+      (void)hasRequest_.wait(true, satomi::memory_order_acquire);
+    }
+
+    // until the table is ready we normalise by the average overlapping sum
+    float windowSum = applyDefaultWindows(buffer, channels, channelsToProcess, samples, windowType, alpha);
+    fallbackNormalisation_ = getNormalisation(windowSum / (float)hop);
+  }
+
+  void Window::applyOverlapNormalisation(Buffer &buffer, u32 channels,
+    utils::span<bool> channelsToProcess, u32 samples, float gain)
+  {
+    if (auto *table = activeTable_)
+    {
+      COMPLEX_ASSERT(table->samples == samples);
+      multiplyChannels(buffer, channels, channelsToProcess, samples, table->normalisation, gain);
+
+      activeTable_ = nullptr;
+      table->state.store(Table::Ready, satomi::memory_order_release);
       return;
     }
 
-    auto bufferSize = buffer.size;
+    simd_float simdGain = gain * fallbackNormalisation_;
     for (u32 i = 0; i < channels; i++)
     {
       if (!channelsToProcess[i])
         continue;
 
-      auto channel = buffer.get(i);
+      auto data = buffer.get(i);
+      for (u32 j = 0; j < samples; j += simd_float::size)
+        utils::storeSimdFloatToAligned(data + j, utils::toSimdFloatFromAligned(data + j) * simdGain);
+    }
+  }
+
+  void Window::reserveTables(utils::bumpArena *arena, u32 maxOrder)
+  {
+    maxTableSamples_ = 1U << maxOrder;
+    for (auto &table : tables_)
+    {
+      table.data = (float *)utils::bumpArena::insert(arena,
+        maxTableSamples_ * sizeof(float), alignof(simd_float));
+      table.normalisation = (float *)utils::bumpArena::insert(arena,
+        maxTableSamples_ * sizeof(float), alignof(simd_float));
+    }
+  }
+
+  bool Window::waitForRequest(const satomi::atomic<bool> &shouldStop)
+  {
+    while (true)
+    {
+      // loaded before checking the conditions so that a signal in between isn't missed
+      u32 signal = requestSignal_.load(satomi::memory_order_acquire);
+      if (shouldStop.load(satomi::memory_order_acquire))
+        return false;
+      if (hasRequest_.load(satomi::memory_order_acquire))
+        return true;
+
+      (void)requestSignal_.wait(signal, satomi::memory_order_acquire);
+    }
+  }
+
+  void Window::wakeBuilder()
+  {
+    requestSignal_.fetch_add(1, satomi::memory_order_release);
+    requestSignal_.notify_all();
+  }
+
+  bool Window::buildRequestedTable()
+  {
+    if (!hasRequest_.load(satomi::memory_order_acquire))
+      return true;
+
+    u32 samples = requestedSamples_;
+    u32 hop = requestedHop_;
+    uuid windowType = requestedWindowType_;
+    float alpha = requestedAlpha_;
 
-      // TODO: optimise this with aligned simd multiply
-      for (u32 j = 0; j < samples; j++)
+    // keys are only written here so they can be read without a handshake
+    for (auto &table : tables_)
+    {
+      // request raced with the previous build
+      if (table.state.load(satomi::memory_order_relaxed) != Table::Empty && table.samples == samples &&
+        table.hop == hop && table.windowType == windowType && table.alpha == alpha)
       {
-        u32 sampleIndex = (start + j) % bufferSize;
-        channel[sampleIndex] *= mult;
+        hasRequest_.store(false, satomi::memory_order_release);
+        hasRequest_.notify_all();
+        return true;
       }
     }
+
+    Table *victim = &tables_[0];
+    for (auto &table : tables_)
+    {
+      if (table.state.load(satomi::memory_order_relaxed) == Table::Empty)
+      {
+        victim = &table;
+        break;
+      }
+
+      if (table.lastUsed.load(satomi::memory_order_relaxed) < victim->lastUsed.load(satomi::memory_order_relaxed))
+        victim = &table;
+    }
+
+    // the audio thread might be using the least recently used table right now, we'll try again later
+    u32 expected = victim->state.load(satomi::memory_order_relaxed);
+    if (expected == Table::InUse || !victim->state.compare_exchange_strong(expected,
+      Table::Building, satomi::memory_order_acquire))
+      return false;
+
+    victim->samples = samples;
+    victim->hop = hop;
+    victim->windowType = windowType;
+    victim->alpha = alpha;
+
+    float *data = victim->data;
+    float increment = 1.0f / (float)samples;
+    for (u32 i = 0; i <= samples / 2; ++i)
+    {
+      float window = getWindowValue(windowType, (float)i * increment, alpha);
+      data[i] = window;
+      if (i != 0 && i != samples / 2)
+        data[samples - i] = window;
+    }
+
+    // every position in the frame overlaps with the positions a multiple of hop away in neighbouring frames,
+    // so the overlapping sum is periodic in hop and can be computed once per position in the hop
+    float *normalisation = victim->normalisation;
+    hop = utils::min(hop, samples);
+    for (u32 i = 0; i < hop; ++i)
+    {
+      float overlappingSum = 0.0f;
+      for (u32 j = i; j < samples; j += hop)
+        overlappingSum += data[j];
+      normalisation[i] = getNormalisation(overlappingSum);
+    }
+    for (u32 i = hop; i < samples; ++i)
+      normalisation[i] = normalisation[i - hop];
+
+    victim->state.store(Table::Ready, satomi::memory_order_release);
+    hasRequest_.store(false, satomi::memory_order_release);
+    // for applyWindow calls that wait for the table
+    hasRequest_.notify_all();
+    return true;
+  }
+
+  void Window::addOverlap(CircularBuffer &destination, Buffer &source, u32 channels,
+    utils::span<bool> channelsToProcess, u32 samples, u32 destinationBegin, uuid windowType)
+  {
+    if (windowType == Lerp)
+    {
+      Framework::applyToBuffer(
+        [](float &destination, const float &source, float t) { destination = (1.0f - t) * destination + t * source; },
+        destination, source, channels, samples, destinationBegin, 0, channelsToProcess);
+    }
+    else
+    {
+      // frames are already normalised so that they sum to unity, fading their edges would dip the gain at every hop
+      Framework::applyToBuffer(
+        [](float &destination, const float &source, float) { destination += source; },
+        destination, source, channels, samples, destinationBegin, 0, channelsToProcess);
+    }
   }
 
 }
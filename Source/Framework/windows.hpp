@@ -4,6 +4,12 @@
 #pragma once
 
 #include "stl_utils.hpp"
+#include "satomi.hpp"
+
+namespace utils
+{
+  struct bumpArena;
+}
 
 namespace Framework
 {
@@ -26,13 +32,72 @@ namespace Framework
       (    Lanczos, 1757856295720),
     )
 
+    // uses a precomputed table if one is ready, otherwise requests it and computes the window per sample
+    // hop is the distance to the next frame and is needed for the overlap normalisation
+    // waitForTable blocks until the table is built instead, so that the output doesn't depend on timing (offline)
     void applyWindow(Buffer &buffer, u32 channels, utils::span<bool> channelsToProcess,
-      u32 samples, uuid windowType, float alpha);
+      u32 samples, uuid windowType, float alpha, u32 hop, bool waitForTable = false);
+    // scales the frame windowed by the last applyWindow call so that overlapping frames sum to unity gain
+    // (boosting by at most 1 / kMinOverlappingSum where the windows barely overlap) and by an extra gain
+    void applyOverlapNormalisation(Buffer &buffer, u32 channels,
+      utils::span<bool> channelsToProcess, u32 samples, float gain);
+
+    // allocates storage for the tables, needs to be called before any tables can be used
+    void reserveTables(utils::bumpArena *arena, u32 maxOrder);
+    // builds the last table requested by applyWindow, meant to be called from a worker thread
+    // returns false if the table to be replaced is still in use and the build needs to be retried
+    bool buildRequestedTable();
+    // blocks the worker until applyWindow requests a table or wakeBuilder is called
+    // returns false if the worker should exit
+    bool waitForRequest(const satomi::atomic<bool> &shouldStop);
+    void wakeBuilder();
 
     void addOverlap(CircularBuffer &destination, Buffer &source, u32 channels,
       utils::span<bool> channelsToProcess, u32 samples, u32 destinationBegin, uuid windowType);
 
-    void scaleDown(Buffer &buffer, u32 channels, utils::span<bool> channelsToProcess,
-      u32 start, u32 samples, uuid windowType, float overlap, float alpha);
+    // positions whose overlapping windows sum to less than this aren't brought all the way up to unity,
+    // whatever the processing left at the edges of frames that barely overlap would be boosted along with them
+    static constexpr float kMinOverlappingSum = 1.0f / 16.0f;
+    static constexpr u32 kTableSlots = 4;
+    // alpha is quantised to steps of 1 / kAlphaQuantisation so that close values can share a table
+    static constexpr float kAlphaQuantisation = 64.0f;
+
+    // a full periodic window of a given size, type and alpha
+    // together with its overlap-add normalisation for a given hop
+    // the state is used as a handshake between the audio thread (Ready <-> InUse)
+    // and the builder (Empty/Ready -> Building -> Ready), the key is only written while Building
+    struct Table
+    {
+      enum State : u32 { Empty, Building, Ready, InUse };
+
+      satomi::atomic<u32> state{};
+      satomi::atomic<u64> lastUsed{};
+      u32 samples{};
+      u32 hop{};
+      uuid windowType{};
+      float alpha{};
+      float *data{};
+      // 1 / sum of all overlapping windows at every position of the frame (see kMinOverlappingSum), periodic in hop
+      float *normalisation{};
+    };
+
+  private:
+    Table tables_[kTableSlots]{};
+    u32 maxTableSamples_{};
+    // only touched by the audio thread
+    u64 useCounter_{};
+    // table kept InUse between applyWindow and applyOverlapNormalisation
+    Table *activeTable_{};
+    // used instead of the normalisation curve while the table is being built
+    float fallbackNormalisation_ = 1.0f;
+
+    // only written by the audio thread while there isn't a request pending
+    satomi::atomic<bool> hasRequest_{};
+    // bumped on every request and wakeup, the builder waits on it
+    satomi::atomic<u32> requestSignal_{};
+    u32 requestedSamples_{};
+    u32 requestedHop_{};
+    uuid requestedWindowType_{};
+    float requestedAlpha_{};
   };
 }
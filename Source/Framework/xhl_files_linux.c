@@ -0,0 +1,219 @@
+
+// Created: 2026-10-18 15:02:11
+
+// linux implementation of the xhl_files functions that the library only provides for windows and mac
+// included right after xhl_files.h with XHL_FILES_IMPL, by unity_extern.c and by the resource generator
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool xfiles_exists(const char* path) { return access(path, F_OK) == 0; }
+
+bool xfiles_is_directory(const char* path)
+{
+    struct stat st = {0};
+    return lstat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool xfiles_create_directory(const char* path) { return mkdir(path, 0777) == 0 || errno == EEXIST; }
+
+bool xfiles_read(const char* path, void** out, size_t* outlen)
+{
+    struct stat info = {0};
+    bool        ok   = false;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    if (fstat(fd, &info) == 0)
+    {
+        char*  data   = (char*)XFILES_MALLOC(info.st_size ? info.st_size : 1);
+        size_t offset = 0;
+        while (offset < (size_t)info.st_size)
+        {
+            ssize_t nread = read(fd, data + offset, info.st_size - offset);
+            if (nread <= 0)
+                break;
+            offset += nread;
+        }
+
+        ok = offset == (size_t)info.st_size;
+        if (ok)
+        {
+            *out    = data;
+            *outlen = offset;
+        }
+        else
+            XFILES_FREE(data);
+    }
+    close(fd);
+    return ok;
+}
+
+static bool _xfiles_write_flags(const char* path, const void* in, size_t inlen, int flags)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | flags, 0666);
+    if (fd == -1)
+        return false;
+
+    size_t offset = 0;
+    while (offset < inlen)
+    {
+        ssize_t nwritten = write(fd, (const char*)in + offset, inlen - offset);
+        if (nwritten <= 0)
+            break;
+        offset += nwritten;
+    }
+    close(fd);
+    return offset == inlen;
+}
+
+bool xfiles_write(const char* path, const void* in, size_t inlen)
+{
+    return _xfiles_write_flags(path, in, inlen, O_TRUNC);
+}
+
+bool xfiles_append(const char* path, const char* in, size_t inlen)
+{
+    return _xfiles_write_flags(path, in, inlen, O_APPEND);
+}
+
+bool xfiles_move(const char* from, const char* to) { return 0 == rename(from, to); }
+
+bool xfiles_delete(const char* path) { return unlink(path) == 0; }
+
+XFilesMetadata xfiles_get_metadata(const char* path)
+{
+    XFilesMetadata meta = {0};
+    struct stat    st;
+
+    if (path == NULL || path[0] == '\0')
+    {
+        meta.last_error = -1;
+        return meta;
+    }
+    if (lstat(path, &st) != 0)
+    {
+        meta.last_error = (int32_t)errno;
+        return meta;
+    }
+
+    meta.size_bytes            = (uint64_t)st.st_size;
+    meta.modification_time_ns  = (uint64_t)st.st_mtim.tv_sec * 1000000000LL + (uint64_t)st.st_mtim.tv_nsec;
+    meta.access_time_ns        = (uint64_t)st.st_atim.tv_sec * 1000000000LL + (uint64_t)st.st_atim.tv_nsec;
+    meta.status_change_time_ns = (uint64_t)st.st_ctim.tv_sec * 1000000000LL + (uint64_t)st.st_ctim.tv_nsec;
+    meta.file_index            = st.st_ino;
+    meta.num_links             = st.st_nlink;
+    meta.volume_serial_number  = st.st_dev;
+    meta._st_mode              = st.st_mode;
+    meta._st_blksize           = st.st_blksize;
+    meta._st_blocks            = st.st_blocks;
+
+    if (S_ISREG(st.st_mode))
+        meta.type = XFILES_METADATA_TYPE_FILE;
+    else if (S_ISDIR(st.st_mode))
+        meta.type = XFILES_METADATA_TYPE_DIRECTORY;
+    else if (S_ISLNK(st.st_mode))
+        meta.type = XFILES_METADATA_TYPE_SYMLINK;
+    else if (S_ISBLK(st.st_mode))
+        meta.type = XFILES_METADATA_TYPE_BLOCK_DEVICE;
+    else if (S_ISCHR(st.st_mode))
+        meta.type = XFILES_METADATA_TYPE_CHAR_DEVICE;
+    else if (S_ISFIFO(st.st_mode))
+        meta.type = XFILES_METADATA_TYPE_FIFO;
+    else if (S_ISSOCK(st.st_mode))
+        meta.type = XFILES_METADATA_TYPE_SOCKET;
+
+    const char* name   = xfiles_get_name(path);
+    meta.is_readonly   = (st.st_mode & 0222) == 0;
+    meta.is_hidden     = name != NULL && name[0] == '.';
+    meta.is_executable = (st.st_mode & 0111) != 0;
+    meta.is_symlink    = S_ISLNK(st.st_mode) ? true : false;
+
+    return meta;
+}
+
+void xfiles_list(const char* path, void* data, xfiles_list_callback_t* callback)
+{
+    xfiles_list_item_t item;
+    struct dirent*     entry;
+
+    DIR* dir = opendir(path);
+    if (!dir)
+        return;
+
+    item.name_idx = snprintf(item.path, sizeof(item.path), "%s/", path);
+    while ((entry = readdir(dir)) != NULL)
+    {
+        size_t namelen = strlen(entry->d_name);
+        item.path_len  = item.name_idx + namelen;
+        if (item.path_len >= sizeof(item.path)) // Guard overflow
+            continue;
+
+        memcpy(&item.path[item.name_idx], entry->d_name, namelen + 1);
+
+        item.ext_idx = item.name_idx;
+        for (uint32_t i = item.name_idx; i < item.path_len; i++)
+            if (item.path[i] == '.')
+                item.ext_idx = i;
+        if (item.ext_idx == item.name_idx) // Failed to find extension
+            item.ext_idx = item.path_len;
+        item.is_dir = entry->d_type == DT_DIR;
+
+        callback(data, &item);
+    }
+    closedir(dir);
+}
+
+// TODO: inotify
+xfiles_watch_context_t xfiles_watch_create(const char* path, void* udata, xfiles_watch_callback_t cb) { return NULL; }
+void                   xfiles_watch_flush(xfiles_watch_context_t ctx) {}
+void                   xfiles_watch_destroy(xfiles_watch_context_t ctx) {}
+
+// There is no single trash or file browser on linux, leave those to the desktop environment
+bool xfiles_trash(const char* path) { return false; }
+bool xfiles_open_file_explorer(const char* path) { return false; }
+bool xfiles_select_in_file_explorer(const char* path) { return false; }
+
+int xfiles_get_user_directory(char* out, size_t outlen, XFilesUserDirectory loc)
+{
+    static const char* PATHS[] = {
+        "",           // XFILES_USER_DIRECTORY_HOME,
+        "/.config",   // XFILES_USER_DIRECTORY_APPDATA
+        "/Desktop",   // XFILES_USER_DIRECTORY_DESKTOP
+        "/Documents", // XFILES_USER_DIRECTORY_DOCUMENTS
+        "/Downloads", // XFILES_USER_DIRECTORY_DOWNLOADS
+        "/Music",     // XFILES_USER_DIRECTORY_MUSIC
+        "/Pictures",  // XFILES_USER_DIRECTORY_PICTURES
+        "/Videos",    // XFILES_USER_DIRECTORY_VIDEOS
+    };
+    _Static_assert(XFILES_ARRLEN(PATHS) == XFILES_USER_DIRECTORY_COUNT, "");
+
+    if (loc < 0)
+        loc = (XFilesUserDirectory)0;
+    if (loc >= XFILES_USER_DIRECTORY_COUNT)
+        loc = (XFilesUserDirectory)(XFILES_USER_DIRECTORY_COUNT - 1);
+
+    const char* home   = getenv("HOME");
+    const char* subdir = PATHS[loc];
+    const char* xdg    = getenv("XDG_CONFIG_HOME");
+    if (loc == XFILES_USER_DIRECTORY_APPDATA && xdg && xdg[0] == '/')
+    {
+        home   = xdg;
+        subdir = "";
+    }
+    if (!home)
+        home = "";
+
+    int len = snprintf(out, outlen, "%s%s", home, subdir);
+    if (len < 0 || (size_t)len >= outlen)
+        return 0;
+    return len;
+}
@@ -23,9 +23,14 @@ namespace Generation
 #define EFFECT_VTABLE(name, creationFunction, createUIFunction) \
   static_assert(utils::is_same_v<decltype(+creationFunction), EffectData::CreateEffectFn *>); \
   static_assert(utils::is_same_v<decltype(+createUIFunction), EffectData::CreateUIFn *>); \
-  static void(*const vtable##name[])() = { (void (*)())(+creationFunction), (void (*)())run##name, (void (*)())createUIFunction }
-#define COMPLEX_STRUCTURE_EFFECT(nameString, idNumber, vtableArray, skinOverride, ...) (*anew(arena, Framework::ProcessorMetadata, \
-  { .flags = ProcessorMetadata::ProcessorTag, .userFlags = skinOverride, .id = idNumber, .name = nameString __VA_OPT__(,) __VA_ARGS__, .vtable = vtableArray })).computeCounts()
+  static void(*const vtable##name[])() = { (void (*)())(+creationFunction), (void (*)())run##name, (void (*)())createUIFunction, nullptr }
+// for pointwise effects that can be fused with their neighbours, see EffectKernel
+#define EFFECT_KERNEL_VTABLE(name, creationFunction, createUIFunction) \
+  static_assert(utils::is_same_v<decltype(+creationFunction), EffectData::CreateEffectFn *>); \
+  static_assert(utils::is_same_v<decltype(+createUIFunction), EffectData::CreateUIFn *>); \
+  static void(*const vtable##name[])() = { (void (*)())(+creationFunction), (void (*)())run##name, (void (*)())createUIFunction, (void (*)())prepareKernel##name }
+#define COMPLEX_STRUCTURE_EFFECT(nameString, idNumber, vtableArray, skinOverride, extraFlags, ...) (*anew(arena, Framework::ProcessorMetadata, \
+  { .flags = ProcessorMetadata::ProcessorTag | (extraFlags), .userFlags = skinOverride, .id = idNumber, .name = nameString __VA_OPT__(,) __VA_ARGS__, .vtable = vtableArray })).computeCounts()
 
   static Framework::ParameterValue *
   getParameter(EffectData *effectData, uuid id)
@@ -66,15 +71,21 @@ namespace Generation
   {
     using namespace Framework;
 
-    EFFECT_VTABLE(Normal, createEffectGeneric, createUINormal);
-    EFFECT_VTABLE(Gate, createEffectGeneric, createUIGate);
+    static constexpr auto createEffectGate = [](EffectModule *module, EffectData *) -> EffectData *
+    {
+      // the histograms are overwritten on every use, so there's nothing to copy
+      return (EffectData *)anew(module->arena, GateData, {});
+    };
+
+    EFFECT_KERNEL_VTABLE(Normal, createEffectGeneric, createUINormal);
+    EFFECT_KERNEL_VTABLE(Gate, createEffectGate, createUIGate);
 
     auto *arena = structure.getNewArena(COMPLEX_KB(40));
     auto *parsedSVG = parseSVG(arena, BinaryData::Icon_Filter_svg, BinaryData::Icon_Filter_svgSize);
 
     return COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Filter", .id = id, .flags = IndexedData::SVGData, .svgData = parsedSVG)->addChildren({{
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Normal", .id = Types::Normal, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Normal", Types::Normal, vtableNormal, Interface::Skin::kFilterModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Normal", Types::Normal, vtableNormal, Interface::Skin::kFilterModule, ProcessorMetadata::InPlaceTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Gain", Normal::Gain, { kMinusInfDb, kInfDb, 0.0f, 0.5f }, ParameterScale::SymmetricLoudness,
               " dB", ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo),
@@ -86,7 +97,7 @@ namespace Generation
         )
       ),
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Gate", .id = Types::Gate, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Gate", Types::Gate, vtableGate, Interface::Skin::kFilterModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Gate", Types::Gate, vtableGate, Interface::Skin::kFilterModule, ProcessorMetadata::InPlaceTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Input Gain", Gate::InputGain, { kMinusInfDb, kInfDb, 0.0f, 0.5f }, ParameterScale::SymmetricLoudness,
               " dB", ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo),
@@ -122,7 +133,7 @@ namespace Generation
 
     return COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Dynamics", .id = id, .flags = IndexedData::SVGData, .svgData = parsedSVG)->addChildren({{
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Contrast", .id = Types::Contrast, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Contrast", Types::Contrast, vtableContrast, Interface::Skin::kDynamicsModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Contrast", Types::Contrast, vtableContrast, Interface::Skin::kDynamicsModule, ProcessorMetadata::InPlaceTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Depth", Contrast::Depth, { -1.0f, 1.0f, 0.0f, 0.5f }, ParameterScale::Linear,
               "%", ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo),
@@ -134,7 +145,7 @@ namespace Generation
         )
       ),
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Clip", .id = Types::Clip, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Clip", Types::Clip, vtableClip, Interface::Skin::kDynamicsModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Clip", Types::Clip, vtableClip, Interface::Skin::kDynamicsModule, ProcessorMetadata::InPlaceTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Threshold", Clip::Threshold, { 0.0f, 1.0f, 0.0f, 0.0f }, ParameterScale::Linear,
               "%", ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo),
@@ -158,7 +169,7 @@ namespace Generation
 
     return COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Phase", .id = id, .flags = IndexedData::SVGData, .svgData = parsedSVG)->addChildren({{
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Shift", .id = Types::Shift, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Contrast", Types::Shift, vtableShift, Interface::Skin::kPhaseModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Contrast", Types::Shift, vtableShift, Interface::Skin::kPhaseModule, ProcessorMetadata::InPlaceTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Phase Shift", Shift::PhaseShift, { -180.0f, 180.0f, 0.0f, 0.5f }, ParameterScale::Linear,
               COMPLEX_DEGREE_SIGN_LITERAL, ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo),
@@ -193,7 +204,7 @@ namespace Generation
 
     return COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Pitch", .id = id, .flags = IndexedData::SVGData, .svgData = parsedSVG)->addChildren({{
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Resample", .id = Types::Resample, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Resample", Types::Resample, vtableResample, Interface::Skin::kPitchModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Resample", Types::Resample, vtableResample, Interface::Skin::kPitchModule, ProcessorMetadata::NoTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Shift", Resample::Shift, { -48.0f, 48.0f, 0.0f, 0.5f }, ParameterScale::Linear,
               " st", ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo),
@@ -203,7 +214,7 @@ namespace Generation
         )
       ),
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Frequency Shift", .id = Types::FrequencyShift, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Frequency Shift", Types::FrequencyShift, vtableFrequencyShift, Interface::Skin::kPitchModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Frequency Shift", Types::FrequencyShift, vtableFrequencyShift, Interface::Skin::kPitchModule, ProcessorMetadata::NoTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Shift", FrequencyShift::Shift, { -20'000.0f, 20'000.0f, 0.0f, 0.5f }, ParameterScale::SymmetricCubic,
               " hz", ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo)
@@ -239,7 +250,7 @@ namespace Generation
 
     return COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Freeze", .id = id)->addChildren({{
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Rolling", .id = Types::Rolling, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Rolling", Types::Rolling, vtableRolling, Interface::Skin::kPitchModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Rolling", Types::Rolling, vtableRolling, Interface::Skin::kPitchModule, ProcessorMetadata::InPlaceTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Rate", Rolling::Rate, { -4.0f, 4.0f, 0.0f, 0.5f }, ParameterScale::SymmetricCubic,
               "x", ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo),
@@ -256,14 +267,14 @@ namespace Generation
   {
     using namespace Framework;
 
-    EFFECT_VTABLE(Reinterpret, createEffectGeneric, createUIReinterpret);
+    EFFECT_KERNEL_VTABLE(Reinterpret, createEffectGeneric, createUIReinterpret);
 
     auto *arena = structure.getNewArena(COMPLEX_KB(1));
     auto *parsedSVG = parseSVG(arena, BinaryData::Icon_Destroy_svg, BinaryData::Icon_Destroy_svgSize);
 
     return COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Destroy", .id = id, .flags = IndexedData::SVGData, .svgData = parsedSVG)->addChildren({{
       COMPLEX_STRUCTURE_INDEXED_DATA(.displayName = "Reinterpret", .id = Types::Reinterpret, .flags = IndexedData::ProcessorFlag,
-        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Reinterpret", Types::Reinterpret, vtableReinterpret, Interface::Skin::kDestroyModule, .parameters =
+        .processorMetadata = COMPLEX_STRUCTURE_EFFECT("Reinterpret", Types::Reinterpret, vtableReinterpret, Interface::Skin::kDestroyModule, ProcessorMetadata::InPlaceTag, .parameters =
           (
             COMPLEX_STRUCTURE_PARAMETER("Real/Imag Atten", Reinterpret::Attenuation, { kMinusInfDb, kInfDb, 0.0f, 0.5f },
               ParameterScale::SymmetricLoudness, " dB", ParameterDetails::Modulatable | ParameterDetails::Automatable | ParameterDetails::Stereo),
@@ -452,7 +463,7 @@ namespace Generation
         auto sourceChannel = rawSource.offset(i * size);
         auto destinationChannel = rawDestination.offset(i * size);
 
-        for (usize iteration = 0; iteration <= countof(starts); ++iteration)
+        for (usize iteration = 0; iteration < countof(starts); ++iteration)
         {
           simd_int start = starts[iteration];
           simd_int length = lengths[iteration];
@@ -495,6 +506,184 @@ namespace Generation
     }
   }
 
+  // contiguous runs of bins inside/outside of the processing bounds
+  // same inclusive semantics as isOutsideBounds, so kernels can switch between the two freely
+  // if the bounds differ between channels (stereo) everything is reported as processed
+  // and kernels need to fall back onto masking every bin with isOutsideBounds
+  struct BoundsSpans
+  {
+    struct Span
+    {
+      u32 begin = 0;
+      u32 end = 0;
+    };
+
+    Span processed[2]{};
+    Span unprocessed[2]{};
+    // first bin of the range, the part of a wrapped range before it comes after the end of the spectrum
+    u32 rangeBegin = 0;
+    u32 binCount = 0;
+    bool isStereo = false;
+
+    // how far into the range a processed span starts, used for tilt so that its slope
+    // carries over the wrap of a range like |   ]    [   | instead of restarting at bin 0
+    u32 getRangePosition(u32 begin) const { return (begin < rangeBegin) ? begin + binCount : begin; }
+
+    void forEachProcessed(const auto &lambda) const
+    {
+      for (auto span : processed)
+        if (span.begin < span.end)
+          lambda(span.begin, span.end);
+    }
+
+    void forEachUnprocessed(const auto &lambda) const
+    {
+      for (auto span : unprocessed)
+        if (span.begin < span.end)
+          lambda(span.begin, span.end);
+    }
+  };
+
+  static BoundsSpans vectorcall
+  getBoundsSpans(simd_int lowIndices, simd_int highIndices, u32 binCount)
+  {
+    BoundsSpans spans{ .binCount = binCount };
+    spans.isStereo = minimiseRange(lowIndices, highIndices, binCount, true).isStereoRange;
+    if (spans.isStereo)
+    {
+      spans.processed[0] = { 0, binCount };
+      return spans;
+    }
+
+    u32 low = utils::min(lowIndices[0], binCount - 1);
+    u32 high = utils::min(highIndices[0], binCount - 1);
+
+    // |   [    ]   |
+    if (low <= high)
+    {
+      spans.processed[0] = { low, high + 1 };
+      spans.unprocessed[0] = { 0, low };
+      spans.unprocessed[1] = { high + 1, binCount };
+    }
+    // |   ]    [   |
+    else
+    {
+      spans.processed[0] = { 0, high + 1 };
+      spans.processed[1] = { low, binCount };
+      spans.unprocessed[0] = { high + 1, low };
+      spans.rangeBegin = low;
+    }
+
+    return spans;
+  }
+
+  static void copyUnprocessedSpans(const Framework::SimdBuffer *source,
+    Framework::SimdBuffer *destination, const BoundsSpans &spans) noexcept
+  {
+    // running in place, unprocessed bins are already there
+    if (source == destination)
+      return;
+
+    spans.forEachUnprocessed([&](u32 begin, u32 end)
+      {
+        Framework::applyToThisNoMask<utils::MathOperations::Assign>(destination, source,
+          destination->channels, end - begin, 0, 0, begin, begin);
+      });
+  }
+
+  bool canFuseKernels(const EffectKernel &first, const EffectKernel &next, u32 binCount) noexcept
+  {
+    if (!first.function || !next.function)
+      return false;
+
+    auto firstSpans = getBoundsSpans(first.lowBoundIndices, first.highBoundIndices, binCount);
+    auto nextSpans = getBoundsSpans(next.lowBoundIndices, next.highBoundIndices, binCount);
+    if (firstSpans.isStereo || nextSpans.isStereo)
+      return false;
+
+    return firstSpans.processed[0].begin == nextSpans.processed[0].begin &&
+      firstSpans.processed[0].end == nextSpans.processed[0].end &&
+      firstSpans.processed[1].begin == nextSpans.processed[1].begin &&
+      firstSpans.processed[1].end == nextSpans.processed[1].end;
+  }
+
+  void runEffectKernels(utils::span<EffectKernel> kernels, const Framework::SimdBuffer *source,
+    Framework::SimdBuffer *destination, u32 binCount) noexcept
+  {
+    using namespace utils;
+
+    COMPLEX_ASSERT(!kernels.empty());
+
+    auto spans = getBoundsSpans(kernels[0].lowBoundIndices, kernels[0].highBoundIndices, binCount);
+    COMPLEX_ASSERT(kernels.size() == 1 || !spans.isStereo, "Only kernels with mono bounds can be fused");
+
+    auto rawSource = source->get();
+    auto rawDestination = destination->get();
+
+    if (spans.isStereo)
+    {
+      auto &kernel = kernels[0];
+      simd_mask isHighAboveLow = simd_int::greaterThanOrEqualSigned(kernel.highBoundIndices, kernel.lowBoundIndices);
+      for (u32 i = 0; i < binCount - 1; i += 2)
+      {
+        simd_float dry[] = { rawSource[i], rawSource[i + 1] };
+        simd_float one = dry[0], two = dry[1];
+        kernel.function(kernel.state, one, two, i);
+
+        rawDestination[i    ] = merge(one, dry[0],
+          isOutsideBounds(i    , kernel.lowBoundIndices, kernel.highBoundIndices, isHighAboveLow));
+        rawDestination[i + 1] = merge(two, dry[1],
+          isOutsideBounds(i + 1, kernel.lowBoundIndices, kernel.highBoundIndices, isHighAboveLow));
+      }
+
+      simd_float dry = rawSource[binCount - 1];
+      simd_float one = dry, two = 0.0f;
+      kernel.function(kernel.state, one, two, binCount - 1);
+      rawDestination[binCount - 1] = merge(one, dry,
+        isOutsideBounds(binCount - 1, kernel.lowBoundIndices, kernel.highBoundIndices, isHighAboveLow));
+
+      return;
+    }
+
+    copyUnprocessedSpans(source, destination, spans);
+    spans.forEachProcessed([&](u32 begin, u32 end)
+      {
+        // spans are widened to even boundaries, a bin that falls outside
+        // is given back its dry value after every kernel and isn't written
+        u32 pairsEnd = min(end, binCount - 1);
+        for (u32 i = begin & ~1U; i < pairsEnd; i += 2)
+        {
+          simd_float dry[] = { rawSource[i], rawSource[i + 1] };
+          simd_float one = dry[0], two = dry[1];
+          bool isOneInside = i >= begin;
+          bool isTwoInside = i + 1 < end;
+
+          for (auto &kernel : kernels)
+          {
+            kernel.function(kernel.state, one, two, i);
+            one = isOneInside ? one : dry[0];
+            two = isTwoInside ? two : dry[1];
+          }
+
+          if (isOneInside)
+            rawDestination[i] = one;
+          if (isTwoInside)
+            rawDestination[i + 1] = two;
+        }
+
+        if (end == binCount)
+        {
+          simd_float one = rawSource[binCount - 1];
+          for (auto &kernel : kernels)
+          {
+            simd_float two = 0.0f;
+            kernel.function(kernel.state, one, two, binCount - 1);
+          }
+          rawDestination[binCount - 1] = one;
+        }
+      });
+  }
+
   static simd_float vectorcall
   matchPower(simd_float target, simd_float current)
   {
@@ -552,13 +741,104 @@ namespace Generation
   for (u32 _i = 0; _i < binCount; _i++)                               \
     rawDestination[_i] = rawSource[_i]; } while(false)
 
-  void Filter::runNormal(EffectModule *effectModule, EffectData *effectData,
-    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
-    u32 binCount, float sampleRate) noexcept
+  struct NormalKernelState
+  {
+    simd_int cutoffIndices;
+    simd_int lowBoundIndices;
+    simd_mask cutoffAboveLowMask;
+    simd_float invLog2Nyquist;
+    simd_float binDivisor;
+    simd_float slopes;
+    simd_mask slopeMask;
+    simd_mask slopeZeroMask;
+    simd_float gainsParameter;
+    simd_mask gainType;
+  };
+
+  static simd_float vectorcall
+  calculateDistancesFromCutoffs(const NormalKernelState &state, simd_int positionIndices)
+  {
+    // 1. both positionIndices and cutoffIndices are >= lowBound and < FFTSize_ or <= highBound and > 0
+    // 2. cutoffIndices/positionIndices is >= lowBound and < FFTSize_ and
+    //     positionIndices/cutoffIndices is <= highBound and > 0
+
+    using namespace utils;
+
+    simd_int cutoffIndices = state.cutoffIndices;
+    simd_mask cutoffAbovePositions = simd_mask::greaterThanOrEqualSigned(cutoffIndices, positionIndices);
+
+    // preparing masks for 1.
+    simd_mask positionsAboveLowMask = simd_mask::greaterThanOrEqualSigned(positionIndices, state.lowBoundIndices);
+    simd_mask bothAboveOrBelowLowMask = ~(positionsAboveLowMask ^ state.cutoffAboveLowMask);
+
+    // preparing masks for 2.
+    simd_mask positionsBelowLowBoundAndCutoffsMask = ~positionsAboveLowMask & state.cutoffAboveLowMask;
+    simd_mask cutoffBelowLowBoundAndPositionsMask = positionsAboveLowMask & ~state.cutoffAboveLowMask;
+
+    // masking for 1.
+    simd_int precedingIndices  = merge(cutoffIndices  , positionIndices, bothAboveOrBelowLowMask & cutoffAbovePositions);
+    simd_int succeedingIndices = merge(positionIndices, cutoffIndices  , bothAboveOrBelowLowMask & cutoffAbovePositions);
+
+    // masking for 2.
+    // first 2 are when cutoffs/positions are above/below lowBound
+    // second 2 are when positions/cutoffs are above/below lowBound
+    precedingIndices  = merge(precedingIndices , cutoffIndices  , ~bothAboveOrBelowLowMask & positionsBelowLowBoundAndCutoffsMask);
+    succeedingIndices = merge(succeedingIndices, positionIndices, ~bothAboveOrBelowLowMask & positionsBelowLowBoundAndCutoffsMask);
+    precedingIndices  = merge(precedingIndices , positionIndices, ~bothAboveOrBelowLowMask & cutoffBelowLowBoundAndPositionsMask);
+    succeedingIndices = merge(succeedingIndices, cutoffIndices  , ~bothAboveOrBelowLowMask & cutoffBelowLowBoundAndPositionsMask);
+
+    auto binToNormalised = [&](simd_int bin)
+    {
+      return (log2(toFloat(bin) * state.binDivisor) * state.invLog2Nyquist) & simd_int::notEqual(bin, 0);
+    };
+
+    auto ratio = getDecimalPlaces(simd_float{ 1.0f } + binToNormalised(succeedingIndices) - binToNormalised(precedingIndices));
+    // all i have to say is, floating point error
+    return ratio & simd_int::notEqual(precedingIndices, succeedingIndices);
+  }
+
+  // effects that settle for cheaper math on the audio thread switch to the accurate tier when there's no deadline
+  static bool isRenderingOffline(const EffectModule *effectModule) noexcept
+  { return effectModule->state->plugin->isRenderingOffline.load(satomi::memory_order_relaxed); }
+
+  template<utils::MathPrecision Precision>
+  static void normalKernel(void *state, simd_float &one, simd_float &two, u32 index)
+  {
+    using namespace utils;
+
+    auto &s = *(NormalKernelState *)state;
+
+    auto filter = [&](simd_float bin, u32 binIndex)
+    {
+      // the distances are logarithmic
+      // TODO: memoise cutoff distances and update only when low/high bound indices and binCount are changed
+      simd_float distancesFromCutoff = calculateDistancesFromCutoffs(s, binIndex);
+
+      // calculating linear slope and brickwall, both are ratio of the gain attenuation
+      // the higher tha value the more it will be affected by it
+      simd_float gainRatio = merge(
+        simd_float::clamp(merge(distancesFromCutoff / s.slopes, simd_float{ 1.0f }, s.slopeZeroMask), 0.0f, 1.0f),
+        simd_float{ 1.0f } & simd_float::greaterThanOrEqual(distancesFromCutoff, s.slopes),
+        s.slopeMask);
+      simd_float gains = merge(s.gainsParameter * gainRatio, s.gainsParameter * (simd_float{ 1.0f } - gainRatio), s.gainType);
+
+      // convert db reduction to amplitude multiplier
+      return bin * dbToAmplitude<Precision>(-gains);
+    };
+
+    one = filter(one, index);
+    two = filter(two, index + 1);
+  }
+
+  bool Filter::prepareKernelNormal(EffectModule *effectModule, EffectData *effectData,
+    Framework::ComplexDataSource &, EffectKernel &kernel, u32 binCount, float sampleRate) noexcept
   {
     using namespace utils;
     using namespace Framework;
 
+    // gains only shape the response curve, small errors are inaudible
+    static constexpr auto kPrecision = MathPrecision::Fast;
+
     simd_float lowBoundNorm = effectModule->getParameter(EffectModule::LowBound)->getInternalValue<simd_float>(sampleRate, true);
     simd_float highBoundNorm = effectModule->getParameter(EffectModule::HighBound)->getInternalValue<simd_float>(sampleRate, true);
     simd_float boundShift = effectModule->getParameter(EffectModule::ShiftBounds)->getInternalValue<simd_float>(sampleRate);
@@ -567,15 +847,9 @@ namespace Generation
     u32 FFTSize = (binCount - 1) * 2;
 
     // getting the boundaries in terms of bin position
-    auto [lowBoundIndices, highBoundIndices] = [&]()
-    {
-      auto [low, high] = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
-      return utils::pair{ toInt(low), toInt(high) };
-    }();
-    simd_mask isHighAboveLowMask = simd_int::greaterThanOrEqualSigned(highBoundIndices, lowBoundIndices);
-
-    // minimising the bins to iterate on
-    auto [start, processedCount, _] = minimiseRange(lowBoundIndices, highBoundIndices, binCount, true);
+    auto [lowBound, highBound] = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
+    kernel.lowBoundIndices = toInt(lowBound);
+    kernel.highBoundIndices = toInt(highBound);
 
     // cutoff is described as exponential normalised value of the sample rate
     // it is dependent on the values of the low/high bounds
@@ -586,132 +860,265 @@ namespace Generation
     // if mask scalars are negative/positive -> brickwall/linear slope
     // slopes are logarithmic
     simd_float slopes = getParameter(effectData, Filter::Normal::Slope)->getInternalValue<simd_float>(sampleRate) / 2.0f;
-    simd_mask slopeMask = ~unsignSimd<true>(slopes);
-    simd_mask slopeZeroMask = simd_float::equal(slopes, 0.0f);
 
     // if scalars are negative/positive, attenuate at/around cutoff
     // (gains is gain reduction in db and NOT a gain multiplier)
     simd_float gainsParameter = getParameter(effectData, Filter::Normal::Gain)->getInternalValue<simd_float>(sampleRate);
-    simd_mask gainType = unsignSimd<true>(gainsParameter);
 
-    // copy both un/processed data
-    applyToThisNoMask<MathOperations::Assign>(destination, source.sourceBuffer, destination->channels, binCount);
+    static_assert(sizeof(NormalKernelState) <= EffectKernel::kStateSize);
+    new(kernel.state) NormalKernelState
+    {
+      .cutoffIndices = cutoffIndices,
+      .lowBoundIndices = kernel.lowBoundIndices,
+      .cutoffAboveLowMask = simd_mask::greaterThanOrEqualSigned(cutoffIndices, kernel.lowBoundIndices),
+      .invLog2Nyquist = simd_float{ (float)(1.0 / log2(sampleRate * 0.5 / kMinFrequency)) },
+      .binDivisor = simd_float{ (float)(sampleRate / (FFTSize * kMinFrequency)) },
+      .slopes = slopes,
+      .slopeMask = ~unsignSimd<true>(slopes),
+      .slopeZeroMask = simd_float::equal(slopes, 0.0f),
+      .gainsParameter = gainsParameter,
+      .gainType = unsignSimd<true>(gainsParameter)
+    };
+
+    kernel.function = isRenderingOffline(effectModule) ?
+      normalKernel<MathPrecision::Accurate> : normalKernel<kPrecision>;
 
-    auto calculateDistancesFromCutoffs = [cutoffIndices, lowBoundIndices,
-      cutoffAboveLowMask = simd_mask::greaterThanOrEqualSigned(cutoffIndices, lowBoundIndices),
-      invLog2Nyquist = simd_float{ (float)(1.0 / log2(sampleRate * 0.5 / kMinFrequency)) },
-      binDivisor = simd_float{ (float)(sampleRate / (FFTSize * kMinFrequency)) }](simd_int positionIndices)
+    return true;
+  }
+
+  void Filter::runNormal(EffectModule *effectModule, EffectData *effectData,
+    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
+    u32 binCount, float sampleRate) noexcept
+  {
+    EffectKernel kernel;
+    prepareKernelNormal(effectModule, effectData, source, kernel, binCount, sampleRate);
+    runEffectKernels({ &kernel, 1 }, source.sourceBuffer, destination, binCount);
+  }
+
+  struct GateKernelState
+  {
+    simd_float threshold;
+    simd_float gainParameter;
+    simd_mask gainType;
+    simd_float slopeMultiplier;
+    // tilt slope of the next bin, recomputed if the kernel skips ahead
+    simd_float slope;
+    u32 nextIndex;
+  };
+
+  template<utils::MathPrecision Precision>
+  static void gateKernel(void *state, simd_float &one, simd_float &two, u32 index)
+  {
+    using namespace utils;
+
+    auto &s = *(GateKernelState *)state;
+    if (index != s.nextIndex)
+      s.slope = utils::pow(s.slopeMultiplier, (float)index);
+
+    auto gate = [&](simd_float dry)
     {
-      // 1. both positionIndices and cutoffIndices are >= lowBound and < FFTSize_ or <= highBound and > 0
-      // 2. cutoffIndices/positionIndices is >= lowBound and < FFTSize_ and
-      //     positionIndices/cutoffIndices is <= highBound and > 0
+      simd_mask isAboveThresholdMask = simd_float::greaterThanOrEqual(complexMagnitude(dry, true) * s.slope, s.threshold);
+      s.slope *= s.slopeMultiplier;
+      // dry >= threshold && gain >= 0db ===> don't change
+      // dry >= threshold && gain <  0db ===> attenuate
+      // dry <  threshold && gain >= 0db ===> attenuate
+      // dry <  threshold && gain <  0db ===> don't change
+      return dry * dbToAmplitude<Precision>(s.gainParameter & (s.gainType ^ isAboveThresholdMask));
+    };
 
-      using namespace utils;
+    one = gate(one);
+    two = gate(two);
+    s.nextIndex = index + 2;
+  }
 
-      simd_mask cutoffAbovePositions = simd_mask::greaterThanOrEqualSigned(cutoffIndices, positionIndices);
+  static void initialiseGateKernel(EffectModule *effectModule, EffectData *effectData,
+    EffectKernel &kernel, simd_float threshold, u32 binCount, float sampleRate) noexcept
+  {
+    using namespace utils;
+    using namespace Framework;
 
-      // preparing masks for 1.
-      simd_mask positionsAboveLowMask = simd_mask::greaterThanOrEqualSigned(positionIndices, lowBoundIndices);
-      simd_mask bothAboveOrBelowLowMask = ~(positionsAboveLowMask ^ cutoffAboveLowMask);
+    // gains are either 0db or the gain parameter, small errors are inaudible
+    static constexpr auto kPrecision = MathPrecision::Fast;
 
-      // preparing masks for 2.
-      simd_mask positionsBelowLowBoundAndCutoffsMask = ~positionsAboveLowMask & cutoffAboveLowMask;
-      simd_mask cutoffBelowLowBoundAndPositionsMask = positionsAboveLowMask & ~cutoffAboveLowMask;
+    // getting the boundaries in terms of bin position
+    auto [lowBound, highBound] = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
+    kernel.lowBoundIndices = toInt(lowBound);
+    kernel.highBoundIndices = toInt(highBound);
 
-      // masking for 1.
-      simd_int precedingIndices  = merge(cutoffIndices  , positionIndices, bothAboveOrBelowLowMask & cutoffAbovePositions);
-      simd_int succeedingIndices = merge(positionIndices, cutoffIndices  , bothAboveOrBelowLowMask & cutoffAbovePositions);
+    simd_float gainParameter = getParameter(effectData, Filter::Gate::Gain)->getInternalValue<simd_float>(sampleRate);
 
-      // masking for 2.
-      // first 2 are when cutoffs/positions are above/below lowBound
-      // second 2 are when positions/cutoffs are above/below lowBound
-      precedingIndices  = merge(precedingIndices , cutoffIndices  , ~bothAboveOrBelowLowMask & positionsBelowLowBoundAndCutoffsMask);
-      succeedingIndices = merge(succeedingIndices, positionIndices, ~bothAboveOrBelowLowMask & positionsBelowLowBoundAndCutoffsMask);
-      precedingIndices  = merge(precedingIndices , positionIndices, ~bothAboveOrBelowLowMask & cutoffBelowLowBoundAndPositionsMask );
-      succeedingIndices = merge(succeedingIndices, cutoffIndices  , ~bothAboveOrBelowLowMask & cutoffBelowLowBoundAndPositionsMask );
+    static_assert(sizeof(GateKernelState) <= EffectKernel::kStateSize);
+    new(kernel.state) GateKernelState
+    {
+      .threshold = threshold,
+      .gainParameter = -gainParameter,
+      .gainType = ~unsignSimd<true>(gainParameter),
+      .slopeMultiplier = getTiltSlopeMultiplier(
+        getParameter(effectData, Filter::Gate::Tilt)->getInternalValue<simd_float>(sampleRate),
+        sampleRate, binCount),
+      .slope = 1.0f,
+      .nextIndex = 0
+    };
 
-      auto binToNormalised = [&](simd_int bin)
-      {
-        return (log2(toFloat(bin) * binDivisor) * invLog2Nyquist) & simd_int::notEqual(bin, 0);
-      };
+    kernel.function = isRenderingOffline(effectModule) ?
+      gateKernel<MathPrecision::Accurate> : gateKernel<kPrecision>;
+  }
+
+  // finds the tilted magnitude above which the loudest keepFraction of the bins in each channel lie
+  //
+  // radix-style selection instead of sorting, positive floats order the same as their bits so
+  // the first pass builds a histogram of the upper bits of every bin's power and finds the bucket holding the cutoff,
+  // the second pass does the same with the middle bits of only that bucket's bins;
+  // the lowest bits are ignored, so bins within 2^-14 of the cutoff are all kept
+  static simd_float getRankThreshold(utils::ca<const simd_float> powers, Framework::SimdBuffer *scratch,
+    const BoundsSpans &spans, simd_int lowBoundIndices, simd_int highBoundIndices,
+    simd_float slopeMultiplier, simd_float keepFraction,
+    u32 (&histograms)[utils::kChannelsPerInOut][Filter::GateData::kRankBucketCount]) noexcept
+  {
+    using namespace utils;
 
-      auto ratio = getDecimalPlaces(simd_float{ 1.0f } + binToNormalised(succeedingIndices) - binToNormalised(precedingIndices));
-      // all i have to say is, floating point error
-      return ratio & simd_int::notEqual(precedingIndices, succeedingIndices);
+    static constexpr u32 kBucketBits = Filter::GateData::kRankBucketBits;
+    static constexpr u32 kBucketCount = Filter::GateData::kRankBucketCount;
+    // the sign bit is never set for powers, it's used to exclude bins outside of stereo bounds instead
+    static constexpr u32 kPrefixShift = 31 - kBucketBits;
+    static constexpr u32 kSuffixShift = kPrefixShift - kBucketBits;
+
+    auto rawScratch = scratch->get();
+    simd_mask isHighAboveLow = simd_int::greaterThanOrEqualSigned(highBoundIndices, lowBoundIndices);
+
+    zeroset(&histograms);
+    u32 prefixes[kChannelsPerInOut]{};
+    u32 remaining[kChannelsPerInOut]{};
+    // channels where the cutoff is already known, or that don't need one
+    bool isDone[kChannelsPerInOut]{};
+    simd_float threshold = 0.0f;
+
+    // returns the bucket holding the keep-th largest entry, keep is decremented by the entries above it
+    auto selectBucket = [](const u32 (&histogram)[kBucketCount], u32 &keep)
+    {
+      u32 bucket = kBucketCount - 1;
+      for (; bucket > 0 && histogram[bucket] < keep; --bucket)
+        keep -= histogram[bucket];
+      return bucket;
     };
 
-    auto rawDestination = destination->get();
-    circularLoop([&](u32 index)
+    spans.forEachProcessed([&](u32 begin, u32 end)
       {
-        // the distances are logarithmic
-        // TODO: memoise cutoff distances and update only when low/high bound indices and binCount are changed
-        simd_float distancesFromCutoff = calculateDistancesFromCutoffs(index);
-
-        // calculating linear slope and brickwall, both are ratio of the gain attenuation
-        // the higher tha value the more it will be affected by it
-        simd_float gainRatio = merge(
-          simd_float::clamp(merge(distancesFromCutoff / slopes, simd_float{ 1.0f }, slopeZeroMask), 0.0f, 1.0f),
-          simd_float{ 1.0f } & simd_float::greaterThanOrEqual(distancesFromCutoff, slopes),
-          slopeMask);
-        simd_float gains = merge(gainsParameter * gainRatio, gainsParameter * (simd_float{ 1.0f } - gainRatio), gainType);
-
-        // convert db reduction to amplitude multiplier
-        gains = dbToAmplitude(-gains);
-
-        rawDestination[index] = merge(rawDestination[index] * gains, rawDestination[index],
-          isOutsideBounds(start, lowBoundIndices, highBoundIndices, isHighAboveLowMask));
-      }, start, processedCount, binCount);
+        simd_float slope = utils::pow(slopeMultiplier, (float)begin);
+        for (u32 i = begin; i < end; ++i)
+        {
+          simd_float power = powers[i] * slope * slope;
+          if (spans.isStereo)
+            power |= isOutsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLow) & simd_mask{ kSignMask };
+          rawScratch[i] = power;
+          slope *= slopeMultiplier;
+
+          simd_int keys = reinterpretToInt(power);
+          for (u32 j = 0; j < kChannelsPerInOut; ++j)
+            if (!(keys[2 * j] & kSignMask))
+              ++histograms[j][keys[2 * j] >> kPrefixShift];
+        }
+      });
+
+    for (u32 j = 0; j < kChannelsPerInOut; ++j)
+    {
+      u32 count = 0;
+      for (u32 bucketCount : histograms[j])
+        count += bucketCount;
+
+      u32 keep = (u32)((float)count * utils::clamp(keepFraction[2 * j], 0.0f, 1.0f) + 0.5f);
+      if (keep == 0 || keep >= count)
+      {
+        threshold = merge(threshold, (keep == 0) ? kFloatInf : 0.0f, kChannelMasks[j]);
+        isDone[j] = true;
+        continue;
+      }
+
+      remaining[j] = keep;
+      prefixes[j] = selectBucket(histograms[j], remaining[j]);
+      zeroset(&histograms[j]);
+    }
+
+    bool isAllDone = true;
+    for (bool isChannelDone : isDone)
+      isAllDone &= isChannelDone;
+    if (isAllDone)
+      return threshold;
+
+    // only the bins of the selected buckets are counted, the keys are already in scratch
+    spans.forEachProcessed([&](u32 begin, u32 end)
+      {
+        for (u32 i = begin; i < end; ++i)
+        {
+          simd_int keys = reinterpretToInt(rawScratch[i]);
+          for (u32 j = 0; j < kChannelsPerInOut; ++j)
+            if (!isDone[j] && (keys[2 * j] >> kPrefixShift) == prefixes[j])
+              ++histograms[j][(keys[2 * j] >> kSuffixShift) & (kBucketCount - 1)];
+        }
+      });
+
+    for (u32 j = 0; j < kChannelsPerInOut; ++j)
+    {
+      if (isDone[j])
+        continue;
+
+      u32 suffix = selectBucket(histograms[j], remaining[j]);
+      u32 key = (prefixes[j] << kPrefixShift) | (suffix << kSuffixShift);
+      threshold = merge(threshold, simd_float::sqrt(reinterpretToFloat(simd_int{ key })), kChannelMasks[j]);
+    }
+
+    return threshold;
   }
 
-  void Filter::runGate(EffectModule *effectModule, EffectData *effectData,
-    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
-    u32 binCount, float sampleRate) noexcept
+  bool Filter::prepareKernelGate(EffectModule *effectModule, EffectData *effectData,
+    Framework::ComplexDataSource &, EffectKernel &kernel, u32 binCount, float sampleRate) noexcept
   {
     using namespace utils;
     using namespace Framework;
 
-    // getting the boundaries in terms of bin position
-    auto [lowBoundIndices, highBoundIndices] = [&]()
-    {
-      auto shiftedBoundsIndices = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
-      return utils::pair{ toInt(shiftedBoundsIndices.first), toInt(shiftedBoundsIndices.second) };
-    }();
-    simd_mask isHighAboveLowMask = simd_int::greaterThanOrEqualSigned(highBoundIndices, lowBoundIndices);
-
-    // minimising the bins to iterate on
-    //auto [start, processedCount, _] = minimiseRange(lowBoundIndices, highBoundIndices, binCount, true);
+    // rank needs to see the whole spectrum before it can gate anything
+    auto [modeId, _] = getParameter(effectData, Filter::Gate::Mode)->getInternalValue<IndexedData>(sampleRate);
+    if (modeId->id == Filter::GateMode::Rank)
+      return false;
 
     simd_float threshold = (float)binCount * dbToAmplitude(getParameter(effectData, Filter::Gate::Threshold)
       ->getInternalValue<simd_float>(sampleRate));
-    simd_float gainParameter = getParameter(effectData, Filter::Gate::Gain)->getInternalValue<simd_float>(sampleRate);
-    simd_mask gainType = ~unsignSimd<true>(gainParameter);
-    gainParameter = -gainParameter;
+    initialiseGateKernel(effectModule, effectData, kernel, threshold, binCount, sampleRate);
 
-    simd_float slope = 1.0f;
-    simd_float slopeMultiplier = getTiltSlopeMultiplier(
-      getParameter(effectData, Filter::Gate::Tilt)->getInternalValue<simd_float>(sampleRate),
-      sampleRate, binCount);
+    return true;
+  }
 
-    auto rawSource = source.sourceBuffer->get();
-    auto rawDestination = destination->get();
+  void Filter::runGate(EffectModule *effectModule, EffectData *effectData,
+    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
+    u32 binCount, float sampleRate) noexcept
+  {
+    using namespace utils;
+    using namespace Framework;
 
-    for (u32 i = 0; i < binCount; ++i)
+    EffectKernel kernel;
+    if (!prepareKernelGate(effectModule, effectData, source, kernel, binCount, sampleRate))
     {
-      simd_float dry = rawSource[i];
-      simd_mask isAboveThresholdMask = simd_float::greaterThanOrEqual(complexMagnitude(dry, true) * slope, threshold);
-      // dry >= threshold && gain >= 0db ===> don't change
-      // dry >= threshold && gain <  0db ===> attenuate
-      // dry <  threshold && gain >= 0db ===> attenuate
-      // dry <  threshold && gain <  0db ===> don't change
-      simd_float gains = dbToAmplitude(gainParameter & (gainType ^ isAboveThresholdMask));
-
-      rawDestination[i] = merge(dry * gains, dry,
-        isOutsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLowMask));
-      slope *= slopeMultiplier;
+      // the threshold parameter picks the share of bins that are gated, the loudest rest is kept
+      auto [lowBound, highBound] = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
+      simd_int lowBoundIndices = toInt(lowBound);
+      simd_int highBoundIndices = toInt(highBound);
+      simd_float keepFraction = simd_float{ 1.0f } - getParameter(effectData, Filter::Gate::Threshold)
+        ->getInternalValue<simd_float>(sampleRate, true);
+      simd_float slopeMultiplier = getTiltSlopeMultiplier(
+        getParameter(effectData, Filter::Gate::Tilt)->getInternalValue<simd_float>(sampleRate),
+        sampleRate, binCount);
+
+      simd_float threshold = getRankThreshold(getSourcePowers(source, binCount), source.scratchBuffer,
+        getBoundsSpans(lowBoundIndices, highBoundIndices, binCount), lowBoundIndices, highBoundIndices,
+        slopeMultiplier, keepFraction, ((Filter::GateData *)effectData)->rankHistograms);
+      initialiseGateKernel(effectModule, effectData, kernel, threshold, binCount, sampleRate);
     }
+
+    runEffectKernels({ &kernel, 1 }, source.sourceBuffer, destination, binCount);
   }
 
-  void Dynamics::runContrast(EffectModule *effectModule, EffectData *effectData,
+  template<utils::MathPrecision Precision>
+  static void applyContrast(EffectModule *effectModule, EffectData *effectData,
     Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
     u32 binCount, float sampleRate) noexcept
   {
@@ -733,6 +1140,7 @@ namespace Generation
     auto rawSource = source.sourceBuffer->get();
     auto rawScratch = source.scratchBuffer->get();
     auto rawDestination = destination->get();
+    auto powers = getSourcePowers(source, binCount);
 
     // starting point is the weighted average
     //
@@ -751,23 +1159,30 @@ namespace Generation
     simd_float maxMagnitude = 0.0f;
     simd_float minMagnitude = kFloatInf;
     simd_float avg = 0.0f;
-    simd_float slope = 1.0f;
-    // 2^(-i)
-    simd_float weight = 1.0f;
-    for (u32 i = 0; i < binCount; ++i)
-    {
-      // copy both un/processed data
-      rawDestination[i] = rawSource[i];
-      simd_mask isInsideBoundsMask = isInsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLowMask);
-      rawScratch[i] = reinterpretToFloat(isInsideBoundsMask);
-      simd_float magnitude = slope * complexMagnitude(rawSource[i], true);
-      avg = merge(avg, avg + magnitude, isInsideBoundsMask);
-      maxMagnitude = merge(maxMagnitude, magnitude, simd_float::greaterThan(magnitude, maxMagnitude) & isInsideBoundsMask);
-      minMagnitude = merge(minMagnitude, magnitude, simd_float::lessThan(magnitude, minMagnitude) & isInsideBoundsMask);
-
-      weight *= 0.5f;
-      slope *= slopeMultiplier;
-    }
+
+    // the passes before the last one only read the source, destination is written once at the end
+    // with stereo bounds the processed span covers everything and the inside mask is kept in scratch
+    auto spans = getBoundsSpans(lowBoundIndices, highBoundIndices, binCount);
+    spans.forEachProcessed([&](u32 begin, u32 end)
+      {
+        simd_float slope = utils::pow(slopeMultiplier, (float)spans.getRangePosition(begin));
+        for (u32 i = begin; i < end; ++i)
+        {
+          simd_mask isInsideBoundsMask = simd_mask{ kFullMask };
+          if (spans.isStereo)
+          {
+            isInsideBoundsMask = isInsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLowMask);
+            rawScratch[i] = reinterpretToFloat(isInsideBoundsMask);
+          }
+
+          simd_float magnitude = slope * simd_float::sqrt(powers[i]);
+          avg = merge(avg, avg + magnitude, isInsideBoundsMask);
+          maxMagnitude = merge(maxMagnitude, magnitude, simd_float::greaterThan(magnitude, maxMagnitude) & isInsideBoundsMask);
+          minMagnitude = merge(minMagnitude, magnitude, simd_float::lessThan(magnitude, minMagnitude) & isInsideBoundsMask);
+
+          slope *= slopeMultiplier;
+        }
+      });
 
     {
       // integral(0, inf, 2^(-i)), sum of all the weights
@@ -795,26 +1210,12 @@ namespace Generation
       maxMagnitude *= maxMagnitude;
     }
 
-    // minimising the bins to iterate on
-    auto [start, processedCount, _] = minimiseRange(lowBoundIndices, highBoundIndices, binCount, true);
-    slope = utils::pow(slopeMultiplier, (float)start);
-
-    simd_float inPower = 0.0f;
-    circularLoop([&](u32 index)
-      {
-        simd_float magnitude = slope * complexMagnitude(rawDestination[index], false);
-        rawScratch[index] &= simd_float::greaterThanOrEqual(magnitude, minMagnitude) &
-          simd_float::lessThanOrEqual(magnitude, maxMagnitude);
-        inPower += magnitude & rawScratch[index];
-        slope *= slopeMultiplier;
-      }, start, processedCount, binCount);
-
     // calculating contrast
     simd_float depthParameter = getParameter(effectData, Dynamics::Contrast::Depth)
       ->getInternalValue<simd_float>(sampleRate);
     simd_float contrast = depthParameter * depthParameter;
-    contrast = merge(kContrastMaxNegativeValue * contrast,
-      kContrastMaxPositiveValue * contrast,
+    contrast = merge(Dynamics::kContrastMaxNegativeValue * contrast,
+      Dynamics::kContrastMaxPositiveValue * contrast,
       simd_float::greaterThanOrEqual(depthParameter, 0.0f));
 
     simd_float min = exp(-80.0f / (contrast * 2.0f + 1.0f));
@@ -822,33 +1223,111 @@ namespace Generation
     min = merge(1e-30f, min, simd_float::greaterThan(contrast, 0.0f));
     max = merge(1e+30f, max, simd_float::greaterThan(contrast, 0.0f));
 
+    // every contrasted bin is bin * inScale * (inScale * |slope * bin|)^contrast,
+    // so the gains can be taken before inScale is known and the output power derived from them:
+    //   outPower = inScale^(2 + 2 * contrast) * sum(|slope * bin|^(2 + 2 * contrast))
+    // scratch holds the gains |slope * bin|^contrast for bins in range and -1 for the rest
+    simd_float halfContrast = contrast * 0.5f;
+    simd_float inPower = 0.0f;
+    simd_float contrastedPower = 0.0f;
+    simd_float smallestPower = kFloatInf;
+    simd_float largestPower = 0.0f;
+    spans.forEachProcessed([&](u32 begin, u32 end)
+      {
+        simd_float slope = utils::pow(slopeMultiplier, (float)spans.getRangePosition(begin));
+        for (u32 i = begin; i < end; ++i)
+        {
+          simd_float magnitude = slope * powers[i];
+          simd_mask isInRangeMask = simd_float::greaterThanOrEqual(magnitude, minMagnitude) &
+            simd_float::lessThanOrEqual(magnitude, maxMagnitude);
+          if (spans.isStereo)
+            isInRangeMask &= reinterpretToInt(rawScratch[i]);
+          inPower += magnitude & isInRangeMask;
+
+          // silent bins stay silent, excluding them so that negative contrast doesn't produce inf
+          simd_float power = slope * magnitude;
+          simd_mask isAudibleMask = simd_float::greaterThan(power, 0.0f);
+          simd_float gain = pow<Precision>(power, halfContrast) & isAudibleMask;
+          contrastedPower += (power * gain * gain) & isInRangeMask;
+          smallestPower = merge(smallestPower, simd_float::min(smallestPower, power), isInRangeMask & isAudibleMask);
+          largestPower = merge(largestPower, simd_float::max(largestPower, power), isInRangeMask);
+
+          rawScratch[i] = merge(simd_float{ -1.0f }, gain, isInRangeMask);
+          slope *= slopeMultiplier;
+        }
+      });
+
     simd_int boundDistanceCount = (modOnce(binCount + highBoundIndices - lowBoundIndices, binCount) + 1)
       & simd_int::notEqual(lowBoundIndices, highBoundIndices);
     simd_float inScale = matchPower(toFloat(boundDistanceCount), inPower);
 
-    slope = utils::pow(slopeMultiplier, (float)start);
+    copyUnprocessedSpans(source.sourceBuffer, destination, spans);
+
+    // if no bin reaches the min/max guards the derived output power is exact,
+    // so gain and normalisation are applied together
+    simd_mask isOutsideGuardsMask = simd_float::lessThan(simd_float::sqrt(smallestPower) * inScale, min) |
+      simd_float::greaterThanOrEqual(simd_float::sqrt(largestPower) * inScale, max);
+    if (simd_mask::anyMask(isOutsideGuardsMask) == 0)
+    {
+      simd_float scaledInScale = pow(inScale, contrast + 1.0f);
+      simd_float outScale = matchPower(inPower, scaledInScale * scaledInScale * contrastedPower);
+      simd_float gainScale = scaledInScale * outScale;
+
+      spans.forEachProcessed([&](u32 begin, u32 end)
+        {
+          for (u32 i = begin; i < end; ++i)
+          {
+            simd_float gain = rawScratch[i];
+            rawDestination[i] = rawSource[i] * merge(simd_float{ 1.0f }, gain * gainScale,
+              simd_float::greaterThanOrEqual(gain, 0.0f));
+          }
+        });
+
+      return;
+    }
 
     // applying gain and calculating outPower
     simd_float outPower = 0.0f;
-    circularLoop([&](u32 index)
+    spans.forEachProcessed([&](u32 begin, u32 end)
       {
-        simd_float bin = slope * inScale * rawDestination[index];
-        simd_float magnitude = complexMagnitude(bin, true);
+        simd_float slope = utils::pow(slopeMultiplier, (float)spans.getRangePosition(begin));
+        for (u32 i = begin; i < end; ++i)
+        {
+          simd_mask isInRangeMask = simd_float::greaterThanOrEqual(rawScratch[i], 0.0f);
+          simd_float bin = slope * inScale * rawSource[i];
+          simd_float magnitude = complexMagnitude(bin, true);
 
-        bin &= simd_float::lessThanOrEqual(min, magnitude);
-        bin = merge(bin, bin * pow(magnitude, contrast), simd_float::greaterThan(max, magnitude));
+          bin &= simd_float::lessThanOrEqual(min, magnitude);
+          bin = merge(bin, bin * pow<Precision>(magnitude, contrast), simd_float::greaterThan(max, magnitude));
 
-        outPower += complexMagnitude(bin, false) & reinterpretToInt(rawScratch[index]);
-        rawDestination[index] = merge(rawDestination[index], bin / slope, reinterpretToInt(rawScratch[index]));
-        slope *= slopeMultiplier;
-      }, start, processedCount, binCount);
+          outPower += complexMagnitude(bin, false) & isInRangeMask;
+          rawDestination[i] = merge(rawSource[i], bin / slope, isInRangeMask);
+          slope *= slopeMultiplier;
+        }
+      });
 
     // normalising
     simd_float outScale = matchPower(inPower, outPower);
-    circularLoop([&](u32 index)
+    spans.forEachProcessed([&](u32 begin, u32 end)
       {
-        rawDestination[index] *= merge(1.0f, outScale, reinterpretToInt(rawScratch[index]));
-      }, start, processedCount, binCount);
+        for (u32 i = begin; i < end; ++i)
+          rawDestination[i] *= merge(1.0f, outScale, simd_float::greaterThanOrEqual(rawScratch[i], 0.0f));
+      });
+  }
+
+  void Dynamics::runContrast(EffectModule *effectModule, EffectData *effectData,
+    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
+    u32 binCount, float sampleRate) noexcept
+  {
+    using enum utils::MathPrecision;
+
+    // per bin gains, the output gets normalised afterwards so the relative errors mostly cancel out
+    static constexpr auto kPrecision = Fast;
+
+    if (isRenderingOffline(effectModule))
+      applyContrast<Accurate>(effectModule, effectData, source, destination, binCount, sampleRate);
+    else
+      applyContrast<kPrecision>(effectModule, effectData, source, destination, binCount, sampleRate);
   }
 
   void Dynamics::runClip(EffectModule *effectModule, EffectData *effectData,
@@ -873,22 +1352,31 @@ namespace Generation
 
     auto rawSource = source.sourceBuffer->get();
     auto rawDestination = destination->get();
+    auto powers = getSourcePowers(source, binCount);
 
-    // getting the min/max power in the range selected
-    utils::pair<simd_float, simd_float> powerMinMax{ kLoudestThreshold, kSilenceThreshold };
-    for (u32 j = 0; j < binCount; j++)
+    // with stereo bounds the processed span covers everything and bins are masked individually
+    auto spans = getBoundsSpans(lowBoundIndices, highBoundIndices, binCount);
+    auto getInsideMask = [&](u32 index) -> simd_mask
     {
-      // while calculating the power min-max we can copy over data
-      rawDestination[j] = rawSource[j];
-
-      simd_float magnitude = complexMagnitude(rawDestination[j], false);
-      simd_mask isIndexOutside = isOutsideBounds(j, lowBoundIndices, highBoundIndices, isHighAboveLowMask);
-      powerMinMax.first  = merge(simd_float::min(powerMinMax.first , magnitude), powerMinMax.first , isIndexOutside);
-      powerMinMax.second = merge(simd_float::max(powerMinMax.second, magnitude), powerMinMax.second, isIndexOutside);
-    }
+      if (!spans.isStereo)
+        return simd_mask{ kFullMask };
+      return isInsideBounds(index, lowBoundIndices, highBoundIndices, isHighAboveLowMask);
+    };
 
-    // minimising the bins to iterate on
-    auto [start, processedCount, _] = minimiseRange(lowBoundIndices, highBoundIndices, binCount, true);
+    // getting the min/max power in the range selected, as well as the input power
+    utils::pair<simd_float, simd_float> powerMinMax{ kLoudestThreshold, kSilenceThreshold };
+    simd_float inPower = 0.0f;
+    spans.forEachProcessed([&](u32 begin, u32 end)
+      {
+        for (u32 j = begin; j < end; j++)
+        {
+          simd_float magnitude = powers[j];
+          simd_mask isIndexInside = getInsideMask(j);
+          powerMinMax.first  = merge(powerMinMax.first , simd_float::min(powerMinMax.first , magnitude), isIndexInside);
+          powerMinMax.second = merge(powerMinMax.second, simd_float::max(powerMinMax.second, magnitude), isIndexInside);
+          inPower += magnitude & isIndexInside;
+        }
+      });
 
     // calculating clipping
     simd_float thresholdParameter = getParameter(effectData, Dynamics::Clip::Threshold)
@@ -900,36 +1388,42 @@ namespace Generation
     simd_float slopeMultiplier = getTiltSlopeMultiplier(
       -getParameter(effectData, Dynamics::Clip::Tilt)->getInternalValue<simd_float>(sampleRate),
       sampleRate, binCount);
-    // reset slope to the start of the covered range
-    threshold *= utils::pow(slopeMultiplier, (float)start);
 
-    // doing clipping
-    simd_float inPower = 0.0f;
+    // the clipped power only depends on the source, so it's gathered before anything is written
     simd_float outPower = 0.0f;
-    circularLoop([&](u32 index)
+    spans.forEachProcessed([&](u32 begin, u32 end)
       {
-        simd_mask isIndexInside = isInsideBounds(index, lowBoundIndices, highBoundIndices, isHighAboveLowMask);
-        simd_float magnitude = complexMagnitude(rawDestination[index], false);
-
-        // 0/0 and >0/0 masking, prevents NaN and Inf respectively
-        simd_float rescale = simd_float::sqrt(threshold / magnitude) &
-          simd_float::notEqual(threshold, 0.0f) & simd_float::notEqual(magnitude, 0.0f);
-        rawDestination[index] *= merge(1.0f, rescale,
-          simd_float::greaterThanOrEqual(magnitude, threshold) & isIndexInside);
-
-        inPower += magnitude & isIndexInside;
-        outPower += simd_float::min(magnitude, threshold) & isIndexInside;
-        threshold *= slopeMultiplier;
-      }, start, processedCount, binCount);
+        // reset slope to the start of the covered range
+        simd_float currentThreshold = threshold * utils::pow(slopeMultiplier, (float)spans.getRangePosition(begin));
+        for (u32 index = begin; index < end; ++index)
+        {
+          simd_float magnitude = powers[index];
+          outPower += simd_float::min(magnitude, currentThreshold) & getInsideMask(index);
+          currentThreshold *= slopeMultiplier;
+        }
+      });
 
-    // normalising
     simd_float outScale = matchPower(inPower, outPower);
     outScale = merge(outScale, 1.0f, simd_float::isNan(outScale));
-    circularLoop([&](u32 index)
+
+    // doing clipping and normalising
+    copyUnprocessedSpans(source.sourceBuffer, destination, spans);
+    spans.forEachProcessed([&](u32 begin, u32 end)
       {
-        rawDestination[index] = merge(rawDestination[index] * outScale, rawDestination[index],
-          isOutsideBounds(index, lowBoundIndices, highBoundIndices, isHighAboveLowMask));
-      }, start, processedCount, binCount);
+        simd_float currentThreshold = threshold * utils::pow(slopeMultiplier, (float)spans.getRangePosition(begin));
+        for (u32 index = begin; index < end; ++index)
+        {
+          simd_float magnitude = powers[index];
+
+          // 0/0 and >0/0 masking, prevents NaN and Inf respectively
+          simd_float rescale = simd_float::sqrt(currentThreshold / magnitude) &
+            simd_float::notEqual(currentThreshold, 0.0f) & simd_float::notEqual(magnitude, 0.0f);
+          rescale = merge(1.0f, rescale, simd_float::greaterThanOrEqual(magnitude, currentThreshold));
+
+          rawDestination[index] = rawSource[index] * merge(1.0f, rescale * outScale, getInsideMask(index));
+          currentThreshold *= slopeMultiplier;
+        }
+      });
   }
 
   // TODO: broken version but makes cool artifacts
@@ -1034,7 +1528,8 @@ namespace Generation
     // minimising the bins to iterate on
     auto [start, processedCount, _] = minimiseRange(lowBoundIndices, highBoundIndices, binCount, true);
 
-    simd_float shiftIncrement = cis(kPi * (getParameter(effectData, Phase::Shift::PhaseShift)
+    // computed once and then accumulated, so errors here add up over the spectrum
+    simd_float shiftIncrement = cis<MathPrecision::Accurate>(kPi * (getParameter(effectData, Phase::Shift::PhaseShift)
       ->getInternalValue<simd_float>(sampleRate, true) * 2.0f - 1.0f));
     simd_float shift = shiftIncrement;
     simd_float interval = getParameter(effectData, Phase::Shift::Interval)->getInternalValue<simd_float>(sampleRate);
@@ -1050,7 +1545,7 @@ namespace Generation
         return [](simd_float x, simd_float increment)
         {
           auto y = complexCartMul(x, increment);
-          return y * simd_float::invSqrt(complexMagnitude(y, false));
+          return y * invSqrt<MathPrecision::Fast>(complexMagnitude(y, false));
         };
       }
       else if (slopeId->id == Phase::SlopeOptions::Exponential)
@@ -1059,7 +1554,7 @@ namespace Generation
         {
           auto y = complexCartMul(x, x);
           // necessary renormalisation because floating point inaccuracies cause +/- inf explosions
-          return y * simd_float::invSqrt(complexMagnitude(y, false));
+          return y * invSqrt<MathPrecision::Fast>(complexMagnitude(y, false));
         };
       }
 
@@ -1068,7 +1563,8 @@ namespace Generation
     }();
 
     // overwrite old data
-    applyToThisNoMask<MathOperations::Assign>(destination, source.sourceBuffer, destination->channels, binCount);
+    if (destination != source.sourceBuffer)
+      applyToThisNoMask<MathOperations::Assign>(destination, source.sourceBuffer, destination->channels, binCount);
 
     auto rawDestination = destination->get();
 
@@ -1187,6 +1683,8 @@ namespace Generation
 
     static constexpr auto kNeighbourBins = 2;
     static constexpr float kMultiplierEpsilon = 1e-12f;
+    // coefficients are recalculated for every bin
+    static constexpr auto kPrecision = MathPrecision::Medium;
 
     auto [lowBoundIndices, highBoundIndices] = [&]()
     {
@@ -1208,10 +1706,10 @@ namespace Generation
       auto cycle = binFloatingPointShift * source.blockPhase;
       // modding the phase to get more accurate values, not important
       cycle -= simd_float::round(cycle * 0.5f) * 2.0f;
-      phaseShift = cis(cycle * k2Pi);
+      phaseShift = cis<kPrecision>(cycle * k2Pi);
 
       simd_float denominator = (simd_float::round(binFloatingPointShift) - binFloatingPointShift) * k2Pi;
-      simd_float numerator = (simd_float{ 0.0f, 1.0f } - switchInner(cis(denominator))) ^ simd_mask{ kSignMask, 0U };
+      simd_float numerator = (simd_float{ 0.0f, 1.0f } - switchInner(cis<kPrecision>(denominator))) ^ simd_mask{ kSignMask, 0U };
 
       // this might at some point in time fail and the effect will produce silence unless gain matching is enabled
       // in that case this guard has not done its job and should be increased
@@ -1328,6 +1826,8 @@ namespace Generation
 
     static constexpr auto kNeighbourBins = 2;
     static constexpr float kMultiplierEpsilon = 1e-5f;
+    // coefficients are calculated once per block
+    static constexpr auto kPrecision = MathPrecision::Accurate;
 
     auto [lowBoundIndices, highBoundIndices] = [&]()
     {
@@ -1349,10 +1849,10 @@ namespace Generation
         auto cycle = binFloatingPointShift * source.blockPhase;
         // modding the phase to get more accurate values, not important
         cycle -= simd_float::round(cycle * 0.5f) * 2.0f;
-        phaseShift = cis(cycle * k2Pi);
+        phaseShift = cis<kPrecision>(cycle * k2Pi);
       }
       simd_float denominator = (simd_float::round(binFloatingPointShift) - binFloatingPointShift) * k2Pi;
-      simd_float numerator = (simd_float{ 0.0f, 1.0f } - switchInner(cis(denominator))) ^ simd_mask{ kSignMask, 0U };
+      simd_float numerator = (simd_float{ 0.0f, 1.0f } - switchInner(cis<kPrecision>(denominator))) ^ simd_mask{ kSignMask, 0U };
 
       // this might at some point in time fail and the effect will produce silence unless gain matching is enabled
       // in that case this guard has not done its job and should be increased
@@ -1373,12 +1873,8 @@ namespace Generation
     auto rawDestination = destination->get();
     auto rawSource = source.sourceBuffer->get();
 
-    for (u32 i = 0; i < binCount; ++i)
+    auto shiftBin = [&](u32 i, simd_float wet)
     {
-      simd_mask outsideBoundsMask = isOutsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLow);
-      rawDestination[i] += rawSource[i] & outsideBoundsMask;
-      simd_float wet = rawSource[i] & ~outsideBoundsMask;
-
       for (u32 j = 0; j < countof(leakMultipliers); ++j)
       {
         simd_int indices = simd_int{ (i - (u32)kNeighbourBins + j) } + binShift;
@@ -1388,7 +1884,32 @@ namespace Generation
         scatterAddComplex(rawDestination.pointer, clampedIndices,
           complexCartMul(wet, leakMultipliers[j]), inRangeMask);
       }
+    };
+
+    auto spans = getBoundsSpans(lowBoundIndices, highBoundIndices, binCount);
+    if (spans.isStereo)
+    {
+      for (u32 i = 0; i < binCount; ++i)
+      {
+        simd_mask outsideBoundsMask = isOutsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLow);
+        rawDestination[i] += rawSource[i] & outsideBoundsMask;
+        shiftBin(i, rawSource[i] & ~outsideBoundsMask);
+      }
+
+      return;
     }
+
+    // shifted bins can land outside of the bounds, so dry data is added instead of copied
+    spans.forEachUnprocessed([&](u32 begin, u32 end)
+      {
+        for (u32 i = begin; i < end; ++i)
+          rawDestination[i] += rawSource[i];
+      });
+    spans.forEachProcessed([&](u32 begin, u32 end)
+      {
+        for (u32 i = begin; i < end; ++i)
+          shiftBin(i, rawSource[i]);
+      });
   }
 
   void Freeze::runRolling(EffectModule *effectModule, EffectData *effectData, 
@@ -1433,13 +1954,40 @@ namespace Generation
     }
     simd_mask isHighAboveLow2 = simd_int::greaterThanOrEqualSigned(end, start);
 
-    for (u32 i = 0; i < binCount; ++i)
+    // the rolled over region follows the same circular semantics as the bounds
+    auto refreshSpans = getBoundsSpans(start, end, binCount);
+    if (refreshSpans.isStereo)
+    {
+      for (u32 i = 0; i < binCount; ++i)
+      {
+        simd_mask dontRefreshFreeze = isOutsideBounds(i, start, end, isHighAboveLow2);
+        rawFreezeBuffer[i] = merge(rawSource[i], rawFreezeBuffer[i], dontRefreshFreeze);
+      }
+    }
+    else
+    {
+      refreshSpans.forEachProcessed([&](u32 begin, u32 end)
+        {
+          applyToThisNoMask<MathOperations::Assign>(rollingData->freezeBuffer, source.sourceBuffer,
+            destination->channels, end - begin, 0, 0, begin, begin);
+        });
+    }
+
+    auto spans = getBoundsSpans(lowBoundIndices, highBoundIndices, binCount);
+    if (spans.isStereo)
     {
-      simd_mask dontRefreshFreeze = isOutsideBounds(i, start, end, isHighAboveLow2);
-      simd_float wet = merge(rawSource[i], rawFreezeBuffer[i], dontRefreshFreeze);
-      rawFreezeBuffer[i] = wet;
-      rawDestination[i] = merge(wet, rawSource[i],
-        isOutsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLow));
+      for (u32 i = 0; i < binCount; ++i)
+        rawDestination[i] = merge(rawFreezeBuffer[i], rawSource[i],
+          isOutsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLow));
+    }
+    else
+    {
+      copyUnprocessedSpans(source.sourceBuffer, destination, spans);
+      spans.forEachProcessed([&](u32 begin, u32 end)
+        {
+          applyToThisNoMask<MathOperations::Assign>(destination, rollingData->freezeBuffer,
+            destination->channels, end - begin, 0, 0, begin, begin);
+        });
     }
     
     rollingData->lastPosition = newPosition;
@@ -1447,20 +1995,22 @@ namespace Generation
     rollingData->lastBlockPosition = source.blockPosition;
   }
 
-  void Destroy::runReinterpret(EffectModule *effectModule, EffectData *effectData,
-    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
-    u32 binCount, float sampleRate) noexcept
+  struct ReinterpretKernelState
+  {
+    simd_float attenuation;
+    Destroy::ReinterpretTransformOptions::Value mappingType;
+  };
+
+  bool Destroy::prepareKernelReinterpret(EffectModule *effectModule, EffectData *effectData,
+    Framework::ComplexDataSource &, EffectKernel &kernel, u32 binCount, float sampleRate) noexcept
   {
     using namespace utils;
     using namespace Framework;
 
-    auto [lowBoundIndices, highBoundIndices] = [&]()
-    {
-      auto shiftedBoundsIndices = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
-      return utils::pair{ toInt(shiftedBoundsIndices.first), toInt(shiftedBoundsIndices.second) };
-    }();
-    simd_mask isHighAboveLow = simd_int::greaterThanOrEqualSigned(highBoundIndices, lowBoundIndices);
-    
+    auto [lowBound, highBound] = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
+    kernel.lowBoundIndices = toInt(lowBound);
+    kernel.highBoundIndices = toInt(highBound);
+
     simd_float attenuation = [&]()
     {
       auto parameter = getParameter(effectData, Destroy::Reinterpret::Attenuation)->getInternalValue<simd_float>();
@@ -1468,16 +2018,22 @@ namespace Generation
       return merge(1.0f, dbToAmplitude(parameter | simd_mask{ kSignMask }), mergeMask);
     }();
 
-    auto mappingType = getParameter(effectData,
-      Destroy::Reinterpret::Transform)->getInternalValue<IndexedData>().first->id;
-
-    auto rawDestination = destination->get();
-    auto rawSource = source.sourceBuffer->get();
+    static_assert(sizeof(ReinterpretKernelState) <= EffectKernel::kStateSize);
+    new(kernel.state) ReinterpretKernelState
+    {
+      .attenuation = attenuation,
+      .mappingType = (ReinterpretTransformOptions::Value)getParameter(effectData,
+        Destroy::Reinterpret::Transform)->getInternalValue<IndexedData>().first->id
+    };
 
-    auto operations = [mappingType](simd_float &one, simd_float &two)
+    kernel.function = [](void *state, simd_float &one, simd_float &two, u32)
     {
+      auto &s = *(ReinterpretKernelState *)state;
+      one *= s.attenuation;
+      two *= s.attenuation;
+
       using enum ReinterpretTransformOptions::Value;
-      switch (mappingType)
+      switch (s.mappingType)
       {
       case NoTransform:
         break;
@@ -1497,23 +2053,16 @@ namespace Generation
       }
     };
 
-    simd_float wet[2]{};
-    for (u32 i = 0; i < binCount - 1; i += 2)
-    {
-      wet[0] = rawSource[i] * attenuation;
-      wet[1] = rawSource[i + 1] * attenuation;
-
-      operations(wet[0], wet[1]);
-
-      rawDestination[i    ] = merge(wet[0], rawSource[i    ],
-        isOutsideBounds(i    , lowBoundIndices, highBoundIndices, isHighAboveLow));
-      rawDestination[i + 1] = merge(wet[1], rawSource[i + 1],
-        isOutsideBounds(i + 1, lowBoundIndices, highBoundIndices, isHighAboveLow));
-    }
+    return true;
+  }
 
-    wet[0] = rawSource[binCount - 1] * attenuation;
-    operations(wet[0], wet[1]);
-    rawDestination[binCount - 1] = wet[0];
+  void Destroy::runReinterpret(EffectModule *effectModule, EffectData *effectData,
+    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
+    u32 binCount, float sampleRate) noexcept
+  {
+    EffectKernel kernel;
+    prepareKernelReinterpret(effectModule, effectData, source, kernel, binCount, sampleRate);
+    runEffectKernels({ &kernel, 1 }, source.sourceBuffer, destination, binCount);
   }
 
 #undef PASSTHROUGH_PROCESS
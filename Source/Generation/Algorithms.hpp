@@ -39,6 +39,7 @@ namespace Interface
 namespace Generation
 {
   class EffectModule;
+  struct EffectKernel;
 
   struct EffectData
   {
@@ -47,8 +48,11 @@ namespace Generation
       Framework::SimdBuffer *destination, u32 binCount, float sampleRate);
     using CreateUIFn = utils::span<Interface::Control *>(utils::bumpArena *arena,
       Interface::EffectModuleSection *section, EffectData *effectData);
+    // reads the block's parameters into the kernel, returns false if the effect can't run per bin with them
+    using PrepareKernelFn = bool(EffectModule *effectModule, EffectData *effectData,
+      Framework::ComplexDataSource &source, EffectKernel &kernel, u32 binCount, float sampleRate);
 
-    enum EffectVtableIndices { CreateVtableIndex, RunVtableIndex, CreateUIVtableIndex, VtableIndexCount };
+    enum EffectVtableIndices { CreateVtableIndex, RunVtableIndex, CreateUIVtableIndex, PrepareKernelVtableIndex, VtableIndexCount };
 
     EffectData *next{};
 
@@ -58,6 +62,29 @@ namespace Generation
     u32 parameterCount{};
   };
 
+  // per-bin form of pointwise effects, lets consecutive modules be run in a single pass over the spectrum
+  //
+  // kernels work on pairs of neighbouring bins starting at an even index, because some transforms need both,
+  // nyquist is passed on its own as the first bin with a zeroed second one
+  struct EffectKernel
+  {
+    static constexpr usize kStateSize = 192;
+
+    using KernelFn = void(void *state, simd_float &one, simd_float &two, u32 index);
+
+    KernelFn *function{};
+    simd_int lowBoundIndices{};
+    simd_int highBoundIndices{};
+    alignas(simd_float) byte state[kStateSize];
+  };
+
+  // runs all kernels one after another on every bin inside their (shared) bounds and copies the rest,
+  // kernels with stereo bounds are only supported one at a time
+  void runEffectKernels(utils::span<EffectKernel> kernels, const Framework::SimdBuffer *source,
+    Framework::SimdBuffer *destination, u32 binCount) noexcept;
+  // whether the next kernel can be fused with the previous ones
+  bool canFuseKernels(const EffectKernel &first, const EffectKernel &next, u32 binCount) noexcept;
+
   namespace Utility
   {
     inline constexpr uuid id = 1759541555994;
@@ -120,6 +147,9 @@ namespace Generation
       Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
       u32 binCount, float sampleRate) noexcept;
 
+    bool prepareKernelNormal(EffectModule *effectModule, EffectData *effectData,
+      Framework::ComplexDataSource &source, EffectKernel &kernel, u32 binCount, float sampleRate) noexcept;
+
     utils::span<Interface::Control *> createUINormal(utils::bumpArena *arena,
       Interface::EffectModuleSection *section, EffectData *effectData);
 
@@ -136,6 +166,9 @@ namespace Generation
     //
     //  delta - instead of the absolute loudness it uses the averaged loudness change from the 2 neighbouring bins
     //
+    //  mode - Decibels: threshold is a loudness level
+    //         Rank: threshold is the share of the quietest bins that get gated, the rest are the loudest ones in the channel
+    //
     COMPLEX_ENUM(Gate,
       (InputGain, 1758738170767),
       (     Gain, 1758738189871),
@@ -149,10 +182,22 @@ namespace Generation
       (    Rank, 1759681594091),
     );
 
+    struct GateData : EffectData
+    {
+      static constexpr u32 kRankBucketBits = 11;
+      static constexpr u32 kRankBucketCount = 1U << kRankBucketBits;
+
+      // Rank mode's per channel histograms, too large to live on the audio thread's stack
+      u32 rankHistograms[utils::kChannelsPerInOut][kRankBucketCount];
+    };
+
     void runGate(EffectModule *effectModule, EffectData *effectData,
       Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
       u32 binCount, float sampleRate) noexcept;
 
+    bool prepareKernelGate(EffectModule *effectModule, EffectData *effectData,
+      Framework::ComplexDataSource &source, EffectKernel &kernel, u32 binCount, float sampleRate) noexcept;
+
     utils::span<Interface::Control *> createUIGate(utils::bumpArena *arena,
       Interface::EffectModuleSection *section, EffectData *effectData);
 
@@ -378,6 +423,9 @@ namespace Generation
       Framework::ComplexDataSource &source, Framework::SimdBuffer *destination,
       u32 binCount, float sampleRate) noexcept;
 
+    bool prepareKernelReinterpret(EffectModule *effectModule, EffectData *effectData,
+      Framework::ComplexDataSource &source, EffectKernel &kernel, u32 binCount, float sampleRate) noexcept;
+
     utils::span<Interface::Control *> createUIReinterpret(utils::bumpArena *arena,
       Interface::EffectModuleSection *section, EffectData *effectData);
 
@@ -16,7 +16,7 @@ namespace Generation
 {
   static EffectData *
   createEffect(Framework::ProcessorMetadata *processorMetadata, EffectModule *module,
-    EffectData *copy = nullptr, void *jsonData = nullptr)
+    EffectData *copy = nullptr, void *serialisedSave = nullptr)
   {
     if (copy)
       processorMetadata = copy->metadata;
@@ -36,10 +36,10 @@ namespace Generation
       parameterCount = copy->parameterCount;
       effectParameters = module->createParameters(parameterCount, processorMetadata->parameters, copy->parameters);
     }
-    else if (jsonData)
+    else if (serialisedSave)
     {
       parameterCount = processorMetadata->parametersCount;
-      deserialiseParametersFromJson(jsonData, processorMetadata, effectParameters, module, false);
+      deserialiseParameters(serialisedSave, processorMetadata, effectParameters, module, false);
     }
     else
     {
@@ -83,7 +83,7 @@ namespace Generation
 
     if (serialisedSave)
     {
-      deserialiseFromJson(serialisedSave);
+      deserialise(serialisedSave);
       auto [effectOption, _] = getParameter(EffectModule::ModuleType)->getInternalValue<Framework::IndexedData>();
       effects = createEffect(effectOption->processorMetadata, this, nullptr, serialisedSave);
       changeEffect(effectOption);
@@ -95,7 +95,7 @@ namespace Generation
     }
   }
 
-  void EffectModule::serialiseToJson(void *jsonData, utils::span<Framework::ParameterValue *>) const
+  void EffectModule::serialiseToJson(void *jsonWriter, utils::span<Framework::ParameterValue *>) const
   {
     auto *effect = currentEffect.load(satomi::memory_order_acquire);
 
@@ -110,7 +110,29 @@ namespace Generation
     //for (usize i = 0; i < effect->parameterCount; (++i), (effectParameter = effectParameter->next))
     //  parametersToSerialise.emplaceBack(effectParameter);
 
-    Processor::serialiseToJson(jsonData, parametersToSerialise);
+    Processor::serialiseToJson(jsonWriter, parametersToSerialise);
+  }
+
+  void EffectModule::serialiseToBinary(void *writer, utils::span<Framework::ParameterValue *>) const
+  {
+    auto *effect = currentEffect.load(satomi::memory_order_acquire);
+
+    auto parametersToSerialise = utils::vector<Framework::ParameterValue *>{
+      getLocalScratch(), utils::max(effect->parameterCount, parameterCount) };
+
+    auto parameter = parameters;
+    for (usize i = 0; i < parameterCount; (++i), (parameter = parameter->next))
+      parametersToSerialise.emplaceBack(parameter);
+
+    Processor::serialiseToBinary(writer, parametersToSerialise);
+
+    // the current effect's parameters follow right after, createEffect reads them back during construction
+    parametersToSerialise.clear();
+    auto *effectParameter = effect->parameters;
+    for (usize i = 0; i < effect->parameterCount; (++i), (effectParameter = effectParameter->next))
+      parametersToSerialise.emplaceBack(effectParameter);
+
+    serialiseParametersToBinary(writer, parametersToSerialise);
   }
 
   EffectData *
@@ -176,6 +198,43 @@ namespace Generation
     return effect;
   }
 
+  // takes exclusive access to where the output of the module(s) goes
+  static Framework::SimdBuffer *
+  acquireDestination(Framework::ComplexDataSource &source, Framework::SimdBuffer *ownBuffer, bool isInPlace)
+  {
+    if (isInPlace)
+    {
+      COMPLEX_ASSERT(source.writableBuffer == source.sourceBuffer);
+
+      // upgrading to exclusive access only if we're the sole reader, if anything else is reading
+      // the buffer (another lane using it as its input) writing into it would corrupt what they see
+      i32 readers = 1;
+      if (source.writableBuffer->dataLock.lock.compare_exchange_strong(readers, -1, satomi::memory_order_acquire))
+        return source.writableBuffer;
+    }
+
+    // copy path, the effect reads from the source and writes into our own buffer
+    utils::lockAtomic(ownBuffer->dataLock, false, true, utils::WaitMechanism::Spin);
+    return ownBuffer;
+  }
+
+  static void releaseDestination(Framework::ComplexDataSource &source, Framework::SimdBuffer *destination)
+  {
+    // new data was written, cached powers are of the previous one
+    source.invalidatePowers();
+
+    // switching to being a reader and allowing other readers to participate
+    // seq_cst because the following atomic could be reordered to happen prior to this one
+    destination->dataLock.lock.store(1, satomi::memory_order_release);
+    if (destination == source.sourceBuffer)
+      return;
+
+    source.sourceBuffer->dataLock.lock.fetch_sub(1, satomi::memory_order_acq_rel);
+
+    source.sourceBuffer = destination;
+    source.writableBuffer = destination;
+  }
+
   void EffectModule::processEffect(Framework::ComplexDataSource &source, u32 binCount, float sampleRate) noexcept
   {
     using namespace Framework;
@@ -185,29 +244,51 @@ namespace Generation
       return;
 
     auto *effect = currentEffect.load(satomi::memory_order_acquire);
+    auto runEffect = (EffectData::RunEffectFn *)effect->metadata->vtable[EffectData::RunVtableIndex];
+    simd_float wetMix = getParameter(ModuleMix)->getInternalValue<simd_float>(sampleRate);
+    bool isFullyWet = simd_float::allEqual(wetMix, 1.0f);
 
-    // getting exclusive access to data
-    lockAtomic(dataBuffer->dataLock, false, true, WaitMechanism::Spin);
+    // the dry signal is lost when processing in place, so only fully wet modules can do it
+    bool isInPlace = source.writableBuffer && isFullyWet && (effect->metadata->flags & ProcessorMetadata::InPlaceTag);
+    auto *destination = acquireDestination(source, dataBuffer, isInPlace);
 
-    ((EffectData::RunEffectFn *)effect->metadata->vtable[EffectData::RunVtableIndex])(this, effect, source, dataBuffer, binCount, sampleRate);
+    runEffect(this, effect, source, destination, binCount, sampleRate);
 
     // if the mix is 100% for all channels, we can skip mixing entirely
-    simd_float wetMix = getParameter(ModuleMix)->getInternalValue<simd_float>(sampleRate);
-    if (!simd_float::allEqual(wetMix, 1.0f))
+    if (!isFullyWet)
     {
       auto sourceData = source.sourceBuffer->get();
-      auto destinationData = dataBuffer->get();
+      auto destinationData = destination->get();
       simd_float dryMix = 1.0f - wetMix;
       for (u32 i = 0; i < binCount; i++)
         destinationData[i] = simd_float::mulAdd(dryMix * sourceData[i], wetMix, destinationData[i]);
     }
 
-    // switching to being a reader and allowing other readers to participate
-    // seq_cst because the following atomic could be reordered to happen prior to this one
-    dataBuffer->dataLock.lock.store(1, satomi::memory_order_release);
-    source.sourceBuffer->dataLock.lock.fetch_sub(1, satomi::memory_order_acq_rel);
+    releaseDestination(source, destination);
+  }
 
-    source.sourceBuffer = dataBuffer;
+  bool EffectModule::prepareKernel(Framework::ComplexDataSource &source,
+    EffectKernel &kernel, u32 binCount, float sampleRate) noexcept
+  {
+    auto *effect = currentEffect.load(satomi::memory_order_acquire);
+    auto prepareKernelFn = (EffectData::PrepareKernelFn *)effect->metadata->vtable[EffectData::PrepareKernelVtableIndex];
+    if (!prepareKernelFn)
+      return false;
+
+    // mixing needs the module's own input, which doesn't exist as a whole while fused
+    if (!simd_float::allEqual(getParameter(ModuleMix)->getInternalValue<simd_float>(sampleRate), 1.0f))
+      return false;
+
+    return prepareKernelFn(this, effect, source, kernel, binCount, sampleRate);
+  }
+
+  void EffectModule::processKernels(utils::span<EffectKernel> kernels,
+    Framework::ComplexDataSource &source, u32 binCount) noexcept
+  {
+    // kernels only ever belong to in-place effects, when fusing they come from the preceding modules as well
+    auto *destination = acquireDestination(source, dataBuffer, source.writableBuffer);
+    runEffectKernels(kernels, source.sourceBuffer, destination, binCount);
+    releaseDestination(source, destination);
   }
 
   EffectsLane::EffectsLane(utils::bumpArena *arena, Plugin::State *state, Framework::ProcessorMetadata *metadata,
@@ -220,10 +301,11 @@ namespace Generation
     auto maxBinCount = state->getMaxBinCount();
 
     laneDataSource.scratchBuffer = Framework::SimdBuffer::create(arena, maxInOutChannels, maxBinCount);
+    laneDataSource.powerBuffer = Framework::SimdBuffer::create(arena, utils::kChannelsPerInOut, maxBinCount);
     dataBuffer = Framework::SimdBuffer::create(arena, maxInOutChannels, maxBinCount);
 
     if (serialisedSave)
-      deserialiseFromJson(serialisedSave);
+      deserialise(serialisedSave);
     else
     {
       parameters = createParameters(metadata->parametersCount, metadata->parameters);
@@ -246,12 +328,17 @@ namespace Generation
     {
       // if the input is not used we skip it
       if (!usedInputChannels_[i])
+      {
+        inputLoudness_[i / (u32)valueSources.size()] = 0.0f;
         continue;
+      }
 
       for (u32 k = 0; k < valueSources.size(); ++k)
         valueSources[k] = inputBuffer.get((u32)(i + k)).offset(0, 2 * binCount);
 
       auto data = interleavedInputBuffer->get(i / (u32)valueSources.size());
+      // sum of the powers of all bins, used by lanes that are gain matching
+      simd_float loudness = 0.0f;
 
       // skipping every n-th complex pair (currently simd_float can take 2 pairs)
       for (u32 j = 0; j < binCount - 1; j += (u32)values.size())
@@ -263,7 +350,10 @@ namespace Generation
         complexTranspose(values);
 
         for (u32 k = 0; k < values.size(); ++k)
+        {
           data[j + k] = values[k];
+          loudness += complexMagnitude(values[k], false);
+        }
       }
 
       simd_float::array_t nyquist{};
@@ -273,6 +363,9 @@ namespace Generation
         nyquist[2 * k + 1] = valueSources[k][(binCount - 1) * 2 + 1];
       }
       data[binCount - 1] = toSimdFloatFromUnaligned(nyquist.data());
+      loudness += complexMagnitude(data[binCount - 1], false);
+
+      inputLoudness_[i / (u32)valueSources.size()] = loudness;
     }
   }
 
@@ -335,10 +428,13 @@ namespace Generation
     using namespace utils;
 
     thisLane->currentEffectIndex.store(0, satomi::memory_order_release);
-    thisLane->volumeScale.store(1.0f, satomi::memory_order_relaxed);
+    thisLane->isGainMatching = false;
     auto &laneDataSource = thisLane->laneDataSource;
     laneDataSource.blockPhase = blockPhase;
     laneDataSource.blockPosition = blockPosition_;
+    // lane inputs are shared, the first module to run needs to copy
+    laneDataSource.writableBuffer = nullptr;
+    laneDataSource.invalidatePowers();
     bool isLaneOn = thisLane->getParameter(EffectsLane::LaneEnabled)->getInternalValue<u32>();
 
     // Lane Input
@@ -415,58 +511,67 @@ namespace Generation
       }
     }
 
-    simd_float inputVolume = 0.0f;
-    simd_float loudnessScale = 1.0f / (float)binCount;
-    u32 isGainMatching = thisLane->getParameter(EffectsLane::GainMatching)->getInternalValue<u32>();
-
-    auto getLoudness = [](const ComplexDataSource &laneDataSource, simd_float loudnessScale, u32 binCount)
+    // the output side of gain matching is measured and applied when the lanes are summed
+    thisLane->isGainMatching = thisLane->getParameter(EffectsLane::GainMatching)->getInternalValue<u32>();
+    if (thisLane->isGainMatching)
     {
-      simd_float loudness = 0.0f;
-      // this is because we're squaring and then scaling inside the loops
-      loudnessScale *= loudnessScale;
-      auto data = laneDataSource.sourceBuffer->get(laneDataSource.simdChannelOffset);
-      for (u32 i = 0; i < binCount - 1; i += 2)
+      // inputs were measured while interleaving them, other lanes' outputs weren't measured yet
+      if (laneDataSource.sourceBuffer == interleavedInputBuffer)
+        thisLane->inputLoudness = inputLoudness_[laneDataSource.simdChannelOffset];
+      else
       {
-        // magnitudes are: [left channel, right channel, left channel + 1, right channel + 1]
-        simd_float values = complexMagnitude({ data[i], data[i + 1] }, false);
-        // [left channel,     left channel + 1, right channel,     right channel + 1] +
-        // [left channel + 1, left channel,     right channel + 1, right channel    ]
-        loudness += groupEven(values) + groupEvenReverse(values);
+        // the first module usually needs the same powers of the input, so they're cached for it
+        auto powers = getSourcePowers(laneDataSource, binCount, laneDataSource.simdChannelOffset);
+        simd_float loudness = 0.0f;
+        for (u32 i = 0; i < binCount; ++i)
+          loudness += powers[i];
+        thisLane->inputLoudness = loudness;
       }
-
-      loudness += complexMagnitude(data[binCount - 1], false);
-      return loudness / loudnessScale;
-    };
-
-    if (isGainMatching)
-    {
-      inputVolume = getLoudness(laneDataSource, loudnessScale, binCount);
-      inputVolume = merge(inputVolume, simd_float(1.0f), simd_float::equal(inputVolume, 0.0f));
     }
-    else
-      thisLane->volumeScale.store(1.0f, satomi::memory_order_relaxed);
 
     // main processing loop
-    for (auto *child = thisLane->children; child; child = child->next)
+    for (auto *child = thisLane->children; child; )
     {
-      // this is safe because by design only EffectModules are contained in a lane
-      utils::as<EffectModule>(child)->processEffect(laneDataSource, binCount, sampleRate);
+      // gathering consecutive pointwise modules with matching bounds to process them in a single pass,
+      // disabled modules in between don't do anything and are skipped over
+      EffectKernel kernels[EffectsLane::kMaxFusedEffects];
+      u32 kernelCount = 0;
+      u32 moduleCount = 0;
+      u32 visitedCount = 0;
+      EffectModule *lastFused = nullptr;
+      for (auto *current = child; current && kernelCount < countof(kernels); current = current->next)
+      {
+        ++visitedCount;
 
-      // incrementing where we are currently
-      thisLane->currentEffectIndex.fetch_add(1, satomi::memory_order_acq_rel);
-    }
+        // this is safe because by design only EffectModules are contained in a lane
+        auto *module = utils::as<EffectModule>(current);
+        if (!module->getParameter(EffectModule::ModuleEnabled)->getInternalValue<u32>(sampleRate))
+          continue;
 
-    if (isGainMatching)
-    {
-      simd_float outputVolume = getLoudness(laneDataSource, loudnessScale, binCount);
-      outputVolume = merge(outputVolume, simd_float(1.0f), simd_float::equal(outputVolume, 0.0f));
-      simd_float scale = inputVolume / outputVolume;
+        if (!module->prepareKernel(laneDataSource, kernels[kernelCount], binCount, sampleRate))
+          break;
+        if (kernelCount && !canFuseKernels(kernels[0], kernels[kernelCount], binCount))
+          break;
 
-      // some arbitrary limits taken from dtblkfx
-      scale = merge(scale, simd_float{ 1.0f }, simd_float::greaterThan(scale, 1.0e30f));
-      scale = merge(scale, simd_float{ 0.0f }, simd_float::lessThan(scale, 1.0e-30f));
+        ++kernelCount;
+        lastFused = module;
+        moduleCount = visitedCount;
+      }
+
+      if (lastFused)
+      {
+        lastFused->processKernels({ kernels, kernelCount }, laneDataSource, binCount);
+        child = lastFused->next;
+      }
+      else
+      {
+        utils::as<EffectModule>(child)->processEffect(laneDataSource, binCount, sampleRate);
+        child = child->next;
+        moduleCount = 1;
+      }
 
-      thisLane->volumeScale.store(simd_float::sqrt(scale), satomi::memory_order_relaxed);
+      // incrementing where we are currently
+      thisLane->currentEffectIndex.fetch_add(moduleCount, satomi::memory_order_acq_rel);
     }
 
     // unlocking the final output of the lane until we need it again (be it a module or the input itself if the lane is empty)
@@ -478,6 +583,22 @@ namespace Generation
     thisLane->status.store(EffectsLane::LaneStatus::Finished, satomi::memory_order_release);
   }
 
+  // gain matching scale from the summed powers before and after a lane's chain
+  static simd_float getGainMatchScale(simd_float inputLoudness, simd_float outputLoudness)
+  {
+    using namespace utils;
+
+    inputLoudness = merge(inputLoudness, simd_float{ 1.0f }, simd_float::equal(inputLoudness, 0.0f));
+    outputLoudness = merge(outputLoudness, simd_float{ 1.0f }, simd_float::equal(outputLoudness, 0.0f));
+    simd_float scale = inputLoudness / outputLoudness;
+
+    // some arbitrary limits taken from dtblkfx
+    scale = merge(scale, simd_float{ 1.0f }, simd_float::greaterThan(scale, 1.0e30f));
+    scale = merge(scale, simd_float{ 0.0f }, simd_float::lessThan(scale, 1.0e-30f));
+
+    return simd_float::sqrt(scale);
+  }
+
   void SoundEngine::sumLanesAndDeinterleaveOutputs(Framework::Buffer &out)
   {
     using namespace Framework;
@@ -490,6 +611,8 @@ namespace Generation
 
     // multipliers for scaling the multiple chains going into the same output
     ::zeroset(outputScaleMultipliers_.data(), outputScaleMultipliers_.size());
+    for (auto &scale : outputGainScales_)
+      scale = 1.0f;
 
     for (auto *lane = getChild(children, 0, Processors::EffectsLane); lane;
       lane = getChild(lane, 1, Processors::EffectsLane))
@@ -513,9 +636,43 @@ namespace Generation
       ScopedLock g1{ lane->laneDataSource.sourceBuffer->dataLock, false, WaitMechanism::Spin };
 
       simd_float multiplier = simd_float::max(1.0f, outputScaleMultipliers_[index]);
+      if (!lane->isGainMatching)
+      {
+        lane->volumeScale.store(1.0f, satomi::memory_order_relaxed);
+        Framework::applyToThisNoMask<MathOperations::Add>(interleavedOutputBuffer,
+          lane->laneDataSource.sourceBuffer, kChannelsPerInOut, binCount, (u32)index * kChannelsPerInOut, 0, 0, 0,
+          1.0f / multiplier);
+        continue;
+      }
+
+      auto laneData = lane->laneDataSource.sourceBuffer->get();
+      simd_float outputLoudness = 0.0f;
+
+      // the lane is alone on this output, so it's measured while being added
+      // and the scale is applied when deinterleaving
+      if (outputScaleMultipliers_[index] <= 1.0f)
+      {
+        auto outputData = interleavedOutputBuffer->get((u32)index);
+        for (u32 j = 0; j < binCount; ++j)
+        {
+          outputLoudness += complexMagnitude(laneData[j], false);
+          outputData[j] += laneData[j];
+        }
+
+        outputGainScales_[index] = getGainMatchScale(lane->inputLoudness, outputLoudness);
+        lane->volumeScale.store(outputGainScales_[index], satomi::memory_order_relaxed);
+        continue;
+      }
+
+      // other lanes go into the same output, the scale needs to be known before adding
+      for (u32 j = 0; j < binCount; ++j)
+        outputLoudness += complexMagnitude(laneData[j], false);
+
+      simd_float scale = getGainMatchScale(lane->inputLoudness, outputLoudness);
+      lane->volumeScale.store(scale, satomi::memory_order_relaxed);
       Framework::applyToThisNoMask<MathOperations::Add>(interleavedOutputBuffer,
         lane->laneDataSource.sourceBuffer, kChannelsPerInOut, binCount, (u32)index * kChannelsPerInOut, 0, 0, 0,
-        lane->volumeScale.load(satomi::memory_order_relaxed) / multiplier);
+        scale / multiplier);
     }
 
     auto values = utils::array<simd_float, SimdBuffer::kRelativeSize>{};
@@ -527,6 +684,7 @@ namespace Generation
         continue;
 
       auto data = interleavedOutputBuffer->get(i / (u32)valueDestinations.size());
+      simd_float gainScale = outputGainScales_[i / (u32)valueDestinations.size()];
 
       for (u32 k = 0; k < valueDestinations.size(); ++k)
         valueDestinations[k] = out.get((u32)(i + k)).offset(0, 2 * binCount);
@@ -535,7 +693,7 @@ namespace Generation
       for (u32 j = 0; j < binCount - 1; j += (u32)values.size())
       {
         for (u32 k = 0; k < values.size(); ++k)
-          values[k] = data[j + k];
+          values[k] = data[j + k] * gainScale;
 
         complexTranspose(values);
 
@@ -544,7 +702,7 @@ namespace Generation
           ::memcpy(&valueDestinations[k][j * 2], &values[k], sizeof(simd_float));
       }
 
-      auto rest = data[binCount - 1].getArrayOfValues();
+      auto rest = (data[binCount - 1] * gainScale).getArrayOfValues();
       for (u32 k = 0; k < valueDestinations.size(); ++k)
       {
         valueDestinations[k][(binCount - 1) * 2] = rest[2 * k];
@@ -557,7 +715,8 @@ namespace Generation
 template<> Generation::Processor *
 createProcessor<Generation::EffectModule>(Plugin::State *state, Framework::ProcessorMetadata *metadata, const void *copy, void *serialisedSave)
 {
-  auto *arena = utils::bumpArena::createNested(state->processorStorage, COMPLEX_MB(1));
+  auto *arena = utils::bumpArena::createNested(state->processorStorage,
+    COMPLEX_MB(1), Generation::kProcessorArenaPageFlags);
   return anew(state->processorStorage, Generation::EffectModule,
     { arena, state, metadata, (const Generation::EffectModule *)copy, serialisedSave });
 }
@@ -603,7 +762,8 @@ initialiseTypeStructure<Generation::EffectModule>(void *, Framework::PluginStruc
 template<> Generation::Processor *
 createProcessor<Generation::EffectsLane>(Plugin::State *state, Framework::ProcessorMetadata *metadata, const void *toCopy, void *serialisedSave)
 {
-  auto *arena = utils::bumpArena::createNested(state->processorStorage, COMPLEX_MB(1));
+  auto *arena = utils::bumpArena::createNested(state->processorStorage,
+    COMPLEX_MB(1), Generation::kProcessorArenaPageFlags);
   return anew(state->processorStorage, Generation::EffectsLane, { arena, state, metadata,
     (const Generation::EffectsLane *)toCopy, serialisedSave });
 }
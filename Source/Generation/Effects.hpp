@@ -51,9 +51,14 @@ namespace Generation
     Interface::Component *createUI() override;
 
     void processEffect(Framework::ComplexDataSource &source, u32 binCount, float sampleRate) noexcept;
+    // fills the effect's per-bin kernel, returns false if it can't be fused with the current parameters
+    bool prepareKernel(Framework::ComplexDataSource &source, EffectKernel &kernel, u32 binCount, float sampleRate) noexcept;
+    // runs kernels of this and preceding modules in a single pass, output ends up in this module's buffer
+    void processKernels(utils::span<EffectKernel> kernels, Framework::ComplexDataSource &source, u32 binCount) noexcept;
 
     // this method exists only to accomodate loading from save files
-    void serialiseToJson(void *jsonData, utils::span<Framework::ParameterValue *> parametersToSerialise = {}) const override;
+    void serialiseToJson(void *jsonWriter, utils::span<Framework::ParameterValue *> parametersToSerialise = {}) const override;
+    void serialiseToBinary(void *writer, utils::span<Framework::ParameterValue *> parametersToSerialise = {}) const override;
 
     EffectData *changeEffect(const Framework::IndexedData *effectOption);
 
@@ -90,6 +95,9 @@ namespace Generation
     // Stopped - temporarily stopped to wait for data from another lane
     enum class LaneStatus : u32 { Finished, Ready, Running, Stopped };
 
+    // upper limit of modules whose kernels are run in a single pass
+    static constexpr u32 kMaxFusedEffects = 8;
+
     EffectsLane(utils::bumpArena *arena, Plugin::State *state,
       Framework::ProcessorMetadata *metadata, const EffectsLane *other, void *serialisedSave);
 
@@ -107,6 +115,10 @@ namespace Generation
 
     satomi::atomic<LaneStatus> status = LaneStatus::Finished;
     satomi::atomic<simd_float> volumeScale{};
+    // gain matching state of the current block, written while the lane is processed
+    // and read after it's finished when summing up the lanes
+    simd_float inputLoudness{};
+    bool isGainMatching = false;
 
     friend class SoundEngine;
   };
@@ -32,6 +32,14 @@ namespace Generation
     (EffectModule, 1758070362397),
   )
 
+  // page treatment for processor arenas, whose buffers get touched on the audio thread
+  // define COMPLEX_LOCK_AUDIO_PAGES to also pin them in physical memory
+  inline constexpr u8 kProcessorArenaPageFlags = utils::bumpArena::PrefaultPages
+  #ifdef COMPLEX_LOCK_AUDIO_PAGES
+    | utils::bumpArena::LockPages
+  #endif
+    ;
+
   class Processor
   {
   public:
@@ -47,8 +55,12 @@ namespace Generation
     virtual Interface::Component *createUI() = 0;
     virtual void reset();
 
-    virtual void serialiseToJson(void *jsonData, utils::span<Framework::ParameterValue *> parametersToSerialise = {}) const;
+    virtual void serialiseToJson(void *jsonWriter, utils::span<Framework::ParameterValue *> parametersToSerialise = {}) const;
     void deserialiseFromJson(void *jsonData);
+    virtual void serialiseToBinary(void *writer, utils::span<Framework::ParameterValue *> parametersToSerialise = {}) const;
+    void deserialiseFromBinary(void *reader);
+    // picks json or binary deserialisation depending on the kind of save that's being loaded
+    void deserialise(void *serialisedSave);
     Processor *createCopy() const { return metadata->create(state, metadata, this, nullptr); }
 
     // the following functions are to be called outside of processing time
@@ -141,6 +153,11 @@ namespace Generation
 
   void deserialiseParametersFromJson(void *jsonData, Framework::ProcessorMetadata *metadata,
     Framework::ParameterValue *&parameters, Processor *processor, bool validateParameters);
+  void serialiseParametersToBinary(void *writer, utils::span<Framework::ParameterValue *> parameters);
+  void deserialiseParametersFromBinary(void *reader, Framework::ProcessorMetadata *metadata,
+    Framework::ParameterValue *&parameters, Processor *processor, bool validateParameters);
+  void deserialiseParameters(void *serialisedSave, Framework::ProcessorMetadata *metadata,
+    Framework::ParameterValue *&parameters, Processor *processor, bool validateParameters);
 }
 
 namespace Framework
@@ -62,9 +62,9 @@ namespace Generation
     if (copiedData)
     {
       // recalculating indices based on the new size
+      u32 beginOutputToAddOverlap = getBeginOutputToAddOverlap();
       addOverlap_ = utils::clamp((newSize - getAddOverlapToEnd()) % newSize, 0U, newSize - 1);
-      toScaleOutput_ = utils::clamp((addOverlap_ - getToScaleOutputToAddOverlap()) % newSize, 0U, newSize - 1);
-      beginOutput_ = utils::clamp((toScaleOutput_ - getBeginOutputToToScaleOutput()) % newSize, 0U, newSize - 1);
+      beginOutput_ = utils::clamp((addOverlap_ - beginOutputToAddOverlap) % newSize, 0U, newSize - 1);
     }
   }
 }
@@ -72,7 +72,8 @@ namespace Generation
 template<> Generation::Processor *
 createProcessor<Generation::SoundEngine>(Plugin::State *state, Framework::ProcessorMetadata *metadata, const void *, void *serialisedSave)
 {
-  auto *arena = utils::bumpArena::createNested(state->processorStorage, COMPLEX_MB(4));
+  auto *arena = utils::bumpArena::createNested(state->processorStorage,
+    COMPLEX_MB(4), Generation::kProcessorArenaPageFlags);
   return anew(arena, Generation::SoundEngine, { arena, state, metadata, serialisedSave });
 }
 
@@ -84,7 +85,7 @@ namespace Generation
     using namespace Framework;
 
     if (serialisedSave)
-      deserialiseFromJson(serialisedSave);
+      deserialise(serialisedSave);
     else
     {
       parameters = createParameters(metadata->parametersCount, metadata->parameters);
@@ -94,6 +95,16 @@ namespace Generation
     inBuffer.arena = arena;
     outBuffer.arena = arena;
     resizeBuffers(state->plugin->inSidechains, state->plugin->outSidechains);
+
+    // window tables are built on a worker so that changing window parameters doesn't cost anything on the audio thread
+    // the worker sleeps until a table is requested and is woken up to exit when the state is destroyed
+    windows.reserveTables(arena, (u32)getParameter(Parameters::BlockSize)->getParameterDetails().maxValue);
+    state->reserveFreeWorker(typeId(Window)).start([this](satomi::atomic<bool> &shouldStop)
+      {
+        while (windows.waitForRequest(shouldStop))
+          if (!windows.buildRequestedTable())
+            utils::millisleep();
+      }, [this]() { windows.wakeBuilder(); });
   }
 
   void SoundEngine::resizeBuffers(u32 maxSidechainInputs, u32 maxSidechainOutputs)
@@ -119,13 +130,29 @@ namespace Generation
     usedInputChannels_ = { arranew(arena, bool, maxInChannels, {}), maxInChannels };
     usedOutputChannels_ = { arranew(arena, bool, maxOutChannels, {}), maxOutChannels };
     outputScaleMultipliers_ = { arranew(arena, float, maxOutChannels, {}), maxOutChannels };
+    u32 maxSimdInChannels = Framework::SimdBuffer::getSimdChannels(maxInChannels);
+    u32 maxSimdOutChannels = Framework::SimdBuffer::getSimdChannels(maxOutChannels);
+    inputLoudness_ = { arranew(arena, simd_float, maxSimdInChannels, {}), maxSimdInChannels };
+    outputGainScales_ = { arranew(arena, simd_float, maxSimdOutChannels, {}), maxSimdOutChannels };
 
     auto maxBinCount = (1 << (maxOrder - 1)) + 1;
     interleavedInputBuffer = Framework::SimdBuffer::create(arena, maxInChannels, maxBinCount);
     interleavedOutputBuffer = Framework::SimdBuffer::create(arena, maxOutChannels, maxBinCount);
   }
 
-  u32 SoundEngine::getProcessingDelay() const { return FFTSamples_ + state->plugin->getSamplesPerBlock(); }
+  u32
+  SoundEngine::getProcessingDelay() const
+  {
+    if (state->plugin->isLowLatency.load(satomi::memory_order_relaxed))
+      return FFTSamples_;
+
+    // output only starts in the callback that finishes the first block after a reset,
+    // so the delay is the first block rounded up to whole callbacks and the 2 callbacks of offset,
+    // which changes with the FFT size afterwards (see FFTChangeOffset)
+    u32 samplesPerBlock = state->plugin->getSamplesPerBlock();
+    u32 startupStall = utils::roundUpToMultiple(FFTSamplesAtReset_, samplesPerBlock) - FFTSamplesAtReset_;
+    return FFTSamples_ + samplesPerBlock + startupStall;
+  }
   u32 SoundEngine::getFFTSize() const { return 1 << getParameter(Parameters::BlockSize)->getInternalValue<u32>(); }
   u32
   SoundEngine::getMaxBinCount() const
@@ -149,6 +176,8 @@ namespace Generation
     FFTSamplesAtReset_ = FFTSamples_;
     nextOverlapOffset_ = 0;
     blockPosition_ = 0;
+    processedSamples_ = 0;
+    isPrimed_ = false;
     inBuffer.reset();
     outBuffer.reset();
   }
@@ -214,17 +243,15 @@ namespace Generation
   void SoundEngine::isReadyToPerform(u32 samples)
   {
     isPerforming_ = false;
-    hasEnoughSamples_ = false;
 
-    // if there are scaled and/or processed samples
-    // that haven't already been output we don't need to perform
-    u32 samplesReady = outBuffer.getBeginOutputToToScaleOutput() +
-      outBuffer.getToScaleOutputToAddOverlap();
-    if (samplesReady >= samples)
-    {
-      hasEnoughSamples_ = true;
+    // if there are processed samples that haven't already been output we don't need to perform
+    //
+    // offline there's no deadline, so we keep performing every block whose input has already arrived
+    // for as long as the next one fits in the output buffer without reaching samples that weren't output yet
+    u32 samplesReady = outBuffer.getBeginOutputToAddOverlap();
+    hasEnoughSamples_ = samplesReady >= samples;
+    if (hasEnoughSamples_ && (!isRenderingOffline_ || samplesReady + (1U << FFTOrder_) >= outBuffer.size))
       return;
-    }
 
     // are there enough samples ready to be processed?
     u32 availableSamples = inBuffer.newSamplesToRead(InputBuffer::BlockBegin, nextOverlapOffset_);
@@ -271,6 +298,8 @@ namespace Generation
 
       break;
     case UpdateFlag::BeforeProcess:
+      previousMix_ = mix_;
+      previousOutGain_ = outGain_;
       mix_ = getParameter(Mix)->getInternalValue<float>(currentSampleRate);
       FFTOrder_ = getParameter(BlockSize)->getInternalValue<u32>(currentSampleRate);
       outGain_ = (float)utils::dbToAmplitude(getParameter(OutGain)->getInternalValue<float>(currentSampleRate));
@@ -280,6 +309,8 @@ namespace Generation
         isInitialised_ = true;
         FFTSamples_ = 1 << FFTOrder_;
         FFTSamplesAtReset_ = FFTSamples_;
+        previousMix_ = mix_;
+        previousOutGain_ = outGain_;
       }
 
       break;
@@ -291,7 +322,8 @@ namespace Generation
   void SoundEngine::doFFT(Framework::FFT &ffts)
   {
     // windowing
-    windows.applyWindow(FFTBuffer_, FFTBuffer_.channels, usedInputChannels_, FFTSamples_, windowTypeId_, alpha_);
+    windows.applyWindow(FFTBuffer_, FFTBuffer_.channels, usedInputChannels_,
+      FFTSamples_, windowTypeId_, alpha_, nextOverlapOffset_, isRenderingOffline_);
 
     // in-place FFT
     // FFT-ed only if the input is used
@@ -304,15 +336,22 @@ namespace Generation
   {
     using namespace Framework;
 
-    // in-place IFFT
+    // in-place IFFT, unnormalised
     for (u32 i = 0; i < FFTBuffer_.channels; i++)
       if (usedOutputChannels_[i])
         ffts.transformRealInverse(FFTOrder_, FFTBuffer_.get(i), i);
 
+    // the inverse transform's 1/N, the overlapping windows' normalisation and the output gain
+    // are all applied in a single pass before overlap-adding
+    windows.applyOverlapNormalisation(FFTBuffer_, FFTBuffer_.channels,
+      usedOutputChannels_, FFTSamples_, outGain_ / (float)FFTSamples_);
+
     // if the FFT size is big enough to guarantee that even with max overlap
     // a block >= samplesPerBlock can be finished, we don't offset
     // otherwise, we offset 2 block sizes back
-    outBuffer.setLatencyOffset(2 * (i32)state->plugin->getSamplesPerBlock());
+    // (low latency mode sets its offset at the start of process)
+    if (!isLowLatency_)
+      outBuffer.setLatencyOffset(2 * (i32)state->plugin->getSamplesPerBlock());
 
     // overlap-adding
     {
@@ -347,34 +386,52 @@ namespace Generation
     if (!hasEnoughSamples_)
       return;
 
-    u32 start = outBuffer.toScaleOutput_;
-    u32 toScaleSamples = outBuffer.getToScaleOutputToAddOverlap();
-    outBuffer.advanceToScaleOutput(toScaleSamples);
-
     i32 FFTChangeOffset = (i32)FFTSamplesAtReset_ - (i32)FFTSamples_;
     i32 latencyOffset = FFTChangeOffset - outBuffer.latencyOffset_;
 
+    // the host block is split at every automation event, so when values change
+    // they are ramped over the part of the block between the previous event and this one
+    bool isMixRamping = previousMix_ != mix_;
+    bool isGainRamping = previousOutGain_ != outGain_;
+    float gainIncrement = (outGain_ - previousOutGain_) / (float)samples;
+    float mixIncrement = (mix_ - previousMix_) / (float)samples;
+
     // only dry
-    if (mix_ == 0.0f)
+    if (mix_ == 0.0f && !isMixRamping)
     {
       u32 inStart = inBuffer.getIndex(InputBuffer::LastOutputBlock, latencyOffset);
       inBuffer.readAt(outBuffer, outBuffer.channels, samples, inStart,
         outBuffer.beginOutput_, usedOutputChannels_);
 
+      // wet output already has the gain applied during overlap-add
+      if (outGain_ != 1.0f || isGainRamping)
+      {
+        for (u32 i = 0; i < outBuffer.channels; i++)
+        {
+          if (!usedOutputChannels_[i])
+            continue;
+
+          auto out = outBuffer.get(i);
+          if (!isGainRamping)
+          {
+            for (u32 j = 0; j < samples; j++)
+              out[(outBuffer.beginOutput_ + j) % outBuffer.size] *= outGain_;
+            continue;
+          }
+
+          for (u32 j = 0; j < samples; j++)
+            out[(outBuffer.beginOutput_ + j) % outBuffer.size] *= previousOutGain_ + gainIncrement * (float)(j + 1);
+        }
+      }
+
       // advancing buffer indices
       inBuffer.advanceLastOutputBlock(samples);
 
       return;
     }
 
-    // when the overlap is more than what the window requires
-    // there will be an increase in gain, so we need to offset that
-    windows.scaleDown(outBuffer, outBuffer.channels,
-      usedOutputChannels_, start, toScaleSamples, windowTypeId_,
-      currentOverlap_.load(satomi::memory_order_relaxed), alpha_);
-
     // only wet
-    if (mix_ == 1.0f)
+    if (mix_ == 1.0f && !isMixRamping)
     {
       inBuffer.advanceLastOutputBlock(samples);
       return;
@@ -391,12 +448,25 @@ namespace Generation
       auto in = inBuffer.get(i);
       auto out = outBuffer.get(i);
 
-      // TODO: optimise this with simd
+      if (!isMixRamping && !isGainRamping)
+      {
+        // TODO: optimise this with simd
+        for (u32 j = 0; j < samples; j++)
+        {
+          u32 outIndex = (outBuffer.beginOutput_ + j) % outBuffer.size;
+          u32 inIndex = (beginInput + j) % inBuffer.size;
+          out[outIndex] = utils::lerp(in[inIndex] * outGain_, out[outIndex], mix_);
+        }
+        continue;
+      }
+
       for (u32 j = 0; j < samples; j++)
       {
         u32 outIndex = (outBuffer.beginOutput_ + j) % outBuffer.size;
         u32 inIndex = (beginInput + j) % inBuffer.size;
-        out[outIndex] = utils::lerp(in[inIndex], out[outIndex], mix_);
+        float gain = previousOutGain_ + gainIncrement * (float)(j + 1);
+        float mix = previousMix_ + mixIncrement * (float)(j + 1);
+        out[outIndex] = utils::lerp(in[inIndex] * gain, out[outIndex], mix);
       }
     }
     inBuffer.advanceLastOutputBlock(samples);
@@ -415,19 +485,10 @@ namespace Generation
 
     COMPLEX_ASSERT(outputs <= outBuffer.channels);
     outBuffer.readAt(buffer, outputs, samples, outBuffer.beginOutput_, usedOutputChannels_);
-    // zero out non-copied channels and scaling
+    // zero out non-copied channels
     for (u32 i = 0; i < outputs; i++)
-    {
       if (!usedOutputChannels_[i])
-      {
         ::zeroset(buffer[i], samples);
-        continue;
-      }
-
-      if (outGain_ != 1.0f)
-        for (u32 j = 0; j < samples; ++j)
-          buffer[i][j] *= outGain_;
-    }
 
     outBuffer.advanceBeginOutput(samples);
   }
@@ -437,6 +498,23 @@ namespace Generation
   {
     COMPLEX_ASSERT(FFTSamples_ != 0, "Number of fft samples has not been set in advance");
 
+    isRenderingOffline_ = state->plugin->isRenderingOffline.load(satomi::memory_order_relaxed);
+    isLowLatency_ = state->plugin->isLowLatency.load(satomi::memory_order_relaxed);
+
+    // in low latency mode output is read exactly FFTSamples_ behind the input:
+    // a callback's input is always written before any block is performed, so every block
+    // whose last sample arrived in this callback is overlap-added by the time its output is read
+    //
+    // the offset is set before the first block is performed so that silence is output (and time advances)
+    // while the first block is still filling up, otherwise that wait would be added to the delay;
+    // it's the FFT size at reset because later size changes are compensated by FFTChangeOffset
+    if (isLowLatency_)
+      outBuffer.setLatencyOffset((i32)FFTSamplesAtReset_);
+
+    ffts.beginProcessing();
+    // plans for a new order might still be under construction, in which case we continue with the previous one
+    FFTOrder_ = ffts.getAvailableOrder(FFTOrder_);
+
     // copying input in the main circular buffer
     copyBuffers(in, numInputs, samples);
 
@@ -461,10 +539,15 @@ namespace Generation
       doIFFT(ffts);
     }
 
+    ffts.endProcessing();
+
     // copying and scaling the dry signal to the output
     mixOut(samples);
     // copying output to buffer
     fillOutput(out, numOutputs, samples);
+
+    isPrimed_ = hasEnoughSamples_ && processedSamples_ >= (u64)getProcessingDelay() + FFTSamples_;
+    processedSamples_ += samples;
   }
 }
 
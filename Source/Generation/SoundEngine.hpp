@@ -118,8 +118,6 @@ namespace Generation
       i32 latencyOffset_ = 0;
       // index of the first new sample that can be output
       u32 beginOutput_ = 0;
-      // index of the first add-overlapped sample that hasn't been scaled
-      u32 toScaleOutput_ = 0;
       // index of the first sample of the last add-overlapped block
       u32 addOverlap_ = 0;
 
@@ -129,8 +127,9 @@ namespace Generation
 
       void reset()
       {
+        // so that the next setLatencyOffset positions beginOutput_ again
+        latencyOffset_ = 0;
         beginOutput_ = 0;
-        toScaleOutput_ = 0;
         addOverlap_ = 0;
         end = 0;
       }
@@ -143,7 +142,6 @@ namespace Generation
           return;
 
         beginOutput_ = (u32)((i32)size - newLatencyOffset) % size;
-        toScaleOutput_ = 0;
         addOverlap_ = 0;
         end = 0;
 
@@ -153,11 +151,9 @@ namespace Generation
       }
 
       forceinline void advanceBeginOutput(u32 samples) { beginOutput_ = (beginOutput_ + samples) % size; }
-      forceinline void advanceToScaleOutput(u32 samples) { toScaleOutput_ = (toScaleOutput_ + samples) % size; }
       forceinline void advanceAddOverlap(u32 samples) { addOverlap_ = (addOverlap_ + samples) % size; }
 
-      forceinline u32 getBeginOutputToToScaleOutput() const { return (size + toScaleOutput_ - beginOutput_) % size; }
-      forceinline u32 getToScaleOutputToAddOverlap() const { return (size + addOverlap_ - toScaleOutput_) % size; }
+      forceinline u32 getBeginOutputToAddOverlap() const { return (size + addOverlap_ - beginOutput_) % size; }
       forceinline u32 getAddOverlapToEnd() const { return (size + end - addOverlap_) % size; }
     } outBuffer{};
     //
@@ -192,6 +188,9 @@ namespace Generation
       u32 numInputs, u32 numOutputs, Framework::FFT &ffts);
 
     u32 getProcessingDelay() const;
+    // whether all of the last process call's output came from input this engine has seen,
+    // until then its beginning is missing the frames from before the engine started (or was reset)
+    bool isPrimed() const { return isPrimed_; }
     float getOverlap() const { return currentOverlap_.load(satomi::memory_order_relaxed); }
     u32 getFFTSize() const;
     u32 getMaxBinCount() const;
@@ -214,6 +213,8 @@ namespace Generation
     //
     // mix amount with dry signal
     float mix_ = 1.0f;
+    // mix at the end of the previous process call, the dry/wet mix ramps from it
+    float previousMix_ = 1.0f;
     //
     // FFT order
     u32 FFTOrder_ = 0;
@@ -230,6 +231,8 @@ namespace Generation
     //
     // output gain
     float outGain_ = 1.0f;
+    // same as previousMix_ but for the gain of the dry signal
+    float previousOutGain_ = 1.0f;
     //
     // have we performed for this last run?
     bool isPerforming_ = false;
@@ -237,6 +240,15 @@ namespace Generation
     // do we have enough processed samples to output?
     bool hasEnoughSamples_ = false;
     //
+    // samples processed since the last reset, the output lags the input by the processing delay
+    // and the first FFT size of samples after that only has some of the frames overlapping it
+    u64 processedSamples_ = 0;
+    bool isPrimed_ = false;
+    //
+    // plugin's offline and low latency switches, sampled once per process call
+    bool isRenderingOffline_ = false;
+    bool isLowLatency_ = false;
+    //
     // current FFT plan in samples
     u32 FFTSamples_ = 0;
     u32 FFTSamplesAtReset_ = 0;
@@ -259,6 +271,10 @@ namespace Generation
 
     // if an input/output isn't used there's no need to process it at all
     utils::span<float> outputScaleMultipliers_{};
+    // summed powers of every interleaved input, gathered while interleaving for lanes that are gain matching
+    utils::span<simd_float> inputLoudness_{};
+    // gain matching scales of outputs with a single lane, applied while deinterleaving
+    utils::span<simd_float> outputGainScales_{};
 
     Framework::SimdBuffer *interleavedInputBuffer{};
     Framework::SimdBuffer *interleavedOutputBuffer{};
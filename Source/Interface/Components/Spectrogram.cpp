@@ -388,7 +388,9 @@ namespace Interface
     float startDecade = ::log10f(minFrequency / sampleHz);
     float decadeCount = ::log10f(maxFrequency / minFrequency);
 
-    if (!updateAmplitudes(startDecade, decadeCount, decadeSlope))
+    // bounces don't wait on the spectrogram copying out of the output buffer, the last frame is kept instead
+    if (!plugin.isRenderingOffline.load(satomi::memory_order_relaxed) &&
+      !updateAmplitudes(startDecade, decadeCount, decadeSlope))
       return true;
 
     drawSpectrum(g, this);
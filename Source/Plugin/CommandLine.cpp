@@ -0,0 +1,595 @@
+
+// Created: 2026-10-18 14:10:37
+
+// complex-render, runs wav files through the engine offline
+// built with COMPLEX_RENDER_CLI (`build.sh render`), no plugin format is compiled in that case
+//
+//   complex-render [--preset <file>] [--output-dir <dir>] [--sidechain <file>]...
+//     [--jobs <count>] [--block-size <samples>] <input.wav>...
+//   complex-render [--preset <file>] --export-json <file>
+//   complex-render --test [name]...
+//   complex-render --benchmark [name]...
+//
+// every input gets a freshly loaded preset, so outputs don't depend on the order or the number of jobs
+// outputs are stereo 32-bit float wavs that are as long as the input and aligned with it (latency is removed)
+// process() runs under the audio thread guard, anything realtime-unsafe it catches fails the run
+
+#include <stdio.h>
+
+#include "Complex.hpp"
+
+#include "Third Party/cplug/cplug.h"
+
+#if !COMPLEX_AUDIO_THREAD_GUARD
+  #error "complex-render needs COMPLEX_AUDIO_THREAD_GUARD to check that processing is realtime-safe"
+#endif
+
+namespace
+{
+  constexpr u32 kDefaultBlockSize = 8192;
+  // the output buffer has to fit 2 blocks of latency margin and a block that's being output
+  constexpr u32 kMaxBlockSize = 1U << (kMaxFFTOrder - 1);
+  constexpr u32 kParameterMappings = 64;
+
+  constexpr u16 kWavePcm = 1;
+  constexpr u16 kWaveFloat = 3;
+  constexpr u16 kWaveExtensible = 0xFFFE;
+
+  bool hasTag(const byte *data, utils::string_view tag)
+  { return utils::string_view{ (const char *)data, tag.size() } == tag; }
+
+  template<typename T>
+  T readLittleEndian(const byte *data)
+  {
+    T value;
+    ::memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  struct WavFile
+  {
+    const byte *memory{};
+    usize mappedSize{};
+    const byte *samples{};
+    u64 frames{};
+    u32 sampleRate{};
+    u32 channels{};
+    u32 bytesPerSample{};
+    u16 format{};
+
+    // returns an error message on failure
+    const char *open(const char *path)
+    {
+      memory = utils::mapFile(path, mappedSize);
+      if (!memory)
+        return "couldn't open file";
+
+      if (mappedSize < 12 || !hasTag(memory, "RIFF") || !hasTag(memory + 8, "WAVE"))
+        return "not a wav file";
+
+      u64 dataSize = 0;
+      u32 blockAlign = 0;
+      for (usize position = 12; position + 8 <= mappedSize; )
+      {
+        const byte *chunk = memory + position;
+        usize chunkSize = readLittleEndian<u32>(chunk + 4);
+        usize bodySize = utils::min(chunkSize, mappedSize - position - 8);
+
+        if (hasTag(chunk, "fmt ") && bodySize >= 16)
+        {
+          format = readLittleEndian<u16>(chunk + 8);
+          channels = readLittleEndian<u16>(chunk + 10);
+          sampleRate = readLittleEndian<u32>(chunk + 12);
+          blockAlign = readLittleEndian<u16>(chunk + 20);
+          bytesPerSample = readLittleEndian<u16>(chunk + 22) / 8;
+          // the actual format is in the first 2 bytes of the subformat guid
+          if (format == kWaveExtensible && bodySize >= 40)
+            format = readLittleEndian<u16>(chunk + 32);
+        }
+        else if (hasTag(chunk, "data"))
+        {
+          samples = chunk + 8;
+          dataSize = bodySize;
+        }
+
+        // chunks are padded to an even size
+        position += 8 + chunkSize + (chunkSize & 1);
+      }
+
+      if (!samples || !sampleRate)
+        return "missing fmt or data chunk";
+      if (channels != 1 && channels != 2)
+        return "only mono and stereo files are supported";
+
+      bool isSupported = (format == kWavePcm && bytesPerSample >= 2 && bytesPerSample <= 4) ||
+        (format == kWaveFloat && (bytesPerSample == 4 || bytesPerSample == 8));
+      if (!isSupported || blockAlign != channels * bytesPerSample)
+        return "unsupported sample format";
+
+      frames = dataSize / blockAlign;
+      return nullptr;
+    }
+
+    void close()
+    {
+      if (memory)
+        utils::unmapFile(memory, mappedSize);
+      memory = nullptr;
+    }
+
+    float readSample(const byte *data) const
+    {
+      if (format == kWaveFloat)
+        return (bytesPerSample == 4) ? readLittleEndian<float>(data) : (float)readLittleEndian<double>(data);
+
+      switch (bytesPerSample)
+      {
+      case 2:
+        return (float)readLittleEndian<i16>(data) * (1.0f / 32768.0f);
+      case 3:
+        // sign extended by shifting the 24 bits to the top of the integer
+        return (float)((i32)((u32)data[0] << 8 | (u32)data[1] << 16 | (u32)data[2] << 24) >> 8) * (1.0f / 8388608.0f);
+      default:
+        return (float)((double)readLittleEndian<i32>(data) * (1.0 / 2147483648.0));
+      }
+    }
+
+    // deinterleaves into 2 channels, mono is copied to both and everything past the end is silence
+    void read(u64 startFrame, u32 count, float *left, float *right) const
+    {
+      u32 available = (startFrame < frames) ? (u32)utils::min<u64>(count, frames - startFrame) : 0;
+      const byte *data = samples + startFrame * channels * bytesPerSample;
+
+      for (u32 i = 0; i < available; ++i)
+      {
+        left[i] = readSample(data);
+        right[i] = (channels == 2) ? readSample(data + bytesPerSample) : left[i];
+        data += channels * bytesPerSample;
+      }
+
+      ::zeroset(left + available, count - available);
+      ::zeroset(right + available, count - available);
+    }
+  };
+
+  // stereo 32-bit float, sizes are patched in when it's closed
+  struct WavWriter
+  {
+    static constexpr u32 kHeaderSize = 56;
+
+    FILE *file{};
+    u64 frames{};
+
+    bool open(FILE *output, u32 sampleRate)
+    {
+      file = output;
+      if (!file)
+        return false;
+
+      byte header[kHeaderSize]{};
+      writeHeader(header, sampleRate);
+      return ::fwrite(header, 1, kHeaderSize, file) == kHeaderSize;
+    }
+
+    bool write(const float *interleaved, u32 count)
+    {
+      frames += count;
+      return ::fwrite(interleaved, sizeof(float) * 2, count, file) == count;
+    }
+
+    // the file is closed by whoever opened it
+    bool finish(u32 sampleRate)
+    {
+      byte header[kHeaderSize]{};
+      writeHeader(header, sampleRate);
+      return ::fseek(file, 0, SEEK_SET) == 0 && ::fwrite(header, 1, kHeaderSize, file) == kHeaderSize &&
+        ::fflush(file) == 0;
+    }
+
+    void writeHeader(byte *header, u32 sampleRate) const
+    {
+      auto put = [&](usize offset, auto value) { ::memcpy(header + offset, &value, sizeof(value)); };
+      u32 dataSize = (u32)utils::min<u64>(frames * sizeof(float) * 2, 0xFFFFFFFFU - kHeaderSize);
+
+      ::memcpy(header, "RIFF", 4);
+      put(4, (u32)(kHeaderSize - 8 + dataSize));
+      ::memcpy(header + 8, "WAVEfmt ", 8);
+      put(16, (u32)16);
+      put(20, kWaveFloat);
+      put(22, (u16)2);
+      put(24, sampleRate);
+      put(28, (u32)(sampleRate * sizeof(float) * 2));
+      put(32, (u16)(sizeof(float) * 2));
+      put(34, (u16)32);
+      // non-pcm formats need a fact chunk
+      ::memcpy(header + 36, "fact", 4);
+      put(40, (u32)4);
+      put(44, (u32)utils::min<u64>(frames, 0xFFFFFFFFU));
+      ::memcpy(header + 48, "data", 4);
+      put(52, dataSize);
+    }
+  };
+
+  struct RenderSettings
+  {
+    utils::string_view preset{};
+    const char *outputDirectory{};
+    utils::span<const char *> inputPaths{};
+    utils::span<WavFile> sidechains{};
+    u32 blockSize = kDefaultBlockSize;
+
+    satomi::atomic<u32> nextInput{};
+    satomi::atomic<u32> failedInputs{};
+  };
+
+  void getOutputPath(char *buffer, usize size, const char *inputPath, const char *outputDirectory)
+  {
+    usize length = utils::getStringSize(inputPath);
+    usize nameStart = length;
+    while (nameStart > 0 && inputPath[nameStart - 1] != '/' && inputPath[nameStart - 1] != '\\')
+      --nameStart;
+
+    if (outputDirectory)
+    {
+      (void)stbsp_snprintf(buffer, (int)size, "%s/%s", outputDirectory, inputPath + nameStart);
+      return;
+    }
+
+    usize extensionStart = length;
+    while (extensionStart > nameStart && inputPath[extensionStart - 1] != '.')
+      --extensionStart;
+    usize stemLength = (extensionStart > nameStart) ? extensionStart - 1 : length;
+
+    (void)stbsp_snprintf(buffer, (int)size, "%.*s_rendered.wav", (int)stemLength, inputPath);
+  }
+
+  // returns an error message on failure
+  const char *renderFile(Plugin::ComplexPlugin *plugin, RenderSettings &settings,
+    const WavFile &input, WavWriter &writer)
+  {
+    for (auto &sidechain : settings.sidechains)
+      if (sidechain.sampleRate != input.sampleRate)
+        return "sidechain sample rate doesn't match the input";
+
+    u32 blockSize = settings.blockSize;
+    u32 inputChannels = utils::kChannelsPerInOut * (u32)(settings.sidechains.size() + 1);
+
+    plugin->initialise((float)input.sampleRate, blockSize);
+    Plugin::loadStateImmediately(plugin, settings.preset);
+
+    auto *scratch = getLocalScratch();
+    float **in = arranew(scratch, float *, inputChannels, {});
+    for (u32 i = 0; i < inputChannels; ++i)
+      in[i] = arranew(scratch, float, blockSize, {});
+    float *out[] = { arranew(scratch, float, blockSize, {}), arranew(scratch, float, blockSize, {}) };
+    float *interleaved = arranew(scratch, float, blockSize * 2, {});
+    defer
+    {
+      utils::bumpArena::remove(interleaved);
+      utils::bumpArena::remove(out[1]);
+      utils::bumpArena::remove(out[0]);
+      for (u32 i = inputChannels; i > 0; --i)
+        utils::bumpArena::remove(in[i - 1]);
+      utils::bumpArena::remove(in);
+    };
+
+    // the first latency samples of the output are dropped and the input is padded
+    // with as many samples of silence so that the output lines up with the input
+    bool isLatencyKnown = false;
+    u64 samplesToSkip = 0;
+    bool isWritten = true;
+    for (u64 position = 0; writer.frames < input.frames; position += blockSize)
+    {
+      input.read(position, blockSize, in[0], in[1]);
+      for (usize i = 0; i < settings.sidechains.size(); ++i)
+        settings.sidechains[i].read(position, blockSize,
+          in[utils::kChannelsPerInOut * (i + 1)], in[utils::kChannelsPerInOut * (i + 1) + 1]);
+
+      plugin->process(in, out, blockSize, inputChannels, utils::kChannelsPerInOut);
+
+      // process() reports the latency for the block it's processing
+      if (!isLatencyKnown)
+      {
+        samplesToSkip = plugin->latency.load(satomi::memory_order_relaxed);
+        isLatencyKnown = true;
+      }
+
+      u32 offset = (u32)utils::min<u64>(samplesToSkip, blockSize);
+      samplesToSkip -= offset;
+      u32 count = (u32)utils::min<u64>(blockSize - offset, input.frames - writer.frames);
+
+      for (u32 i = 0; i < count; ++i)
+      {
+        interleaved[2 * i] = out[0][offset + i];
+        interleaved[2 * i + 1] = out[1][offset + i];
+      }
+      isWritten &= writer.write(interleaved, count);
+    }
+
+    isWritten &= writer.finish(input.sampleRate);
+    return (isWritten) ? nullptr : "couldn't write output file";
+  }
+
+  // instances are created directly instead of through cplug_createPlugin, there's no host behind them
+  Plugin::ComplexPlugin *createRenderPlugin(u32 sidechains)
+  {
+    static CplugHostContext hostContext
+    {
+      .type = CPLUG_PLUGIN_IS_STANDALONE,
+      .sendParamEvent = [](CplugHostContext *, const CplugEvent *) { },
+      .rescan = [](CplugHostContext *, uint32_t) { },
+      .getHostName = [](CplugHostContext *, char *buffer, size_t size)
+      {
+        (void)stbsp_snprintf(buffer, (int)size, "complex-render");
+        return true;
+      },
+      .requestResize = [](CplugHostContext *, uint32_t, uint32_t) { return false; }
+    };
+
+    auto *plugin = anew(globalArena, Plugin::ComplexPlugin, { kParameterMappings, sidechains, 0, 1, &hostContext });
+    plugin->isRenderingOffline.store(true, satomi::memory_order_relaxed);
+    return plugin;
+  }
+
+  // same teardown as cplug_destroyPlugin
+  void destroyRenderPlugin(Plugin::ComplexPlugin *plugin)
+  {
+    plugin->stateLoader = utils::thread{};
+    plugin->loadedState_ = nullptr;
+    plugin->loadMessages_ = {};
+    plugin->retiringState_ = nullptr;
+    plugin->state_ = nullptr;
+    plugin->fft.releaseFFTOrders();
+    utils::bumpArena::remove(plugin);
+  }
+
+  // loads the preset the same way a render does and saves it as json, which is how binary presets get read back
+  // returns an error message on failure
+  const char *exportJson(utils::string_view preset, const char *outputPath)
+  {
+    FILE *file = ::fopen(outputPath, "wb");
+    if (!file)
+      return "couldn't create the file";
+
+    auto *plugin = createRenderPlugin(0);
+    // saves don't depend on the sample rate
+    plugin->initialise(44100.0f, kDefaultBlockSize);
+    Plugin::loadStateImmediately(plugin, preset);
+    Plugin::saveState(plugin, file, [](const void *stateCtx, void *data, usize size)
+      { return (i64)::fwrite(data, 1, size, (FILE *)stateCtx); }, true);
+    destroyRenderPlugin(plugin);
+
+    bool hasFailed = ::ferror(file) != 0;
+    hasFailed |= ::fclose(file) != 0;
+    return (hasFailed) ? "couldn't write the file" : nullptr;
+  }
+
+  // every job has its own plugin instance and takes the next input that's left
+  void renderFiles(RenderSettings &settings)
+  {
+    utils::ScopedNoDenormals noDenormals{};
+
+    auto *plugin = createRenderPlugin((u32)settings.sidechains.size());
+
+    while (true)
+    {
+      u32 index = settings.nextInput.fetch_add(1, satomi::memory_order_relaxed);
+      if (index >= settings.inputPaths.size())
+        break;
+
+      const char *inputPath = settings.inputPaths[index];
+      char outputPath[4096];
+      getOutputPath(outputPath, sizeof(outputPath), inputPath, settings.outputDirectory);
+
+      u64 start = utils::getMonotonicMicroseconds();
+
+      WavFile input{};
+      const char *error = input.open(inputPath);
+      if (!error)
+      {
+        WavWriter writer{};
+        if (writer.open(::fopen(outputPath, "wb"), input.sampleRate))
+          error = renderFile(plugin, settings, input, writer);
+        else
+          error = "couldn't create output file";
+
+        if (writer.file && ::fclose(writer.file) != 0 && !error)
+          error = "couldn't write output file";
+      }
+      input.close();
+
+      double seconds = (double)(utils::getMonotonicMicroseconds() - start) * 1e-6;
+      char message[4096 + 256];
+      if (error)
+      {
+        settings.failedInputs.fetch_add(1, satomi::memory_order_relaxed);
+        (void)stbsp_snprintf(message, (int)sizeof(message), "%s: %s\n", inputPath, error);
+        ::fputs(message, stderr);
+        continue;
+      }
+
+      double duration = (double)input.frames / (double)input.sampleRate;
+      (void)stbsp_snprintf(message, (int)sizeof(message), "%s -> %s: %.2fs of audio in %.3fs (%.1fx realtime)\n",
+        inputPath, outputPath, duration, seconds, duration / utils::max(seconds, 1e-6));
+      ::fputs(message, stdout);
+    }
+
+    destroyRenderPlugin(plugin);
+  }
+
+  // prints the violations recorded since the last call and returns how many there were
+  usize printAudioThreadViolations()
+  {
+    static constexpr const char *kViolationNames[] =
+      { "arena insert", "arena resize", "arena remove", "blocking lock", "long lock wait" };
+
+    utils::AudioThreadGuard::Violation violations[16];
+    usize total = 0;
+    while (usize count = utils::AudioThreadGuard::drain(violations))
+    {
+      for (usize i = 0; i < count; ++i)
+      {
+        auto &violation = violations[i];
+        ::fprintf(stderr, "audio thread violation (%s, waited %llu us) at %s:%u in %s\n",
+          kViolationNames[violation.type], (unsigned long long)violation.waitUs,
+          violation.location.fileName, violation.location.line, violation.location.functionName);
+      }
+      total += count;
+    }
+    return total;
+  }
+
+  // Tests.cpp, filters select the tests/benchmarks whose names contain any of them
+  int runTests(utils::span<const char *> filters);
+  int runBenchmarks(utils::span<const char *> filters);
+
+  void printUsage()
+  {
+    ::fputs(
+      "usage: complex-render [options] <input.wav>...\n"
+      "       complex-render [--preset <file>] --export-json <file>\n"
+      "       complex-render --test [name]...\n"
+      "       complex-render --benchmark [name]...\n"
+      "  --preset <file>         json or binary preset that every input is processed with,\n"
+      "                          the default preset is used if there's none\n"
+      "  --output-dir <dir>      where outputs are written with the input's name,\n"
+      "                          next to the input with a _rendered suffix by default\n"
+      "  --sidechain <file>      wav fed into the next sidechain input for every file, can be repeated\n"
+      "  --jobs <count>          files processed in parallel, 0 uses every core (default 1)\n"
+      "  --block-size <samples>  samples per process call (default 8192)\n"
+      "  --export-json <file>    saves the preset as json instead of rendering anything\n", stderr);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  cplug_libraryLoad();
+  defer{ cplug_libraryUnload(); };
+
+  if (argc > 1)
+  {
+    utils::string_view mode{ argv[1], utils::getStringSize(argv[1]) };
+    utils::span<const char *> filters{ (const char **)argv + 2, (usize)argc - 2 };
+    if (mode == "--test")
+      return runTests(filters);
+    if (mode == "--benchmark")
+      return runBenchmarks(filters);
+  }
+
+  RenderSettings settings{};
+  const char *presetPath = nullptr;
+  const char *exportPath = nullptr;
+  u32 jobs = 1;
+
+  auto *inputPaths = arranew(globalArena, const char *, (usize)argc, {});
+  auto *sidechainPaths = arranew(globalArena, const char *, (usize)argc, {});
+  usize inputCount = 0, sidechainCount = 0;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    utils::string_view argument{ argv[i], utils::getStringSize(argv[i]) };
+    bool hasValue = i + 1 < argc;
+
+    if (argument == "--preset" && hasValue)
+      presetPath = argv[++i];
+    else if (argument == "--output-dir" && hasValue)
+      settings.outputDirectory = argv[++i];
+    else if (argument == "--sidechain" && hasValue)
+      sidechainPaths[sidechainCount++] = argv[++i];
+    else if (argument == "--jobs" && hasValue)
+      jobs = (u32)::strtoul(argv[++i], nullptr, 10);
+    else if (argument == "--block-size" && hasValue)
+      settings.blockSize = utils::clamp((u32)::strtoul(argv[++i], nullptr, 10), 32U, kMaxBlockSize);
+    else if (argument == "--export-json" && hasValue)
+      exportPath = argv[++i];
+    else if (argument.size() > 2 && argument[0] == '-' && argument[1] == '-')
+    {
+      printUsage();
+      return 1;
+    }
+    else
+      inputPaths[inputCount++] = argv[i];
+  }
+
+  // either inputs are rendered or the preset is exported
+  if (!inputCount == !exportPath)
+  {
+    printUsage();
+    return 1;
+  }
+
+  usize presetSize = 0;
+  const byte *presetData = (presetPath) ? utils::mapFile(presetPath, presetSize) : nullptr;
+  if (presetPath && !presetData)
+  {
+    ::fprintf(stderr, "%s: couldn't open preset\n", presetPath);
+    return 1;
+  }
+  defer
+  {
+    if (presetData)
+      utils::unmapFile(presetData, presetSize);
+  };
+  settings.preset = { (const char *)presetData, presetSize };
+
+  if (exportPath)
+  {
+    if (const char *error = exportJson(settings.preset, exportPath))
+    {
+      ::fprintf(stderr, "%s: %s\n", exportPath, error);
+      return 1;
+    }
+    return 0;
+  }
+
+  // sidechains are shared by all inputs, so they're opened once
+  auto *sidechains = arranew(globalArena, WavFile, sidechainCount, {});
+  defer
+  {
+    for (usize i = 0; i < sidechainCount; ++i)
+      sidechains[i].close();
+  };
+  for (usize i = 0; i < sidechainCount; ++i)
+  {
+    if (const char *error = sidechains[i].open(sidechainPaths[i]))
+    {
+      ::fprintf(stderr, "%s: %s\n", sidechainPaths[i], error);
+      return 1;
+    }
+  }
+
+  settings.inputPaths = { inputPaths, inputCount };
+  settings.sidechains = { sidechains, sidechainCount };
+
+  if (jobs == 0)
+    jobs = utils::getProcessorCount();
+  jobs = utils::clamp(jobs, 1U, (u32)inputCount);
+
+  u64 start = utils::getMonotonicMicroseconds();
+  {
+    // the calling thread is the first job, the others are joined when they're destroyed
+    auto *workers = arranew(globalArena, utils::thread, jobs, {});
+    for (u32 i = 1; i < jobs; ++i)
+      workers[i] = [&settings]() { renderFiles(settings); };
+
+    renderFiles(settings);
+
+    for (u32 i = jobs; i > 0; --i)
+      workers[i - 1].~thread();
+    utils::bumpArena::remove(workers);
+  }
+
+  u32 failedInputs = settings.failedInputs.load(satomi::memory_order_relaxed);
+  ::fprintf(stdout, "%zu of %zu files rendered in %.3fs with %u jobs\n", inputCount - failedInputs, inputCount,
+    (double)(utils::getMonotonicMicroseconds() - start) * 1e-6, jobs);
+
+  // the log only keeps the latest entries, the count has every one of them
+  (void)printAudioThreadViolations();
+  if (u64 violations = utils::AudioThreadGuard::getViolationCount())
+  {
+    ::fprintf(stderr, "%llu realtime-unsafe operations on the audio thread\n", (unsigned long long)violations);
+    return 1;
+  }
+
+  return (failedInputs) ? 1 : 0;
+}
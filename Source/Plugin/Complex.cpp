@@ -26,6 +26,7 @@ namespace
 
     executableStaticData.arena = utils::bumpArena::create(COMPLEX_MB(1), COMPLEX_KB(64));
     executableStaticData.structure.arena = utils::bumpArena::create(COMPLEX_MB(1), COMPLEX_KB(64));
+    executableStaticData.fftPlans.arena = globalArena;
 
     auto pushString = [&](utils::string_view string)
     {
@@ -59,9 +60,9 @@ namespace
         {
           pushString(option->displayName);
 
-          if (option->flags == Framework::IndexedData::ProcessorFlag)
+          if (option->flags == Framework::IndexedData::Flags::ProcessorFlag)
             recurseProcessors(recurseProcessors, option->processorMetadata);
-          else if (option->flags == Framework::IndexedData::ParameterFlag)
+          else if (option->flags == Framework::IndexedData::Flags::ParameterFlag)
             recurseParameters(recurseParameters, recurseProcessors, option->parameterMetadata);
 
           if (option->children && !visitedChildren)
@@ -203,12 +204,17 @@ namespace Framework
 
 namespace Plugin
 {
-  void saveState(ComplexPlugin *plugin, const void *stateCtx, cplug_writeProc writeProc);
+  // the binary format is what hosts get, json is for exporting and debugging
+  void saveState(ComplexPlugin *plugin, const void *stateCtx, cplug_writeProc writeProc, bool asJson = false);
   void loadState(ComplexPlugin *plugin, utils::string_view data);
+  // builds and installs the state on the calling thread, without an undo step or a crossfade
+  // for offline processing where the state has to be in place before the first block
+  void loadStateImmediately(ComplexPlugin *plugin, utils::string_view data);
 
   State::State(ComplexPlugin *plugin) : plugin{ plugin }
   {
-    processorStorage = utils::bumpArena::create(COMPLEX_MB(256), COMPLEX_MB(2));
+    // spectral buffers of all processors live here, so back them with huge pages if possible
+    processorStorage = utils::bumpArena::create(COMPLEX_MB(256), COMPLEX_MB(2), utils::bumpArena::HugePages);
     miscStorage = utils::bumpArena::createNested(processorStorage, COMPLEX_KB(128));
     uiStorage = utils::bumpArena::create(COMPLEX_MB(256), COMPLEX_MB(4));
 
@@ -220,6 +226,7 @@ namespace Plugin
     dynamicParameters = { { miscStorage, false }, 32 };
     workers = { { miscStorage, false }, 16 };
     cachedHotreloadSymbols.data = { { miscStorage, false }, 16 };
+    retiredDescriptors = { { miscStorage, false }, 16 };
 
     createDynamicParameters();
 
@@ -448,6 +455,7 @@ namespace Plugin
     hostContext{ hostContext }, renderer{ *this }
   {
     fft.arena = arena;
+    fft.planCache = &executableStaticData.fftPlans;
     loadState(this, {});
     // plugin formats will later call loadState
     // but in between that other functions get called that will require *some* state
@@ -456,6 +464,8 @@ namespace Plugin
 
   ComplexPlugin::~ComplexPlugin()
   {
+    // a load might still be in progress
+    stateLoader = utils::thread{};
   }
 
   void ComplexPlugin::initialise(float newSampleRate, u32 newSamplesPerBlock)
@@ -469,6 +479,29 @@ namespace Plugin
 
       auto lock = acquireProcessingLock(true);
 
+      if (fadeOutputs)
+      {
+        for (u32 i = fadeChannels; i > 0; --i)
+        {
+          utils::bumpArena::remove(fadeDelayLines[i - 1]);
+          utils::bumpArena::remove(fadeOutputs[i - 1]);
+        }
+        utils::bumpArena::remove(fadeDelayLines);
+        utils::bumpArena::remove(fadeOutputs);
+      }
+
+      fadeChannels = utils::kChannelsPerInOut * (outSidechains + 1);
+      fadeBufferSize = newSamplesPerBlock;
+      fadeDelayLineSize = kMaxFadeDelay + newSamplesPerBlock;
+      fadeDelayPosition = 0;
+      fadeOutputs = arranew(arena, float *, fadeChannels, {});
+      fadeDelayLines = arranew(arena, float *, fadeChannels, {});
+      for (u32 i = 0; i < fadeChannels; ++i)
+      {
+        fadeOutputs[i] = arranew(arena, float, fadeBufferSize, {});
+        fadeDelayLines[i] = arranew(arena, float, fadeDelayLineSize, {});
+      }
+
       auto state = state_;
       if (!state)
         return;
@@ -480,11 +513,30 @@ namespace Plugin
   utils::sp<State>
   ComplexPlugin::exchangeStates(utils::sp<State> state)
   {
+    utils::sp<State> releasedState{};
     {
       auto guard = acquireProcessingLock(true);
       state_.swap(state);
+      publishState();
+
+      // process() can't be running while we hold the lock, so the crossfade is set up here
+      // and the audio thread only sees the new state at its next block
+      // if a previous crossfade hasn't finished yet it's cut short
+      // keeping the previous state here until the next exchange is also what makes releasing it safe,
+      // host readers can hold onto a state for up to 2 flips (see waitForHostReaders)
+      releasedState = COMPLEX_MOVE(retiringState_);
+      retiringState_ = state;
+      fadingState = state.get();
+      isFadeStarting = true;
+      fadePosition = 0;
+      fadeLength = (u32)(kStateCrossfadeSeconds * getSampleRate());
     }
 
+    // waiting on host readers doesn't hold up the audio thread, whatever was retired before
+    // has been through the flip of its own exchange and this one and is released here instead of on the audio thread
+    (void)waitForHostReaders();
+    releasedState = nullptr;
+
     // refresh all parameters as soon as the states are exchanged
     hostContext->rescan(hostContext,
       CPLUG_FLAG_RESCAN_PARAM_METADATA | CPLUG_FLAG_RESCAN_PARAM_NAMES | CPLUG_FLAG_RESCAN_PARAM_VALUES);
@@ -492,27 +544,114 @@ namespace Plugin
     return state;
   }
 
+  u32 ComplexPlugin::waitForHostReaders()
+  {
+    utils::ScopedLock g{ hostEpochLock, utils::WaitMechanism::Spin };
+    u32 epoch = hostReaderEpoch.fetch_add(1);
+    while (hostReaders[epoch & 1].load(satomi::memory_order_acquire))
+      COMPLEX_PAUSE();
+
+    return epoch + 1;
+  }
+
+  HostStateReader::HostStateReader(ComplexPlugin &plugin) : plugin{ plugin }
+  {
+    slot = plugin.hostReaderEpoch.load() & 1;
+    plugin.hostReaders[slot].fetch_add(1);
+    state = plugin.hostState.load();
+  }
+
+  HostStateReader::~HostStateReader()
+  {
+    plugin.hostReaders[slot].fetch_sub(1, satomi::memory_order_release);
+  }
+
   void ComplexPlugin::rescanLatency()
   {
     if (hasLatencyChanged.exchange(false, satomi::memory_order_relaxed))
       hostContext->rescan(hostContext, CPLUG_FLAG_RESCAN_LATENCY);
   }
 
+  usize ComplexPlugin::reportAudioThreadViolations()
+  {
+  #if COMPLEX_AUDIO_THREAD_GUARD
+    utils::AudioThreadGuard::Violation violations[16];
+    usize total = 0;
+    while (usize count = utils::AudioThreadGuard::drain(violations))
+    {
+      static constexpr const char *kViolationNames[] =
+        { "arena insert", "arena resize", "arena remove", "blocking lock", "long lock wait" };
+
+      for (usize i = 0; i < count; ++i)
+      {
+        auto &violation = violations[i];
+        COMPLEX_LOG("Audio thread violation (%s, waited %llu us) at %s:%u in %s",
+          kViolationNames[violation.type], (unsigned long long)violation.waitUs,
+          violation.location.fileName, violation.location.line, violation.location.functionName);
+      }
+      total += count;
+    }
+    return total;
+  #else
+    return 0;
+  #endif
+  }
+
   void ComplexPlugin::process(float *const *in, float *const *out,
     u32 numSamples, u32 numInputs, u32 numOutputs)
   {
+  #if COMPLEX_AUDIO_THREAD_GUARD
+    utils::AudioThreadGuard::Scope audioThreadScope{};
+  #endif
+
     float currentSampleRate = getSampleRate();
 
+    bool shouldCountPageFaults = countPageFaults.load(satomi::memory_order_relaxed);
+    u64 pageFaultsAtStart = (shouldCountPageFaults) ? utils::getPageFaultCount() : 0;
+
     utils::ScopedLock g{ processingLock, false, utils::WaitMechanism::Spin };
 
     auto state = state_;
+
+    // the previous state's output goes into the fade buffers, it needs to run first
+    // in case the host gave us the same buffers for input and output
+    bool canFade = numSamples <= fadeBufferSize && numOutputs <= fadeChannels;
+    bool isFading = fadingState && fadeLength && canFade;
+    if (isFading)
+    {
+      fadingState->soundEngine->updateParameters(UpdateFlag::BeforeProcess, currentSampleRate, true);
+      fadingState->soundEngine->process(in, fadeOutputs, numSamples,
+        currentSampleRate, numInputs, numOutputs, *fadingState->fft);
+      fadingState->soundEngine->updateParameters(UpdateFlag::AfterProcess, currentSampleRate, true);
+    }
+    else
+      fadingState = nullptr;
+
     state->soundEngine->updateParameters(UpdateFlag::BeforeProcess,
       currentSampleRate, true);
 
-    if (auto latency_ = state->soundEngine->getProcessingDelay();
-      latency_ != latency.load(satomi::memory_order_relaxed))
+    // the new state's delay is only known once it has updated its parameters,
+    // it's lined up with the previous one's by delaying whichever is ahead until the fade is over
+    u32 processingDelay = state->soundEngine->getProcessingDelay();
+    if (isFading && isFadeStarting)
+    {
+      isFadeStarting = false;
+      fadePrimedSamples = 0;
+      fadeDelay = utils::clamp((i32)processingDelay - (i32)fadingState->soundEngine->getProcessingDelay(),
+        -(i32)kMaxFadeDelay, (i32)kMaxFadeDelay);
+
+      // the new state didn't output anything before, while the line holds the previous output for the fading state
+      if (fadeDelay < 0)
+        for (u32 i = 0; i < numOutputs; ++i)
+          for (u32 j = 0; j < (u32)-fadeDelay; ++j)
+            fadeDelayLines[i][(fadeDelayLineSize + fadeDelayPosition - 1 - j) % fadeDelayLineSize] = 0.0f;
+    }
+    if (isFading && fadeDelay < 0)
+      processingDelay += (u32)-fadeDelay;
+
+    if (processingDelay != latency.load(satomi::memory_order_relaxed))
     {
-      latency.store(latency_, satomi::memory_order_relaxed);
+      latency.store(processingDelay, satomi::memory_order_relaxed);
       hasLatencyChanged.store(true, satomi::memory_order_relaxed);
     }
 
@@ -521,6 +660,59 @@ namespace Plugin
 
     state->soundEngine->updateParameters(UpdateFlag::AfterProcess,
       currentSampleRate, true);
+
+    // writes into the delay line and reads back what was written delay samples earlier, in place
+    auto delayOutputs = [&](float *const *buffers, u32 delay)
+    {
+      for (u32 i = 0; i < numOutputs; ++i)
+        for (u32 j = 0; j < numSamples; ++j)
+        {
+          fadeDelayLines[i][(fadeDelayPosition + j) % fadeDelayLineSize] = buffers[i][j];
+          buffers[i][j] = fadeDelayLines[i][(fadeDelayLineSize + fadeDelayPosition + j - delay) % fadeDelayLineSize];
+        }
+      fadeDelayPosition = (fadeDelayPosition + numSamples) % fadeDelayLineSize;
+    };
+
+    if (isFading)
+    {
+      if (fadeDelay > 0)
+        delayOutputs(fadeOutputs, (u32)fadeDelay);
+      else if (fadeDelay < 0)
+        delayOutputs(out, (u32)-fadeDelay);
+
+      // until the new state is primed its output is incomplete, so the previous one is kept as it is,
+      // when it's being delayed that's until the delayed output is primed too
+      bool isPrimed = state->soundEngine->isPrimed();
+      bool isIncomingReady = isPrimed && fadePrimedSamples >= (u32)utils::max(-fadeDelay, 0);
+      if (isPrimed)
+        fadePrimedSamples += numSamples;
+
+      float fadeIncrement = (isIncomingReady) ? 1.0f / (float)fadeLength : 0.0f;
+      for (u32 i = 0; i < numOutputs; ++i)
+      {
+        float fade = (float)fadePosition * fadeIncrement;
+        for (u32 j = 0; j < numSamples; ++j)
+        {
+          fade = utils::min(fade, 1.0f);
+          out[i][j] = fadeOutputs[i][j] + (out[i][j] - fadeOutputs[i][j]) * fade;
+          fade += fadeIncrement;
+        }
+      }
+
+      // the state itself is released on the next exchange, never on the audio thread
+      if (fadeIncrement != 0.0f)
+      {
+        fadePosition += numSamples;
+        if (fadePosition >= fadeLength)
+          fadingState = nullptr;
+      }
+    }
+    // recorded in case this turns out to be the output of a state that's going to be faded out
+    else if (canFade)
+      delayOutputs(out, 0);
+
+    if (shouldCountPageFaults)
+      processPageFaults.fetch_add(utils::getPageFaultCount() - pageFaultsAtStart, satomi::memory_order_relaxed);
   }
 }
 
@@ -589,11 +781,22 @@ void *cplug_createPlugin(CplugHostContext *ctx)
 {
   COMPLEX_ASSERT(getLocalScratch());
 
-  usize parameterMappings = 64, inSidechains = 0, outSidechains = 0, undoSteps = 100;
-  Framework::LoadSave::getStartupParameters(parameterMappings, inSidechains, outSidechains, undoSteps);
+  usize parameterMappings = 64, inSidechains = 0, outSidechains = 0, undoSteps = 100,
+    undoHistoryBudget = Framework::UndoManager::defaultHistoryBudget;
+  bool isLowLatency = false, isRenderingOffline = false;
+  Framework::LoadSave::getStartupParameters(parameterMappings, inSidechains, outSidechains,
+    undoSteps, undoHistoryBudget, isLowLatency, isRenderingOffline);
 
+  [[maybe_unused]] u64 creationStart = utils::getMonotonicMicroseconds();
   auto *plugin = anew(globalArena, utils::sll<Plugin::ComplexPlugin>, 
     { { parameterMappings, (u32)inSidechains, (u32)outSidechains, undoSteps, ctx } });
+  COMPLEX_LOG("Plugin instance created in %llu us, shared fft plans saved %zu bytes",
+    (unsigned long long)(utils::getMonotonicMicroseconds() - creationStart),
+    executableStaticData.fftPlans.getSavedBytes());
+  plugin->object.undoManager.setHistoryBudget(undoHistoryBudget);
+  plugin->object.isLowLatency.store(isLowLatency, satomi::memory_order_relaxed);
+  plugin->object.isRenderingOffline.store(isRenderingOffline, satomi::memory_order_relaxed);
+
   utils::ScopedLock g{ executableStaticData.readWriteLock, true, utils::WaitMechanism::WaitNotify };
 
   if (auto *lastNode = executableStaticData.pluginInstances)
@@ -626,6 +829,15 @@ void cplug_destroyPlugin(void *ptr)
     ((lastNode) ? lastNode->next : executableStaticData.pluginInstances) = node->next;
   }
 
+  // the destructor isn't run, so states (which own worker threads) and the shared plans
+  // need to be released explicitly before the memory goes away
+  plugin->stateLoader = utils::thread{};
+  plugin->loadedState_ = nullptr;
+  plugin->loadMessages_ = {};
+  plugin->retiringState_ = nullptr;
+  plugin->state_ = nullptr;
+  plugin->fft.releaseFFTOrders();
+
   // warning: this only works because the plugin is the first member
   utils::bumpArena::remove(plugin);
 }
@@ -692,29 +904,25 @@ uint32_t cplug_getParameterID([[maybe_unused]] void *ptr, uint32_t paramIndex)
 
 void cplug_getParameterName(void *ptr, uint32_t paramId, char *buf, size_t buflen)
 {
-  auto lock = ((Plugin::ComplexPlugin *)ptr)->acquireProcessingLock(false);
-  auto state = ((Plugin::ComplexPlugin *)ptr)->state_;
+  auto state = ((Plugin::ComplexPlugin *)ptr)->readStateForHost();
   state->parameterBridges[paramId].getName(buf, buflen);
 }
 
 double cplug_getParameterValue(void *ptr, uint32_t paramId)
 {
-  auto lock = ((Plugin::ComplexPlugin *)ptr)->acquireProcessingLock(false);
-  auto state = ((Plugin::ComplexPlugin *)ptr)->state_;
+  auto state = ((Plugin::ComplexPlugin *)ptr)->readStateForHost();
   return state->parameterBridges[paramId].getValue();
 }
 
 double cplug_getDefaultParameterValue(void *ptr, uint32_t paramId)
 {
-  auto lock = ((Plugin::ComplexPlugin *)ptr)->acquireProcessingLock(false);
-  auto state = ((Plugin::ComplexPlugin *)ptr)->state_;
+  auto state = ((Plugin::ComplexPlugin *)ptr)->readStateForHost();
   return state->parameterBridges[paramId].getDefaultValue();
 }
 
 void cplug_setParameterValue(void *ptr, uint32_t paramId, double value)
 {
-  auto lock = ((Plugin::ComplexPlugin *)ptr)->acquireProcessingLock(false);
-  auto state = ((Plugin::ComplexPlugin *)ptr)->state_;
+  auto state = ((Plugin::ComplexPlugin *)ptr)->readStateForHost();
   state->parameterBridges[paramId].setValue((float)value);
 }
 
@@ -730,15 +938,13 @@ double cplug_normaliseParameterValue([[maybe_unused]] void *ptr, [[maybe_unused]
 
 double cplug_parameterStringToValue(void *ptr, uint32_t paramId, const char *str)
 {
-  auto lock = ((Plugin::ComplexPlugin *)ptr)->acquireProcessingLock(false);
-  auto state = ((Plugin::ComplexPlugin *)ptr)->state_;
+  auto state = ((Plugin::ComplexPlugin *)ptr)->readStateForHost();
   return state->parameterBridges[paramId].getValueForText({ str, utils::getStringSize(str) });
 }
 
 void cplug_parameterValueToString(void *ptr, uint32_t paramId, char *buf, size_t bufsize, double value)
 {
-  auto lock = ((Plugin::ComplexPlugin *)ptr)->acquireProcessingLock(false);
-  auto state = ((Plugin::ComplexPlugin *)ptr)->state_;
+  auto state = ((Plugin::ComplexPlugin *)ptr)->readStateForHost();
   state->parameterBridges[paramId].getText((float)value, buf, bufsize);
 }
 
@@ -747,11 +953,10 @@ void cplug_getParameterRange(void *ptr, uint32_t paramId, double *min, double *m
   *min = 0.0;
   *max = 1.0;
 
-  auto lock = ((Plugin::ComplexPlugin *)ptr)->acquireProcessingLock(false);
-  auto state = ((Plugin::ComplexPlugin *)ptr)->state_;
-  if (auto link = state->parameterBridges[paramId].getParameterLink())
+  auto state = ((Plugin::ComplexPlugin *)ptr)->readStateForHost();
+  if (auto descriptor = state->parameterBridges[paramId].getDescriptor(); descriptor->isMapped)
   {
-    auto details = link->parameter->getParameterDetails();
+    auto &details = descriptor->details;
     if (details.scale == Framework::ParameterScale::Indexed)
     {
       *min = 0.0;
@@ -768,13 +973,10 @@ void cplug_getParameterRange(void *ptr, uint32_t paramId, double *min, double *m
 uint32_t cplug_getParameterFlags(void *ptr, uint32_t paramId)
 {
   uint32_t flags = CPLUG_FLAG_PARAMETER_IS_AUTOMATABLE;
-  auto lock = ((Plugin::ComplexPlugin *)ptr)->acquireProcessingLock(false);
-  auto state = ((Plugin::ComplexPlugin *)ptr)->state_;
-  auto &bridge = state->parameterBridges[paramId];
-
-  if (auto link = bridge.getParameterLink())
+  auto state = ((Plugin::ComplexPlugin *)ptr)->readStateForHost();
+  if (auto descriptor = state->parameterBridges[paramId].getDescriptor(); descriptor->isMapped)
   {
-    auto details = link->parameter->getParameterDetails();
+    auto &details = descriptor->details;
     flags |= details.scale == Framework::ParameterScale::Toggle ? CPLUG_FLAG_PARAMETER_IS_BOOL : 0;
     flags |= details.scale == Framework::ParameterScale::Indexed ?
       CPLUG_FLAG_PARAMETER_IS_INTEGER : 0;
@@ -797,29 +999,47 @@ void cplug_saveState(void *userPlugin, const void *stateCtx, cplug_writeProc wri
   saveState((Plugin::ComplexPlugin *)userPlugin, stateCtx, writeProc);
 }
 
-void cplug_loadState(void *userPlugin, const void *stateCtx, cplug_readProc readProc)
+// reads the whole host stream into the local scratch, the caller removes the buffer
+static utils::span<char> readHostState(const void *stateCtx, cplug_readProc readProc)
 {
-  static constexpr auto kCapacityIncrease = COMPLEX_KB(4);
-
-  usize capacity = kCapacityIncrease;
+  // most states fit in the first read, larger ones grow the buffer by its own size but by no more than
+  // kMaxCapacityIncrease, so that readProc is called a few times instead of once every 4 KB
+  // without reserving far past the end of the state, any growth past what's left of the arena's reservation
+  // moves the buffer into a new one, copying (and faulting in) everything read up to that point
+  static constexpr auto kInitialCapacity = COMPLEX_KB(64);
+  static constexpr auto kMaxCapacityIncrease = COMPLEX_MB(4);
+  // a full buffer is only grown if the host has something left, so states that fill it exactly don't grow it
+  static constexpr auto kProbeSize = COMPLEX_KB(4);
+
+  usize capacity = kInitialCapacity;
   usize size{};
-  char *buffer = arranew(getLocalScratch(), char, capacity, {});
-  while (true)
+  char *buffer = arranew(getLocalScratch(), char, capacity);
+  while (usize readBytes = readProc(stateCtx, buffer + size, capacity - size))
   {
-    usize readBytes = readProc(stateCtx, buffer + size, capacity - size);
     size += readBytes;
-    if (!readBytes)
+    if (size < capacity)
+      continue;
+
+    char probe[kProbeSize];
+    usize probedBytes = readProc(stateCtx, probe, kProbeSize);
+    if (!probedBytes)
       break;
 
-    if (size >= capacity)
-    {
-      capacity += kCapacityIncrease;
-      buffer = (char *)utils::bumpArena::resize(buffer, capacity, true);
-    }
+    capacity += utils::min(capacity, (usize)kMaxCapacityIncrease);
+    // only the first size bytes are ever read, no need to clear the rest
+    buffer = (char *)utils::bumpArena::resize(buffer, capacity);
+    ::memcpy(buffer + size, probe, probedBytes);
+    size += probedBytes;
   }
 
-  loadState((Plugin::ComplexPlugin *)userPlugin, { buffer, size });
-  utils::bumpArena::remove(buffer);
+  return { buffer, size };
+}
+
+void cplug_loadState(void *userPlugin, const void *stateCtx, cplug_readProc readProc)
+{
+  auto state = readHostState(stateCtx, readProc);
+  loadState((Plugin::ComplexPlugin *)userPlugin, { state.data(), state.size() });
+  utils::bumpArena::remove(state.data());
 }
 
 
@@ -835,7 +1055,8 @@ void cplug_process(void *ptr, CplugProcessContext *ctx)
 
   auto *plugin = (Plugin::ComplexPlugin *)ptr;
 
-  // "Sample accurate" process loop
+  // sample accurate process loop, the block is split at every event so that parameter changes
+  // apply from the frame they were sent at, if there are none the whole block is processed at once
   CplugEvent event;
   uint32_t   frame = 0;
   while (ctx->dequeueEvent(ctx, &event, frame))
@@ -863,7 +1084,9 @@ void cplug_process(void *ptr, CplugProcessContext *ctx)
       COMPLEX_ASSERT(out[0] != nullptr);
       COMPLEX_ASSERT(out[1] != nullptr);
 
-      plugin->process(in, out, event.processAudio.endFrame - frame, 2, 2);
+      float *inSlice[] = { in[0] + frame, in[1] + frame };
+      float *outSlice[] = { out[0] + frame, out[1] + frame };
+      plugin->process(inSlice, outSlice, event.processAudio.endFrame - frame, 2, 2);
     #endif
       // If your plugin does not require sample accurate processing, use this line below to break the loop
       frame = event.processAudio.endFrame;
@@ -171,6 +171,27 @@ namespace Interface
 namespace Plugin
 {
   struct State;
+  struct ComplexPlugin;
+
+  // host parameter queries read the current state through this instead of taking the processingLock,
+  // so they never wait on preset swaps; whoever replaces the state waits for readers to leave
+  // (see ComplexPlugin::waitForHostReaders) before the previous one can be released
+  class HostStateReader
+  {
+  public:
+    HostStateReader(const HostStateReader &) = delete;
+    HostStateReader &operator=(const HostStateReader &) = delete;
+
+    HostStateReader(ComplexPlugin &plugin);
+    ~HostStateReader();
+
+    State *operator->() const { return state; }
+
+  private:
+    ComplexPlugin &plugin;
+    State *state;
+    u32 slot;
+  };
 
   struct ComplexPlugin
   {
@@ -183,12 +204,28 @@ namespace Plugin
       u32 numInputs, u32 numOutputs);
 
     void rescanLatency();
+    // logs allocations/blocking locks that happened inside process() since the last call
+    // returns how many were reported, only meaningful with COMPLEX_AUDIO_THREAD_GUARD
+    usize reportAudioThreadViolations();
 
     float getSampleRate() const { return sampleRate.load(satomi::memory_order_acquire); }
     u32 getSamplesPerBlock() const { return samplesPerBlock.load(satomi::memory_order_acquire); }
 
     utils::sp<State> loadDefaultPreset();
+    // swaps the current state and starts crossfading from the previous one inside process()
     utils::sp<State> exchangeStates(utils::sp<State> state);
+    // installs what stateLoader finished building and shows the messages from building it, main thread only
+    // polled from the ui's events and before anything that needs the latest requested state
+    void installLoadedState();
+    // makes state_ visible to HostStateReaders, done while holding the processingLock so that swaps publish in order
+    // the readers that could have read the previous state are waited for with waitForHostReaders after letting go of it
+    void publishState() { hostState.store(state_.get()); }
+    // moves HostStateReaders to the next epoch and waits for the ones registered in the previous epoch to leave
+    // a reader can register in a parity just as it stops being current, so it's only guaranteed to be gone
+    // after the flip that follows, anything replaced has to outlive 2 flips before it's released
+    // returns the epoch after the flip
+    u32 waitForHostReaders();
+    HostStateReader readStateForHost() { return HostStateReader{ *this }; }
 
     Framework::FFT *
     getFFTConverter(u32 minOrder, u32 maxOrder)
@@ -199,9 +236,10 @@ namespace Plugin
 
     // quick and dirty spinlock to ensure things are executed outside of an audio callback
     utils::ScopedLock
-    acquireProcessingLock(bool isExclusive = true)
+    acquireProcessingLock(bool isExclusive = true,
+      utils::sourceLocation location = utils::sourceLocation::current())
     {
-      return utils::ScopedLock{ processingLock, isExclusive, utils::WaitMechanism::Sleep };
+      return utils::ScopedLock{ processingLock, isExclusive, utils::WaitMechanism::Sleep, location };
     }
 
     // not atomic because these are only set at plugin instantiation
@@ -219,16 +257,69 @@ namespace Plugin
     mutable utils::ReentrantLock<i32> processingLock{ 0, {} };
     satomi::atomic<u32> latency{};
     satomi::atomic<bool> hasLatencyChanged{};
+    // schedules output to be only FFT size samples late, instead of keeping extra host blocks as margin
+    // the new latency is reported to the host from the next process call
+    satomi::atomic<bool> isLowLatency{};
+    // render quality switch for bounces, there's no deadline so every block that can be performed is performed
+    // in the callback its input arrives in, effects use their accurate math and the spectrogram isn't fed
+    satomi::atomic<bool> isRenderingOffline{};
     bool wasStateInitialised{};
+    // page faults that happened inside process(), for benchmarking
+    // only counted while countPageFaults is set because querying them is a syscall
+    satomi::atomic<bool> countPageFaults{};
+    satomi::atomic<u64> processPageFaults{};
 
     Framework::FFT fft{};
     utils::sp<State> state_;
 
+    // raw copy of state_ for HostStateReaders, readers register in the counter of the current epoch's parity
+    satomi::atomic<State *> hostState{};
+    satomi::atomic<u32> hostReaderEpoch{};
+    satomi::atomic<u32> hostReaders[2]{};
+    // flips from different threads would each only wait for their own parity
+    satomi::atomic<bool> hostEpochLock{};
+
+    // the previous state is kept alive and processed alongside the new one while it's being faded out,
+    // the fade only starts once the new one is primed (see SoundEngine::isPrimed) and the previous one is heard until then
+    // all of these are set up by exchangeStates while holding the processingLock
+    static constexpr float kStateCrossfadeSeconds = 0.02f;
+    utils::sp<State> retiringState_;
+    State *fadingState{};
+    bool isFadeStarting{};
+    // how long the new state has been primed for
+    u32 fadePrimedSamples{};
+    u32 fadePosition{};
+    u32 fadeLength{};
+    // output of the fading state, sized in initialise
+    float **fadeOutputs{};
+    u32 fadeChannels{};
+    u32 fadeBufferSize{};
+    // while fading, the output of the state with the lower processing delay is delayed by the difference
+    // so that both line up, outside of fades it records the output so that the outgoing state's can be continued
+    // positive delays are the fading state's, negative ones the new state's
+    static constexpr u32 kMaxFadeDelay = 2U << kMaxFFTOrder;
+    float **fadeDelayLines{};
+    u32 fadeDelayLineSize{};
+    u32 fadeDelayPosition{};
+    i32 fadeDelay{};
+
     Framework::UndoManager undoManager;
 
     CplugHostContext *hostContext;
 
     Interface::Renderer renderer;
+
+    // what stateLoader built, only written by it before hasLoadedState is set
+    // and only read by the main thread after hasLoadedState is cleared
+    utils::sp<State> loadedState_;
+    utils::string loadMessages_{};
+    Interface::MessageBoxType loadMessagesType_{};
+    bool loadedWasInitialised_{};
+    satomi::atomic<bool> hasLoadedState{};
+
+    // presets are deserialised on this thread, starting a new load joins the previous one
+    // it's last so that it's joined before anything else is destroyed
+    utils::thread stateLoader{};
   };
 }
 
@@ -270,16 +361,18 @@ namespace Plugin
     {
       Thread() = default;
       Thread(Thread &&other) noexcept : thread{ COMPLEX_MOVE(other.thread) },
-        shouldStop{ other.shouldStop } { }
+        wake{ COMPLEX_MOVE(other.wake) }, shouldStop{ other.shouldStop } { }
       ~Thread() { stop(); }
 
+      // wakeFunction is called after shouldStop is set, for workers that block while waiting for work
       bool
-      start(const auto &function)
+      start(const auto &function, utils::smallFn<void()> wakeFunction = {})
       {
         if (thread != utils::thread{})
           return false;
 
         shouldStop = anew(globalArena, satomi::atomic<bool>, {});
+        wake = COMPLEX_MOVE(wakeFunction);
 
         thread = [shouldStop = shouldStop, function]() { function(*shouldStop); };
         return true;
@@ -291,13 +384,19 @@ namespace Plugin
         if (thread == utils::thread{})
           return true;
 
-        shouldStop->store(false, satomi::memory_order_release);
+        shouldStop->store(true, satomi::memory_order_release);
+        if (wake)
+          wake();
         bool success = thread.join(exitCode);
+        wake = nullptr;
+        thread.threadId = {};
         utils::bumpArena::remove(shouldStop);
+        shouldStop = nullptr;
         return success;
       }
 
       utils::thread thread{};
+      utils::smallFn<void()> wake{};
       utils::typeInfo reservationTag{};
       satomi::atomic<bool> *shouldStop{};
     };
@@ -328,6 +427,9 @@ namespace Plugin
     utils::vectormap<u64, Generation::Processor *> allProcessors{};
 
     utils::vectormap<uuid, Framework::IndexedData *> dynamicOptions{};
+    // replaced bridge descriptors and the host reader epoch they were replaced in,
+    // see ParameterBridge::publishDescriptor
+    utils::vectornd<utils::pair<u32, const Framework::ParameterBridgeDescriptor *>> retiredDescriptors{};
 
     utils::vectormap<utils::string_view, void *> cachedHotreloadSymbols{};
     Framework::PluginStructure pluginStructure{};
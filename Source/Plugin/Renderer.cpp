@@ -117,7 +117,9 @@ namespace Interface
 
     COMPLEX_ASSERT(renderer->view_ == view);
 
+    renderer->plugin.installLoadedState();
     renderer->plugin.rescanLatency();
+    renderer->plugin.reportAudioThreadViolations();
 
     if (!renderer->isInitialised || renderer->area.w == 0 || renderer->area.h == 0)
     {
@@ -0,0 +1,2479 @@
+// Created: 2026-10-18 16:02:11
+
+// self tests and benchmarks for complex-render (`complex-render --test`, `complex-render --benchmark`)
+// included after CommandLine.cpp so that they go through the same rendering path as the files do
+//
+// tests print their failures and make the process return non-zero, benchmarks only print timings
+// a test also fails if the audio thread guard caught something while it ran
+
+namespace
+{
+  constexpr u32 kTestSampleRate = 44100;
+
+  struct TestContext
+  {
+    const char *name{};
+    u32 checks = 0;
+    u32 failures = 0;
+    // violations the test records on purpose, they don't count as failures
+    u64 expectedViolations = 0;
+
+    template<typename ... Args>
+    bool check(bool condition, const char *format, const Args &... args)
+    {
+      ++checks;
+      if (condition)
+        return true;
+
+      ++failures;
+      char message[512];
+      (void)stbsp_snprintf(message, (int)sizeof(message), format, args...);
+      ::fprintf(stderr, "  %s failed: %s\n", name, message);
+      return false;
+    }
+  };
+
+  struct BenchmarkContext
+  {
+    static constexpr u64 kMinMicroseconds = 250'000;
+
+    const char *name{};
+
+    // calls function until at least kMinMicroseconds have passed and prints the average time of a call
+    // itemsPerCall is used to also print the time per item (sample, bin, byte etc.)
+    void measure(const char *label, const auto &function, u64 itemsPerCall = 1, const char *itemName = nullptr)
+    {
+      // warming up caches, page faults and lazily built tables
+      function();
+
+      u64 calls = 0;
+      u64 start = utils::getMonotonicMicroseconds();
+      u64 elapsed = 0;
+      do
+      {
+        function();
+        ++calls;
+        elapsed = utils::getMonotonicMicroseconds() - start;
+      } while (elapsed < kMinMicroseconds);
+
+      double nsPerCall = (double)elapsed * 1000.0 / (double)calls;
+      char message[512];
+      if (itemName)
+        (void)stbsp_snprintf(message, (int)sizeof(message), "  %-40s %12.1f ns/call %10.3f ns/%s\n",
+          label, nsPerCall, nsPerCall / (double)itemsPerCall, itemName);
+      else
+        (void)stbsp_snprintf(message, (int)sizeof(message), "  %-40s %12.1f ns/call\n", label, nsPerCall);
+      ::fputs(message, stdout);
+    }
+  };
+
+  // deterministic white noise so that failures can be reproduced
+  struct TestNoise
+  {
+    u32 state = 0x9E3779B9;
+
+    float next()
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return (float)(state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    }
+  };
+
+  // stereo float input that lives in memory, owned by the caller
+  WavFile createTestInput(float *interleaved, u64 frames)
+  {
+    WavFile input{};
+    input.samples = (const byte *)interleaved;
+    input.frames = frames;
+    input.sampleRate = kTestSampleRate;
+    input.channels = 2;
+    input.bytesPerSample = sizeof(float);
+    input.format = kWaveFloat;
+    return input;
+  }
+
+  // renders into a temporary file and returns its contents, allocated from arena
+  utils::span<byte> renderToMemory(Plugin::ComplexPlugin *plugin, RenderSettings &settings,
+    const WavFile &input, utils::bumpArena *arena)
+  {
+    WavWriter writer{};
+    if (!writer.open(::tmpfile(), input.sampleRate))
+      return {};
+    defer{ ::fclose(writer.file); };
+
+    if (renderFile(plugin, settings, input, writer))
+      return {};
+
+    if (::fseek(writer.file, 0, SEEK_END) != 0)
+      return {};
+    long size = ::ftell(writer.file);
+    if (size <= 0 || ::fseek(writer.file, 0, SEEK_SET) != 0)
+      return {};
+
+    byte *data = arranew(arena, byte, (usize)size);
+    if (::fread(data, 1, (usize)size, writer.file) != (usize)size)
+    {
+      utils::bumpArena::remove(data);
+      return {};
+    }
+    return { data, (usize)size };
+  }
+
+  // what picking an effect type in a module's ui does
+  // the module type parameter is moved along with the effect so that saves record the selected one
+  Generation::EffectData *selectEffect(Generation::EffectModule *module, uuid effectTypeId)
+  {
+    auto *moduleType = module->getParameter(Generation::EffectModule::ModuleType);
+    auto details = moduleType->getParameterDetails();
+    double value = Framework::getValueFromOptionId(effectTypeId, details);
+    float normalisedValue = (float)Framework::unscaleValue(value, details, (float)kTestSampleRate);
+    moduleType->updateNormalisedValue(&normalisedValue);
+    moduleType->updateValue((float)kTestSampleRate);
+
+    auto [option, _] = Framework::getOptionFromValue(value, details);
+    return module->changeEffect(option);
+  }
+
+  // a single effect module run directly on a spectrum, outside of the engine
+  // the module comes from a default state so that its parameters are the real ones
+  struct EffectHarness
+  {
+    static constexpr u32 kBinCount = (1U << 12) / 2 + 1;
+
+    Plugin::ComplexPlugin *plugin{};
+    Generation::EffectModule *module{};
+    Generation::EffectData *effectData{};
+    Framework::SimdBuffer *input{};
+    Framework::SimdBuffer *output{};
+    Framework::ComplexDataSource source{};
+
+    void create(uuid effectTypeId)
+    {
+      plugin = createRenderPlugin(0);
+      plugin->initialise((float)kTestSampleRate, 1024);
+      Plugin::loadStateImmediately(plugin, {});
+
+      module = (Generation::EffectModule *)plugin->state_->createProcessor(Generation::Processors::EffectModule);
+      effectData = selectEffect(module, effectTypeId);
+
+      input = Framework::SimdBuffer::create(globalArena, utils::kChannelsPerInOut, kBinCount);
+      output = Framework::SimdBuffer::create(globalArena, utils::kChannelsPerInOut, kBinCount);
+      source.sourceBuffer = input;
+      source.scratchBuffer = Framework::SimdBuffer::create(globalArena, utils::kChannelsPerInOut, kBinCount);
+      source.powerBuffer = Framework::SimdBuffer::create(globalArena, utils::kChannelsPerInOut, kBinCount);
+
+      // noise falling off with frequency like most material does, so that tilt has something to work against
+      TestNoise generator{};
+      auto bins = input->get();
+      for (u32 i = 0; i < kBinCount; ++i)
+      {
+        float falloff = 1.0f / (1.0f + (float)i * 0.05f);
+        for (u32 j = 0; j < simd_float::size; ++j)
+          bins[i].set(j, falloff * generator.next());
+      }
+    }
+
+    void destroy()
+    {
+      utils::bumpArena::remove(source.powerBuffer);
+      utils::bumpArena::remove(source.scratchBuffer);
+      utils::bumpArena::remove(output);
+      utils::bumpArena::remove(input);
+      plugin->state_->deleteProcessor(module);
+      destroyRenderPlugin(plugin);
+    }
+
+    static void setValue(Framework::ParameterValue *parameter, float normalisedValue)
+    {
+      // whatever the parameter is linked to overrides its value (see ParameterValue::updateValue), so it's set there too
+      auto *link = parameter->getParameterLink();
+      if (link->hostControl)
+        link->hostControl->setValue(normalisedValue);
+      else if (link->UIControl)
+        (void)link->UIControl->setValue(normalisedValue, false);
+      parameter->updateNormalisedValue(&normalisedValue);
+      parameter->updateValue((float)kTestSampleRate);
+    }
+    void setModuleValue(uuid id, float normalisedValue) { setValue(module->getParameter(id), normalisedValue); }
+    void setEffectValue(uuid id, float normalisedValue) { setValue(Generation::getParameter(effectData, id), normalisedValue); }
+
+    void run()
+    {
+      auto *runEffect = (Generation::EffectData::RunEffectFn *)effectData->metadata->vtable[Generation::EffectData::RunVtableIndex];
+      source.invalidatePowers();
+      runEffect(module, effectData, source, output, kBinCount, (float)kTestSampleRate);
+    }
+  };
+
+  // sets a parameter to a value in its own units instead of a normalised one
+  // (percentages as fractions, the way they're used internally and not the way they're displayed)
+  void setScaledValue(Framework::ParameterValue *parameter, double value)
+  {
+    auto details = parameter->getParameterDetails();
+    EffectHarness::setValue(parameter, (float)Framework::unscaleValue(value, details, (float)kTestSampleRate, false));
+  }
+
+  // inputs for Rank mode's threshold search, called directly so that every bin and bound combination is reachable
+  struct RankThresholdInput
+  {
+    u32 binCount = 0;
+    simd_float *powers{};
+    Framework::SimdBuffer *scratch{};
+    Generation::Filter::GateData *gateData{};
+
+    void create(u32 bins)
+    {
+      binCount = bins;
+      powers = arranew(globalArena, simd_float, binCount);
+      scratch = Framework::SimdBuffer::create(globalArena, utils::kChannelsPerInOut, binCount);
+      gateData = anew(globalArena, Generation::Filter::GateData, {});
+
+      // a wide dynamic range, with runs of equal powers and silent bins to produce ties
+      TestNoise generator{};
+      for (u32 i = 0; i < binCount; ++i)
+        for (u32 j = 0; j < simd_float::size; ++j)
+        {
+          i32 exponent = (i32)(40.0f * generator.next());
+          float power = utils::bit_cast<float>(((u32)(127 + exponent) << 23) | (generator.state & 0x7FFFFF));
+          if (i % 97 == 0)
+            power = 0.0f;
+          else if (i % 16 == 0 || (i >= 200 && i < 240))
+            power = 1.0f;
+          powers[i].set(j, power);
+        }
+    }
+
+    void destroy()
+    {
+      utils::bumpArena::remove(gateData);
+      utils::bumpArena::remove(scratch);
+      utils::bumpArena::remove(powers);
+    }
+
+    simd_float run(simd_int lowIndices, simd_int highIndices, simd_float slopeMultiplier, simd_float keepFraction) const
+    {
+      return Generation::getRankThreshold({ powers, binCount }, scratch,
+        Generation::getBoundsSpans(lowIndices, highIndices, binCount), lowIndices, highIndices,
+        slopeMultiplier, keepFraction, gateData->rankHistograms);
+    }
+  };
+
+  // heapsort into descending order, the reference that rank selection is checked and timed against
+  void sortDescending(float *values, u32 count)
+  {
+    auto siftDown = [values](u32 root, u32 end)
+    {
+      while (true)
+      {
+        u32 child = 2 * root + 1;
+        if (child >= end)
+          break;
+        if (child + 1 < end && values[child + 1] < values[child])
+          ++child;
+        if (!(values[child] < values[root]))
+          break;
+
+        float temp = values[child];
+        values[child] = values[root];
+        values[root] = temp;
+        root = child;
+      }
+    };
+
+    // min-heap, so that every extracted minimum lands at the back
+    for (u32 i = count / 2; i > 0; --i)
+      siftDown(i - 1, count);
+    for (u32 end = count; end > 1; --end)
+    {
+      float temp = values[0];
+      values[0] = values[end - 1];
+      values[end - 1] = temp;
+      siftDown(0, end - 1);
+    }
+  }
+
+  // adds effect modules of every type to the first lane, so that the state's saves get larger
+  void addEffectModules(Plugin::ComplexPlugin *plugin, u32 count)
+  {
+    constexpr uuid kEffectTypes[] =
+    {
+      Generation::Filter::Types::Normal, Generation::Filter::Types::Gate,
+      Generation::Dynamics::Types::Contrast, Generation::Dynamics::Types::Clip,
+      Generation::Phase::Types::Shift, Generation::Pitch::Types::Resample,
+      Generation::Pitch::Types::FrequencyShift, Generation::Freeze::Types::Rolling, Generation::Destroy::Types::Reinterpret,
+    };
+
+    Generation::Processor *lane = nullptr;
+    for (auto &[id, processor] : plugin->state_->allProcessors.data)
+      if (processor->metadata->id == Generation::Processors::EffectsLane)
+      {
+        lane = processor;
+        break;
+      }
+
+    for (u32 i = 0; i < count; ++i)
+    {
+      auto *module = (Generation::EffectModule *)plugin->state_->createProcessor(Generation::Processors::EffectModule);
+      (void)selectEffect(module, kEffectTypes[i % countof(kEffectTypes)]);
+      lane->addChildProcessor(*module);
+      plugin->state_->registerProcessorForDynamicParameters(module);
+    }
+  }
+
+  // the writeProc handed to saveState, keeps everything that was written
+  struct SaveCollector
+  {
+    utils::vector<u8> bytes{ globalArena, COMPLEX_KB(64) };
+    usize calls = 0;
+    usize largestCall = 0;
+
+    static i64 write(const void *stateCtx, void *data, usize size)
+    {
+      auto *self = (SaveCollector *)stateCtx;
+      ::memcpy(self->bytes.pushBack(size), data, size);
+      ++self->calls;
+      self->largestCall = utils::max(self->largestCall, size);
+      return (i64)size;
+    }
+
+    utils::string_view view() const { return { (const char *)bytes.data(), bytes.size() }; }
+  };
+
+  //===========================================================================================
+  // Tests
+  //
+  // instances don't share any processing state, so a file rendered while others are being rendered
+  // has to come out byte for byte the same as when it's rendered alone (which is what --jobs relies on)
+  void testRenderDeterminism(TestContext &context)
+  {
+    constexpr u64 kFrames = 3 * kTestSampleRate;
+    constexpr u32 kBlockSize = 1024;
+    u32 jobs = utils::clamp(utils::getProcessorCount(), 2U, 8U);
+
+    float *noise = arranew(globalArena, float, kFrames * 2);
+    defer{ utils::bumpArena::remove(noise); };
+    TestNoise generator{};
+    for (u64 i = 0; i < kFrames * 2; ++i)
+      noise[i] = 0.5f * generator.next();
+
+    WavFile input = createTestInput(noise, kFrames);
+    RenderSettings settings{};
+    settings.blockSize = kBlockSize;
+
+    auto render = [&]()
+    {
+      utils::ScopedNoDenormals noDenormals{};
+      auto *plugin = createRenderPlugin(0);
+      auto output = renderToMemory(plugin, settings, input, globalArena);
+      destroyRenderPlugin(plugin);
+      return output;
+    };
+
+    auto reference = render();
+    if (!context.check(!reference.empty(), "rendering on a single job failed"))
+      return;
+    defer{ utils::bumpArena::remove(reference.data()); };
+
+    auto *outputs = arranew(globalArena, utils::span<byte>, jobs, {});
+    {
+      auto *workers = arranew(globalArena, utils::thread, jobs, {});
+      for (u32 i = 0; i < jobs; ++i)
+        workers[i] = [&, i]() { outputs[i] = render(); };
+      for (u32 i = jobs; i > 0; --i)
+        workers[i - 1].~thread();
+      utils::bumpArena::remove(workers);
+    }
+
+    for (u32 i = 0; i < jobs; ++i)
+    {
+      if (context.check(!outputs[i].empty(), "rendering on job %u of %u failed", i + 1, jobs))
+      {
+        context.check(outputs[i].size() == reference.size() &&
+          __builtin_memcmp(outputs[i].data(), reference.data(), reference.size()) == 0,
+          "job %u of %u rendered a different output than a single job", i + 1, jobs);
+        utils::bumpArena::remove(outputs[i].data());
+      }
+    }
+    utils::bumpArena::remove(outputs);
+  }
+
+  // renderFile drops as many samples as the plugin reports as its latency,
+  // so an impulse has to come out at the same position it went in
+  void testReportedLatency(TestContext &context)
+  {
+    constexpr u64 kFrames = kTestSampleRate;
+    constexpr u64 kImpulsePosition = 10000;
+    // powers of 2 below, equal to and above the default FFT size and a few that don't divide it
+    constexpr u32 kBlockSizes[] = { 64, 256, 1000, 1024, 3000, 4096, 5000, 8192, 16384 };
+
+    float *impulse = arranew(globalArena, float, kFrames * 2, {});
+    defer{ utils::bumpArena::remove(impulse); };
+    impulse[kImpulsePosition * 2] = 1.0f;
+    impulse[kImpulsePosition * 2 + 1] = 1.0f;
+    WavFile input = createTestInput(impulse, kFrames);
+
+    utils::ScopedNoDenormals noDenormals{};
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+
+    constexpr bool kModes[] = { false, true };
+    for (bool isLowLatency : kModes)
+    {
+      plugin->isLowLatency.store(isLowLatency, satomi::memory_order_relaxed);
+      for (u32 blockSize : kBlockSizes)
+      {
+        RenderSettings settings{};
+        settings.blockSize = blockSize;
+
+        auto output = renderToMemory(plugin, settings, input, globalArena);
+        if (!context.check(output.size() >= WavWriter::kHeaderSize + kFrames * 2 * sizeof(float),
+          "rendering with block size %u failed", blockSize))
+          continue;
+
+        u64 peakPosition = 0;
+        float peak = 0.0f;
+        for (u64 i = 0; i < kFrames; ++i)
+        {
+          float sample = readLittleEndian<float>(output.data() + WavWriter::kHeaderSize + i * 2 * sizeof(float));
+          if (::fabsf(sample) > peak)
+          {
+            peak = ::fabsf(sample);
+            peakPosition = i;
+          }
+        }
+        utils::bumpArena::remove(output.data());
+
+        u32 reportedLatency = plugin->latency.load(satomi::memory_order_relaxed);
+        context.check(peak > 0.5f && peakPosition == kImpulsePosition,
+          "%s mode, block size %u: impulse came out %lli samples off (reported latency %u, peak %f)",
+          (isLowLatency) ? "low latency" : "normal", blockSize,
+          (long long)peakPosition - (long long)kImpulsePosition, reportedLatency, (double)peak);
+      }
+    }
+  }
+
+  // offline renders batch the blocks and run effects at their accurate tier, realtime ones don't,
+  // yet the same preset has to come out of both at the same positions and only differing by the tiers' errors
+  //
+  // realtime frames are windowed without their table until a worker builds it and are normalised
+  // by the average overlapping sum meanwhile, how many that are depends on timing so they're held to a looser bound
+  void testOfflineMatchesRealtime(TestContext &context)
+  {
+    using namespace Generation;
+    constexpr u64 kFrames = 2 * kTestSampleRate;
+    constexpr u32 kBlockSizes[] = { 256, 1000, 4096 };
+    // relative to the output's peak, the fast tiers' gains are off by parts in 10^4 at most
+    constexpr float kTolerance = 1e-3f;
+    constexpr float kFallbackTolerance = 1e-2f;
+    // by then the table has long been built
+    constexpr u64 kSettledFrames = kFrames / 2;
+
+    float *noise = arranew(globalArena, float, kFrames * 2);
+    defer{ utils::bumpArena::remove(noise); };
+    TestNoise generator{};
+    for (u64 i = 0; i < kFrames * 2; ++i)
+      noise[i] = 0.5f * generator.next();
+    WavFile input = createTestInput(noise, kFrames);
+
+    utils::ScopedNoDenormals noDenormals{};
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+    plugin->initialise((float)kTestSampleRate, kBlockSizes[0]);
+    Plugin::loadStateImmediately(plugin, {});
+
+    // effects whose realtime tiers differ from the offline ones, saved into a preset that both renders load
+    Processor *lane = nullptr;
+    for (auto &[id, processor] : plugin->state_->allProcessors.data)
+      if (processor->metadata->id == Processors::EffectsLane)
+      {
+        lane = processor;
+        break;
+      }
+    auto addModule = [&](uuid effectTypeId)
+    {
+      auto *module = (EffectModule *)plugin->state_->createProcessor(Processors::EffectModule);
+      auto *effectData = selectEffect(module, effectTypeId);
+      lane->addChildProcessor(*module);
+      plugin->state_->registerProcessorForDynamicParameters(module);
+      return effectData;
+    };
+    auto *filter = addModule(Filter::Types::Normal);
+    EffectHarness::setValue(getParameter(filter, Filter::Normal::Gain), 0.7f);
+    EffectHarness::setValue(getParameter(filter, Filter::Normal::Cutoff), 0.4f);
+    auto *gate = addModule(Filter::Types::Gate);
+    EffectHarness::setValue(getParameter(gate, Filter::Gate::Threshold), 0.3f);
+    EffectHarness::setValue(getParameter(gate, Filter::Gate::Tilt), 0.6f);
+    auto *contrast = addModule(Dynamics::Types::Contrast);
+    EffectHarness::setValue(getParameter(contrast, Dynamics::Contrast::Depth), 0.7f);
+
+    SaveCollector preset{};
+    Plugin::saveState(plugin, &preset, SaveCollector::write, false);
+
+    for (u32 blockSize : kBlockSizes)
+    {
+      RenderSettings settings{};
+      settings.preset = preset.view();
+      settings.blockSize = blockSize;
+
+      plugin->isRenderingOffline.store(true, satomi::memory_order_relaxed);
+      auto offline = renderToMemory(plugin, settings, input, globalArena);
+      plugin->isRenderingOffline.store(false, satomi::memory_order_relaxed);
+      auto realtime = renderToMemory(plugin, settings, input, globalArena);
+      defer
+      {
+        if (!realtime.empty())
+          utils::bumpArena::remove(realtime.data());
+        if (!offline.empty())
+          utils::bumpArena::remove(offline.data());
+      };
+
+      usize expectedSize = WavWriter::kHeaderSize + kFrames * 2 * sizeof(float);
+      if (!context.check(offline.size() >= expectedSize && realtime.size() >= expectedSize,
+        "block size %u: rendering failed", blockSize))
+        continue;
+
+      // the largest differences before and after the frames have settled
+      float peak = 0.0f, maxDifferences[2]{};
+      u64 worstPositions[2]{};
+      for (u64 i = 0; i < kFrames * 2; ++i)
+      {
+        float offlineSample = readLittleEndian<float>(offline.data() + WavWriter::kHeaderSize + i * sizeof(float));
+        float realtimeSample = readLittleEndian<float>(realtime.data() + WavWriter::kHeaderSize + i * sizeof(float));
+        peak = utils::max(peak, ::fabsf(offlineSample));
+
+        u32 isSettled = i / 2 >= kSettledFrames;
+        if (float difference = ::fabsf(offlineSample - realtimeSample); difference > maxDifferences[isSettled])
+        {
+          maxDifferences[isSettled] = difference;
+          worstPositions[isSettled] = i / 2;
+        }
+      }
+
+      if (!context.check(peak > 0.1f, "block size %u: output peaks at %f only", blockSize, (double)peak))
+        continue;
+      context.check(maxDifferences[0] <= kFallbackTolerance * peak,
+        "block size %u: offline and realtime renders differ by %g at sample %llu (peak %f)",
+        blockSize, (double)maxDifferences[0], (unsigned long long)worstPositions[0], (double)peak);
+      context.check(maxDifferences[1] <= kTolerance * peak,
+        "block size %u: offline and realtime renders differ by %g at sample %llu once settled (peak %f)",
+        blockSize, (double)maxDifferences[1], (unsigned long long)worstPositions[1], (double)peak);
+    }
+  }
+
+  // every instance drains the guard's log from its own ui thread while the audio threads keep recording,
+  // so concurrent drains have to hand out each violation exactly once, including ones recorded during the drain
+  void testAudioThreadGuardDrain(TestContext &context)
+  {
+    using utils::AudioThreadGuard;
+    constexpr usize kEntries = AudioThreadGuard::kLogSize;
+    constexpr u32 kReaders = 4;
+    constexpr u32 kWriters = 4;
+    // entries are only lost when they're read while being written, which needs a few tries to line up
+    constexpr u32 kConcurrentRounds = 64;
+
+    AudioThreadGuard::Violation discarded[16];
+    while (AudioThreadGuard::drain(discarded)) { }
+
+    auto *drained = arranew(globalArena, AudioThreadGuard::Violation, kReaders * kEntries, {});
+    defer{ utils::bumpArena::remove(drained); };
+    auto *readers = arranew(globalArena, utils::thread, kReaders, {});
+    auto *writers = arranew(globalArena, utils::thread, kWriters, {});
+    defer
+    {
+      utils::bumpArena::remove(writers);
+      utils::bumpArena::remove(readers);
+    };
+
+    // waitUs tells the entries apart, writerCount of 0 means that everything is recorded before draining starts
+    auto run = [&](u32 writerCount, const char *name)
+    {
+      usize drainedCounts[kReaders]{};
+      satomi::atomic<bool> start = false;
+      satomi::atomic<u32> writersLeft = writerCount;
+
+      auto drainAll = [&](u32 i)
+      {
+        // small destinations so that the readers interleave
+        while (usize count = AudioThreadGuard::drain({ drained + i * kEntries + drainedCounts[i],
+          utils::min((usize)3, kEntries - drainedCounts[i]) }))
+          drainedCounts[i] += count;
+      };
+
+      if (!writerCount)
+        for (usize i = 0; i < kEntries; ++i)
+          AudioThreadGuard::record(AudioThreadGuard::LongLockWait, utils::sourceLocation::current(), i);
+      context.expectedViolations += kEntries;
+
+      for (u32 i = 0; i < writerCount; ++i)
+        writers[i] = [&, i]()
+        {
+          start.wait(false, satomi::memory_order_acquire);
+          for (usize j = i; j < kEntries; j += writerCount)
+            AudioThreadGuard::record(AudioThreadGuard::LongLockWait, utils::sourceLocation::current(), j);
+          writersLeft.fetch_sub(1, satomi::memory_order_release);
+        };
+      for (u32 i = 0; i < kReaders; ++i)
+        readers[i] = [&, i]()
+        {
+          start.wait(false, satomi::memory_order_acquire);
+          // the last pass starts after every entry was published, so it picks up whatever is left
+          bool isLastPass;
+          do
+          {
+            isLastPass = writersLeft.load(satomi::memory_order_acquire) == 0;
+            drainAll(i);
+          } while (!isLastPass);
+        };
+      start.store(true, satomi::memory_order_release);
+      start.notify_all();
+      for (u32 i = kReaders; i > 0; --i)
+        readers[i - 1] = utils::thread{};
+      for (u32 i = writerCount; i > 0; --i)
+        writers[i - 1] = utils::thread{};
+
+      u32 timesSeen[kEntries]{};
+      usize total = 0;
+      for (u32 i = 0; i < kReaders; ++i)
+      {
+        total += drainedCounts[i];
+        for (usize j = 0; j < drainedCounts[i]; ++j)
+        {
+          u64 marker = drained[i * kEntries + j].waitUs;
+          if (context.check(marker < kEntries, "%s: drained an entry that wasn't recorded (%llu)", name, (unsigned long long)marker))
+            ++timesSeen[marker];
+        }
+      }
+
+      bool isCorrect = context.check(total == kEntries, "%s: drained %zu entries, %zu were recorded", name, total, kEntries);
+      for (usize i = 0; i < kEntries; ++i)
+        if (!context.check(timesSeen[i] == 1, "%s: entry %zu was drained %u times", name, i, timesSeen[i]))
+          return false;
+      return isCorrect;
+    };
+
+    (void)run(0, "recorded before draining");
+    for (u32 i = 0; i < kConcurrentRounds; ++i)
+      if (!run(kWriters, "recorded while draining"))
+        break;
+  }
+
+  // rank mode's histogram selection against sorting the tilted powers,
+  // the threshold may only be off by the low bits that the selection ignores
+  void testRankThreshold(TestContext &context)
+  {
+    constexpr u32 kBinCount = EffectHarness::kBinCount;
+
+    RankThresholdInput input{};
+    input.create(kBinCount);
+    defer{ input.destroy(); };
+
+    float *sorted = arranew(globalArena, float, kBinCount);
+    defer{ utils::bumpArena::remove(sorted); };
+
+    struct { const char *name; u32 low[2], high[2]; } bounds[] =
+    {
+      { "whole spectrum", { 0, 0 }, { kBinCount - 1, kBinCount - 1 } },
+      { "range 300-1500", { 300, 300 }, { 1500, 1500 } },
+      { "wrapped range 1500-300", { 1500, 1500 }, { 300, 300 } },
+      { "stereo ranges", { 100, 1700 }, { 900, 200 } },
+    };
+    constexpr float kSlopeMultipliers[] = { 1.0f, 0.999f, 1.0005f };
+    constexpr float kFractions[] = { 0.0f, 0.01f, 0.25f, 0.5f, 0.9f, 1.0f };
+
+    auto isInRange = [](u32 index, u32 low, u32 high)
+    { return (low <= high) ? (index >= low && index <= high) : (index >= low || index <= high); };
+
+    for (auto &bound : bounds)
+    {
+      simd_int lowIndices{ { bound.low[0], bound.low[0], bound.low[1], bound.low[1] } };
+      simd_int highIndices{ { bound.high[0], bound.high[0], bound.high[1], bound.high[1] } };
+      bool isStereo = Generation::getBoundsSpans(lowIndices, highIndices, kBinCount).isStereo;
+
+      for (float slopeMultiplier : kSlopeMultipliers)
+      {
+        for (usize f = 0; f < countof(kFractions); ++f)
+        {
+          // channels get different fractions so that they can't be mixed up
+          float fractions[] = { kFractions[f], kFractions[(f + 3) % countof(kFractions)] };
+          simd_float threshold = input.run(lowIndices, highIndices, slopeMultiplier,
+            simd_float{ { fractions[0], fractions[0], fractions[1], fractions[1] } });
+          auto rawScratch = input.scratch->get();
+
+          for (u32 j = 0; j < utils::kChannelsPerInOut; ++j)
+          {
+            // the tilted powers left in scratch are the keys the selection worked on, they're sorted as is
+            // but they're also checked against tilting done here so that a wrong tilt or bound doesn't go unnoticed
+            u32 count = 0;
+            bool isScratchValid = true;
+            for (u32 i = 0; i < kBinCount; ++i)
+            {
+              float key = rawScratch[i][2 * j];
+              if (!isInRange(i, bound.low[j], bound.high[j]))
+              {
+                if (isStereo)
+                  isScratchValid &= (utils::bit_cast<u32>(key) & utils::kSignMask) != 0;
+                continue;
+              }
+
+              double expected = (double)input.powers[i][2 * j] * ::pow((double)slopeMultiplier, 2.0 * (double)i);
+              // the slope at the start of a span comes from the approximate pow
+              isScratchValid &= ::fabs((double)key - expected) <= 5e-3 * expected;
+              sorted[count++] = key;
+            }
+            if (!context.check(isScratchValid, "%s, slope %f, channel %u: tilted powers or bounds are wrong",
+              bound.name, (double)slopeMultiplier, j))
+              continue;
+
+            sortDescending(sorted, count);
+
+            float fraction = fractions[j];
+            float result = threshold[2 * j];
+            u32 keep = (u32)((float)count * fraction + 0.5f);
+            if (keep == 0)
+            {
+              context.check(result == kFloatInf, "%s, slope %f, channel %u, fraction %f: expected inf, got %g",
+                bound.name, (double)slopeMultiplier, j, (double)fraction, (double)result);
+              continue;
+            }
+            if (keep >= count)
+            {
+              context.check(result == 0.0f, "%s, slope %f, channel %u, fraction %f: expected 0, got %g",
+                bound.name, (double)slopeMultiplier, j, (double)fraction, (double)result);
+              continue;
+            }
+
+            float cutoff = sorted[keep - 1];
+            float truncatedCutoff = utils::bit_cast<float>(utils::bit_cast<u32>(cutoff) & ~0x1FFU);
+            float squared = result * result;
+            context.check(squared >= truncatedCutoff * (1.0f - 1e-5f) && squared <= cutoff * (1.0f + 1e-5f),
+              "%s, slope %f, channel %u, fraction %f: threshold^2 %g, sorted cutoff %g (keep %u of %u)",
+              bound.name, (double)slopeMultiplier, j, (double)fraction, (double)squared, (double)cutoff, keep, count);
+          }
+        }
+      }
+    }
+  }
+
+  // consecutive pointwise modules are fused into one pass over the spectrum the way the lanes do it,
+  // which has to come out sample for sample the same as running every module on its own
+  void testKernelFusion(TestContext &context)
+  {
+    using namespace Generation;
+    constexpr u32 kBinCount = EffectHarness::kBinCount;
+
+    // rank gating can't be fused and splits the chain into two fused runs
+    struct ModuleSetup { uuid type; uuid modeId = 0; };
+    constexpr ModuleSetup kChain[] =
+    {
+      { Filter::Types::Normal }, { Filter::Types::Gate, Filter::GateMode::Decibels },
+      { Destroy::Types::Reinterpret, Destroy::ReinterpretTransformOptions::CartToPolar },
+      { Filter::Types::Gate, Filter::GateMode::Rank },
+      { Destroy::Types::Reinterpret, Destroy::ReinterpretTransformOptions::PolarToCart },
+      { Filter::Types::Gate, Filter::GateMode::Decibels }, { Filter::Types::Normal },
+    };
+
+    EffectHarness harness{};
+    harness.create(Filter::Types::Normal);
+    defer{ harness.destroy(); };
+
+    EffectModule *modules[countof(kChain)];
+    EffectData *effects[countof(kChain)];
+    for (usize i = 0; i < countof(kChain); ++i)
+    {
+      modules[i] = (EffectModule *)harness.plugin->state_->createProcessor(Processors::EffectModule);
+      effects[i] = selectEffect(modules[i], kChain[i].type);
+    }
+    defer
+    {
+      for (usize i = countof(kChain); i > 0; --i)
+        harness.plugin->state_->deleteProcessor(modules[i - 1]);
+    };
+
+    // parameters away from their defaults, so that no module is a passthrough
+    auto setOption = [](Framework::ParameterValue *parameter, uuid optionId)
+    { setScaledValue(parameter, Framework::getValueFromOptionId(optionId, parameter->getParameterDetails())); };
+    for (usize i = 0; i < countof(kChain); ++i)
+    {
+      float offset = (float)i * 0.05f;
+      if (kChain[i].type == Filter::Types::Normal)
+      {
+        EffectHarness::setValue(getParameter(effects[i], Filter::Normal::Gain), 0.7f + offset);
+        EffectHarness::setValue(getParameter(effects[i], Filter::Normal::Cutoff), 0.4f - offset);
+        EffectHarness::setValue(getParameter(effects[i], Filter::Normal::Slope), 0.6f);
+      }
+      else if (kChain[i].type == Filter::Types::Gate)
+      {
+        setOption(getParameter(effects[i], Filter::Gate::Mode), kChain[i].modeId);
+        EffectHarness::setValue(getParameter(effects[i], Filter::Gate::Threshold), 0.4f + offset);
+        EffectHarness::setValue(getParameter(effects[i], Filter::Gate::Gain), 0.8f);
+        EffectHarness::setValue(getParameter(effects[i], Filter::Gate::Tilt), 0.6f);
+      }
+      else
+      {
+        setOption(getParameter(effects[i], Destroy::Reinterpret::Transform), kChain[i].modeId);
+        EffectHarness::setValue(getParameter(effects[i], Destroy::Reinterpret::Attenuation), 0.4f);
+      }
+    }
+
+    Framework::SimdBuffer *buffers[3];
+    for (auto &buffer : buffers)
+      buffer = Framework::SimdBuffer::create(globalArena, utils::kChannelsPerInOut, kBinCount);
+    defer
+    {
+      for (usize i = countof(buffers); i > 0; --i)
+        utils::bumpArena::remove(buffers[i - 1]);
+    };
+
+    // runs one step of the chain from the harness' source into the next free buffer
+    Framework::SimdBuffer *current = nullptr;
+    auto step = [&](const auto &process)
+    {
+      auto *destination = (current == buffers[0]) ? buffers[1] : buffers[0];
+      harness.source.sourceBuffer = current ? current : harness.input;
+      harness.source.invalidatePowers();
+      process(destination);
+      current = destination;
+    };
+    auto runModule = [&](usize index, Framework::SimdBuffer *destination)
+    {
+      auto *runEffect = (EffectData::RunEffectFn *)effects[index]->metadata->vtable[EffectData::RunVtableIndex];
+      runEffect(modules[index], effects[index], harness.source, destination, kBinCount, (float)kTestSampleRate);
+    };
+
+    // a module with bounds of its own can't be fused with its neighbours
+    struct
+    {
+      const char *name;
+      float low, high;
+      u32 expectedRuns[countof(kChain)];
+      u32 otherBoundsModule = countof(kChain);
+    } cases[] =
+    {
+      { "whole spectrum", 0.0f, 1.0f, { 3, 1, 3 } },
+      { "range 0.31-0.67", 0.31f, 0.67f, { 3, 1, 3 } },
+      { "wrapped 0.67-0.31", 0.67f, 0.31f, { 3, 1, 3 } },
+      { "range 0.31-0.67, decibels gate to 0.7", 0.31f, 0.67f, { 1, 1, 1, 1, 3 }, 1 },
+    };
+    for (bool isOffline : { true, false })
+    {
+      harness.plugin->isRenderingOffline.store(isOffline, satomi::memory_order_relaxed);
+      const char *tierName = isOffline ? "offline" : "realtime";
+
+      for (auto &testCase : cases)
+      {
+        for (usize i = 0; i < countof(kChain); ++i)
+        {
+          EffectHarness::setValue(modules[i]->getParameter(EffectModule::LowBound), testCase.low);
+          EffectHarness::setValue(modules[i]->getParameter(EffectModule::HighBound),
+            (i == testCase.otherBoundsModule) ? 0.7f : testCase.high);
+        }
+
+        // every module on its own
+        current = nullptr;
+        for (usize i = 0; i < countof(kChain); ++i)
+          step([&](Framework::SimdBuffer *destination) { runModule(i, destination); });
+        // kept aside, the fused chain reuses the buffers
+        ::memcpy(buffers[2]->get(), current->get(), sizeof(simd_float) * kBinCount);
+
+        // gathered like SoundEngine::processIndividualLanes does it
+        current = nullptr;
+        u32 runs[countof(kChain)]{};
+        u32 runCount = 0;
+        for (usize i = 0; i < countof(kChain); )
+        {
+          EffectKernel kernels[EffectsLane::kMaxFusedEffects];
+          u32 kernelCount = 0;
+          for (; i + kernelCount < countof(kChain) && kernelCount < countof(kernels); ++kernelCount)
+          {
+            if (!modules[i + kernelCount]->prepareKernel(harness.source, kernels[kernelCount],
+              kBinCount, (float)kTestSampleRate))
+              break;
+            if (kernelCount && !canFuseKernels(kernels[0], kernels[kernelCount], kBinCount))
+              break;
+          }
+
+          if (kernelCount)
+            step([&](Framework::SimdBuffer *destination)
+              { runEffectKernels({ kernels, kernelCount }, harness.source.sourceBuffer, destination, kBinCount); });
+          else
+          {
+            step([&](Framework::SimdBuffer *destination) { runModule(i, destination); });
+            kernelCount = 1;
+          }
+          runs[runCount++] = kernelCount;
+          i += kernelCount;
+        }
+
+        bool isFusedAsExpected = true;
+        for (u32 i = 0; i < countof(kChain); ++i)
+          isFusedAsExpected &= runs[i] == testCase.expectedRuns[i];
+        context.check(isFusedAsExpected, "%s, %s: the chain wasn't fused as expected (%u passes)",
+          tierName, testCase.name, runCount);
+
+        auto fused = current->get();
+        auto reference = buffers[2]->get();
+        u32 mismatches = 0, firstMismatch = 0;
+        for (u32 i = 0; i < kBinCount; ++i)
+          if (__builtin_memcmp(&fused[i], &reference[i], sizeof(simd_float)) != 0 && !mismatches++)
+            firstMismatch = i;
+        context.check(mismatches == 0, "%s, %s: %u bins differ from the unfused chain, the first at %u",
+          tierName, testCase.name, mismatches, firstMismatch);
+      }
+    }
+  }
+
+  // error of a float result in units of the last place of the exact result
+  double getUlpError(float approximation, double exact)
+  {
+    if (exact == 0.0)
+      return (approximation == 0.0f) ? 0.0 : kFloatInf;
+
+    // the ulp of the lowest exponents is a subnormal
+    u32 biasedExponent = (utils::bit_cast<u32>((float)::fabs(exact)) >> 23) & 0xFF;
+    double ulp = (biasedExponent > 23) ? (double)utils::bit_cast<float>((biasedExponent - 23) << 23) :
+      (double)utils::bit_cast<float>(1U << (utils::max(biasedExponent, 1U) - 1));
+    return ::fabs((double)approximation - exact) / ulp;
+  }
+
+  // documented max errors of a precision tier, in ulp of the exact result
+  struct TranscendentalBounds
+  {
+    double exp2, log2, amplitudeToDb, dbToAmplitude, invSqrt, sqrt;
+    // cis holds its bound for components down to cisSmallestComponent over [-pi, pi]
+    // and down to cisWideSmallestComponent over [-100pi, 100pi]
+    double cis;
+    float cisSmallestComponent, cisWideSmallestComponent;
+  };
+
+  // largest ulp error of a function over every normal number's bits with a stride that doesn't divide the mantissa,
+  // so that all octaves and mantissas are hit, and over every float close to a power of 2
+  double getNormalsUlpError(const auto &function, const auto &exact, float &worst)
+  {
+    constexpr u32 kLowestNormal = 0x00800000U, kHighestNormal = 0x7f7fffffU, kStride = 977, kAroundPowers = 512;
+
+    double maxError = 0.0;
+    auto check = [&](u32 bits, u32 stride)
+    {
+      simd_float values = 0.0f;
+      for (u32 j = 0; j < simd_float::size; ++j)
+        values.set(j, utils::bit_cast<float>(bits + j * stride));
+      simd_float results = function(values);
+      for (u32 j = 0; j < simd_float::size; ++j)
+        if (double error = getUlpError(results[j], exact((double)values[j])); error > maxError)
+          maxError = error, worst = values[j];
+    };
+
+    for (u32 i = kLowestNormal; i <= kHighestNormal - kStride * simd_float::size; i += kStride * simd_float::size)
+      check(i, kStride);
+    for (u32 power = kLowestNormal + kAroundPowers; power < kHighestNormal - kAroundPowers; power += kLowestNormal)
+      for (u32 i = power - kAroundPowers; i < power + kAroundPowers; i += simd_float::size)
+        check(i, 1);
+
+    return maxError;
+  }
+
+  // largest ulp error of a function over evenly spaced values in [lowest, highest]
+  double getRangeUlpError(const auto &function, const auto &exact, double lowest, double highest, float &worst)
+  {
+    constexpr u32 kSamples = 1U << 20;
+
+    double maxError = 0.0;
+    for (u32 i = 0; i < kSamples; i += simd_float::size)
+    {
+      simd_float values = 0.0f;
+      for (u32 j = 0; j < simd_float::size; ++j)
+        values.set(j, (float)(lowest + (highest - lowest) * (double)(i + j) / (double)kSamples));
+      simd_float results = function(values);
+      for (u32 j = 0; j < simd_float::size; ++j)
+        if (double error = getUlpError(results[j], exact((double)values[j])); error > maxError)
+          maxError = error, worst = values[j];
+    }
+    return maxError;
+  }
+
+  // largest ulp error of the cos/sin components of cis over [-limit, limit] whose exact value is at least smallestComponent
+  // every other angle is close to a multiple of 90 degrees, where the components get arbitrarily small
+  template<utils::MathPrecision Precision>
+  double getCisUlpError(double limit, float smallestComponent, float &worst)
+  {
+    constexpr u32 kSamples = 1U << 20, kAroundQuadrants = 1024;
+
+    double maxError = 0.0;
+    auto check = [&](float angle)
+    {
+      // lanes are paired up as { cos, sin } of the same angle
+      simd_float results = utils::cis<Precision>(angle);
+      double exact[] = { ::cos((double)angle), ::sin((double)angle) };
+      for (u32 j = 0; j < 2; ++j)
+        if (::fabs(exact[j]) >= (double)smallestComponent)
+          if (double error = getUlpError(results[j], exact[j]); error > maxError)
+            maxError = error, worst = angle;
+    };
+
+    for (u32 i = 0; i <= kSamples; ++i)
+      check((float)(-limit + 2.0 * limit * (double)i / (double)kSamples));
+    for (i32 quadrant = (i32)(-limit / (kPi * 0.5)); quadrant <= (i32)(limit / (kPi * 0.5)); ++quadrant)
+    {
+      u32 bits = utils::bit_cast<u32>((float)(quadrant * (kPi * 0.5)));
+      for (u32 i = bits - kAroundQuadrants; i < bits + kAroundQuadrants; i += kAroundQuadrants / 64)
+        check(utils::bit_cast<float>(i));
+    }
+    return maxError;
+  }
+
+  // every precision tier against libm at the error bounds written next to each function
+  // whole exponents and powers of 2 have to come out exact in every tier, pow(1, x) has to be 1
+  template<utils::MathPrecision Precision>
+  void checkTranscendentals(TestContext &context, const char *tierName, const TranscendentalBounds &bounds)
+  {
+    float worst = 0.0f;
+    double error = getRangeUlpError([](simd_float x) { return utils::exp2<Precision>(x); },
+      [](double x) { return ::pow(2.0, x); }, -126.0, 127.0, worst);
+    context.check(error <= bounds.exp2, "%s exp2: %.2f ulp at %.9g, documented %g",
+      tierName, error, (double)worst, bounds.exp2);
+
+    error = getNormalsUlpError([](simd_float x) { return utils::log2<Precision>(x); },
+      [](double x) { return ::log2(x); }, worst);
+    context.check(error <= bounds.log2, "%s log2: %.2f ulp at %.9g, documented %g",
+      tierName, error, (double)worst, bounds.log2);
+
+    error = getNormalsUlpError([](simd_float x) { return utils::amplitudeToDb<Precision>(x); },
+      [](double x) { return 20.0 * ::log10(x); }, worst);
+    context.check(error <= bounds.amplitudeToDb, "%s amplitudeToDb: %.2f ulp at %.9g, documented %g",
+      tierName, error, (double)worst, bounds.amplitudeToDb);
+
+    error = getRangeUlpError([](simd_float x) { return utils::dbToAmplitude<Precision>(x); },
+      [](double x) { return ::pow(10.0, x / 20.0); }, -120.0, 24.0, worst);
+    context.check(error <= bounds.dbToAmplitude, "%s dbToAmplitude: %.2f ulp at %.9g, documented %g",
+      tierName, error, (double)worst, bounds.dbToAmplitude);
+
+    error = getNormalsUlpError([](simd_float x) { return utils::invSqrt<Precision>(x); },
+      [](double x) { return 1.0 / ::sqrt(x); }, worst);
+    context.check(error <= bounds.invSqrt, "%s invSqrt: %.2f ulp at %.9g, documented %g",
+      tierName, error, (double)worst, bounds.invSqrt);
+
+    error = getNormalsUlpError([](simd_float x) { return utils::sqrt<Precision>(x); },
+      [](double x) { return ::sqrt(x); }, worst);
+    context.check(error <= bounds.sqrt, "%s sqrt: %.2f ulp at %.9g, documented %g",
+      tierName, error, (double)worst, bounds.sqrt);
+
+    error = getCisUlpError<Precision>(kPi, bounds.cisSmallestComponent, worst);
+    context.check(error <= bounds.cis, "%s cis: %.2f ulp at %.9g, documented %g down to %g",
+      tierName, error, (double)worst, bounds.cis, (double)bounds.cisSmallestComponent);
+    error = getCisUlpError<Precision>(100.0 * kPi, bounds.cisWideSmallestComponent, worst);
+    context.check(error <= bounds.cis, "%s cis over [-100pi, 100pi]: %.2f ulp at %.9g, documented %g down to %g",
+      tierName, error, (double)worst, bounds.cis, (double)bounds.cisWideSmallestComponent);
+
+    bool isExact = true;
+    for (i32 i = -126; i <= 127; ++i)
+    {
+      float power = utils::bit_cast<float>((u32)(i + 127) << 23);
+      isExact &= utils::exp2<Precision>(simd_float{ (float)i })[0] == power;
+      isExact &= utils::log2<Precision>(simd_float{ power })[0] == (float)i;
+    }
+    context.check(isExact, "%s: exp2/log2 aren't exact at whole exponents", tierName);
+
+    constexpr float kExponents[] = { -4096.0f, -1.5f, 0.3f, 1500.0f, 16384.0f };
+    for (float exponent : kExponents)
+    {
+      float result = utils::pow<Precision>(simd_float{ 1.0f }, exponent)[0];
+      context.check(result == 1.0f, "%s: pow(1, %g) is %.9g", tierName, (double)exponent, (double)result);
+    }
+  }
+
+  void testTranscendentalAccuracy(TestContext &context)
+  {
+    checkTranscendentals<utils::MathPrecision::Fast>(context, "fast",
+      { .exp2 = 1350.0, .log2 = 43000.0, .amplitudeToDb = 43000.0, .dbToAmplitude = 1400.0, .invSqrt = 5000.0,
+        .sqrt = 5000.0, .cis = 26.0, .cisSmallestComponent = 0x1p-15f, .cisWideSmallestComponent = 0x1p-7f });
+    checkTranscendentals<utils::MathPrecision::Medium>(context, "medium",
+      { .exp2 = 43.0, .log2 = 850.0, .amplitudeToDb = 850.0, .dbToAmplitude = 54.0, .invSqrt = 4.0,
+        .sqrt = 4.1, .cis = 2.0, .cisSmallestComponent = 0x1p-15f, .cisWideSmallestComponent = 0x1p-7f });
+    checkTranscendentals<utils::MathPrecision::Accurate>(context, "accurate",
+      { .exp2 = 2.1, .log2 = 1.5, .amplitudeToDb = 2.1, .dbToAmplitude = 12.5, .invSqrt = 1.5,
+        .sqrt = 0.5, .cis = 1.9, .cisSmallestComponent = 0.0f, .cisWideSmallestComponent = 0x1p-19f });
+  }
+
+  // binary saves go to the host in chunks, which put together have to be the same as the save that's kept in memory
+  void testStreamedBinarySave(TestContext &context)
+  {
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+    plugin->initialise((float)kTestSampleRate, 1024);
+    Plugin::loadStateImmediately(plugin, {});
+    addEffectModules(plugin, 32);
+
+    SaveCollector collector{};
+    Plugin::saveState(plugin, &collector, SaveCollector::write, false);
+
+    BinaryWriter writer{ .bytes = { globalArena, COMPLEX_KB(64) } };
+    Plugin::serialiseToBinary(plugin->state_.get(), writer);
+
+    context.check(collector.calls > 1, "a %zu byte save was written in %zu call", collector.bytes.size(), collector.calls);
+    // a chunk is cut after the first write past kFlushSize, and parameters are only a few hundred bytes
+    context.check(collector.largestCall < BinaryWriter::kFlushSize + COMPLEX_KB(1),
+      "wrote a %zu byte chunk", collector.largestCall);
+    context.check(collector.bytes.size() == writer.bytes.size() &&
+      !__builtin_memcmp(collector.bytes.data(), writer.bytes.data(), writer.bytes.size()),
+      "streamed save (%zu bytes) differs from the one in memory (%zu bytes)", collector.bytes.size(), writer.bytes.size());
+  }
+
+  // a state with modules of every type whose parameters are all moved off their defaults
+  Plugin::ComplexPlugin *createRoundTripPlugin(u32 moduleCount)
+  {
+    auto *plugin = createRenderPlugin(0);
+    plugin->initialise((float)kTestSampleRate, 1024);
+    Plugin::loadStateImmediately(plugin, {});
+    addEffectModules(plugin, moduleCount);
+
+    u32 index = 0;
+    auto setParameters = [&](Framework::ParameterValue *parameter, usize count)
+    {
+      for (usize i = 0; i < count; (++i), (parameter = parameter->next))
+        if (parameter->getParameterDetails().scale != Framework::ParameterScale::Indexed)
+          EffectHarness::setValue(parameter, (float)(++index % 7) / 7.0f);
+    };
+    for (auto &[id, processor] : plugin->state_->allProcessors.data)
+    {
+      setParameters(processor->parameters, processor->parameterCount);
+      if (processor->metadata->id == Generation::Processors::EffectModule)
+      {
+        auto *effect = ((Generation::EffectModule *)processor)->currentEffect.load(satomi::memory_order_acquire);
+        setParameters(effect->parameters, effect->parameterCount);
+      }
+    }
+
+    return plugin;
+  }
+
+  // loads data into plugin and saves what it ended up with
+  void reloadState(Plugin::ComplexPlugin *plugin, utils::string_view data, bool asJson, SaveCollector &save)
+  {
+    Plugin::loadStateImmediately(plugin, data);
+    Plugin::saveState(plugin, &save, SaveCollector::write, asJson);
+  }
+
+  bool isSameSave(const SaveCollector &first, const SaveCollector &second)
+  {
+    return first.bytes.size() == second.bytes.size() &&
+      !__builtin_memcmp(first.bytes.data(), second.bytes.data(), first.bytes.size());
+  }
+
+  // json -> binary -> json has to come out unchanged, binary -> binary as well
+  // older versions wrote their json with cjson_Print, a save like that (with an option that didn't exist yet)
+  // has to load to the same state whether it goes through binary first or not
+  void testStateRoundTrip(TestContext &context)
+  {
+    auto *plugin = createRoundTripPlugin(9);
+    defer{ destroyRenderPlugin(plugin); };
+
+    SaveCollector json{};
+    Plugin::saveState(plugin, &json, SaveCollector::write, true);
+
+    SaveCollector binary{}, jsonFromBinary{}, binaryFromBinary{};
+    reloadState(plugin, json.view(), false, binary);
+    reloadState(plugin, binary.view(), true, jsonFromBinary);
+    reloadState(plugin, binary.view(), false, binaryFromBinary);
+    context.check(isSameSave(json, jsonFromBinary), "json -> binary -> json changed the save (%zu -> %zu bytes)",
+      json.bytes.size(), jsonFromBinary.bytes.size());
+    context.check(isSameSave(binary, binaryFromBinary), "binary -> binary changed the save (%zu -> %zu bytes)",
+      binary.bytes.size(), binaryFromBinary.bytes.size());
+
+    for (bool isFormatted : { true, false })
+    {
+      char *olderJson;
+      usize olderJsonSize;
+      {
+        jsonArena = utils::bumpArena::createNested(globalArena, COMPLEX_KB(512));
+        defer
+        {
+          utils::bumpArena::destroy(jsonArena);
+          jsonArena = nullptr;
+        };
+
+        cjson *root = cjson_ParseWithOpts(json.view().data(), json.bytes.size(), nullptr, false);
+        (void)cjson_ReplaceItemInObject(root, "version", cjson_Create(cjson_String, "0.1.0"));
+        // the lane's input used to have no sidechain option
+        cjson *lane = cjson_GetArrayItem(cjson_GetObjectItem(cjson_GetArrayItem(cjson_GetObjectItem(root, "tree"), 0), "processors"), 0);
+        cjson *input = cjson_GetArrayItem(cjson_GetObjectItem(lane, "parameters"), 1);
+        cjson_DeleteItemFromArray(cjson_GetObjectItem(input, "options"), 1);
+
+        char *text = cjson_Print(root, &olderJsonSize, isFormatted);
+        olderJson = arranew(globalArena, char, olderJsonSize);
+        ::memcpy(olderJson, text, olderJsonSize);
+      }
+      defer{ utils::bumpArena::remove(olderJson); };
+
+      SaveCollector direct{}, olderBinary{}, throughBinary{};
+      reloadState(plugin, { olderJson, olderJsonSize }, true, direct);
+      reloadState(plugin, { olderJson, olderJsonSize }, false, olderBinary);
+      reloadState(plugin, olderBinary.view(), true, throughBinary);
+      context.check(isSameSave(direct, throughBinary), "%s older json loads differently through binary (%zu vs %zu bytes)",
+        (isFormatted) ? "formatted" : "unformatted", direct.bytes.size(), throughBinary.bytes.size());
+      context.check(direct.bytes.size() > olderJsonSize / 2, "%s older json didn't load (%zu bytes saved)",
+        (isFormatted) ? "formatted" : "unformatted", direct.bytes.size());
+    }
+  }
+
+  // saves nested deeper than the binary loader recurses, or in ways the processors don't allow,
+  // make the whole load fail, which leaves the default preset
+  void testBinaryNesting(TestContext &context)
+  {
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+    plugin->initialise((float)kTestSampleRate, 1024);
+
+    SaveCollector defaultSave{};
+    reloadState(plugin, {}, false, defaultSave);
+
+    auto checkFailedLoad = [&](const char *description, const SaveCollector &save)
+    {
+      SaveCollector reloaded{};
+      reloadState(plugin, save.view(), false, reloaded);
+      context.check(isSameSave(reloaded, defaultSave), "%s: a %zu byte save loaded into a %zu byte state",
+        description, save.bytes.size(), reloaded.bytes.size());
+    };
+
+    // every load replaces the state, so the lane is looked up again each time
+    auto findLane = [&]()
+    {
+      Generation::Processor *lane = nullptr;
+      for (auto &[id, processor] : plugin->state_->allProcessors.data)
+        if (processor->metadata->id == Generation::Processors::EffectsLane)
+          lane = processor;
+      return lane;
+    };
+
+    // an option from a newer version gets skipped together with its children, which are nested past the cap here
+    {
+      Framework::ParameterValue *indexed = findLane()->parameters;
+      while (indexed->getParameterDetails().scale != Framework::ParameterScale::Indexed)
+        indexed = indexed->next;
+
+      constexpr u32 kDepth = kMaxBinaryNesting + 8;
+      auto *options = arranew(globalArena, Framework::IndexedData, kDepth, {});
+      defer{ utils::bumpArena::remove(options); };
+      for (u32 i = 0; i < kDepth; ++i)
+      {
+        options[i].id = i + 1;
+        options[i].flags = Framework::IndexedData::StateIdFlag;
+        options[i].stateId = 1;
+        options[i].children = (i + 1 < kDepth) ? &options[i + 1] : nullptr;
+      }
+
+      auto *lastOption = indexed->getParameterDetails().options->children;
+      while (lastOption->next)
+        lastOption = lastOption->next;
+
+      SaveCollector nestedSave{};
+      lastOption->next = options;
+      Plugin::saveState(plugin, &nestedSave, SaveCollector::write, false);
+      lastOption->next = nullptr;
+
+      checkFailedLoad("options nested past the cap", nestedSave);
+    }
+
+    // modules inside of modules, which the ui never makes so they're linked directly
+    {
+      Generation::Processor *parent = findLane();
+      for (u32 i = 0; i < 4; ++i)
+      {
+        auto *module = (Generation::EffectModule *)plugin->state_->createProcessor(Generation::Processors::EffectModule);
+        (void)selectEffect(module, Generation::Filter::Types::Normal);
+        ++parent->childrenCount;
+        module->parent = parent;
+        utils::insertDllHalfConnected<Generation::Processor>(module, nullptr, parent->children);
+        parent = module;
+      }
+
+      SaveCollector nestedSave{};
+      Plugin::saveState(plugin, &nestedSave, SaveCollector::write, false);
+      checkFailedLoad("modules nested in modules", nestedSave);
+    }
+  }
+
+  // host queries race with remapping and renaming the bridge they ask about,
+  // the replaced descriptors have to be recycled instead of piling up in the state's storage
+  void testBridgeDescriptors(TestContext &context)
+  {
+    constexpr u32 kWarmupChanges = 16;
+    constexpr u32 kChanges = 4096;
+
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+    plugin->initialise((float)kTestSampleRate, 1024);
+    Plugin::loadStateImmediately(plugin, {});
+    addEffectModules(plugin, 1);
+
+    auto *state = plugin->state_.get();
+    Generation::Processor *module = nullptr;
+    for (auto &[id, processor] : state->allProcessors.data)
+      if (processor->metadata->id == Generation::Processors::EffectModule)
+        module = processor;
+
+    auto *indexed = module->getParameter(Generation::EffectModule::ModuleType);
+    auto *continuous = module->parameters;
+    while (continuous->getParameterDetails().scale == Framework::ParameterScale::Indexed)
+      continuous = continuous->next;
+
+    auto &bridge = state->parameterBridges[0];
+
+    // option names come from the descriptor's own copy of the options
+    {
+      bridge.resetParameterLink(indexed->getParameterLink());
+      auto details = indexed->getParameterDetails();
+      auto *descriptor = bridge.getDescriptor();
+      context.check(descriptor->details.options != details.options, "the descriptor shares the parameter's options");
+
+      char text[64];
+      bridge.getText(indexed->getNormalisedValue(), text, sizeof(text));
+      auto [option, _] = Framework::getOptionFromValue(
+        Framework::scaleValue(indexed->getNormalisedValue(), details), details);
+      context.check(option->displayName == utils::string_view{ text, utils::getStringSize(text) },
+        "the mapped option reads as \"%s\" instead of \"%.*s\"", text, (int)option->displayName.size(), option->displayName.data());
+      bridge.resetParameterLink(nullptr);
+    }
+
+    satomi::atomic<bool> stop = false;
+    u64 queries = 0;
+    usize usedAfterWarmup = 0;
+    {
+      utils::thread reader{ [&]()
+        {
+          char buffer[64];
+          double minimum, maximum;
+          while (!stop.load(satomi::memory_order_acquire))
+          {
+            cplug_parameterValueToString(plugin, 0, buffer, sizeof(buffer), (double)(queries % 11) / 10.0);
+            cplug_getParameterName(plugin, 0, buffer, sizeof(buffer));
+            cplug_getParameterRange(plugin, 0, &minimum, &maximum);
+            ++queries;
+          }
+        } };
+
+      for (u32 i = 0; i < kChanges; ++i)
+      {
+        bridge.resetParameterLink(((i & 1) ? continuous : indexed)->getParameterLink());
+        bridge.setCustomName(utils::string::create(state->miscStorage, "renamed %u", i));
+        bridge.resetParameterLink(nullptr);
+
+        if (i == kWarmupChanges)
+          usedAfterWarmup = utils::bumpArena::getUsedSize(state->miscStorage);
+      }
+
+      stop.store(true, satomi::memory_order_release);
+    }
+
+    usize used = utils::bumpArena::getUsedSize(state->miscStorage);
+    context.check(used <= usedAfterWarmup + COMPLEX_KB(4), "descriptors aren't recycled, %zu bytes in use after %u changes (%zu after %u)",
+      used, kChanges, usedAfterWarmup, kWarmupChanges);
+    context.check(queries > 0, "the host reader never ran");
+  }
+
+  // the default preset passes its input through, so a constant input comes out at the gain overlap-add leaves it with
+  // which has to be unity for every window and overlap, except where the overlapping windows sum to less than
+  // Window::kMinOverlappingSum, which isn't fully made up for and may only stay below unity
+  void testOverlapAddGain(TestContext &context)
+  {
+    using Framework::Window;
+    constexpr u32 kBlockSize = 1024;
+    constexpr u32 kFFTSamples = 1U << kDefaultFFTOrder;
+    constexpr float kLevel = 0.5f;
+    // past the latency and the first frames
+    constexpr u32 kSettleBlocks = 32;
+    constexpr u32 kMeasuredBlocks = 32;
+    // an fft round trip is only this close to the input
+    constexpr float kTolerance = 1e-5f;
+    constexpr float kOverlaps[] = { 0.0f, 0.25f, 0.5f, 0.625f, 0.75f, 0.875f, kMaxWindowOverlap };
+    constexpr uuid kWindows[] = { Window::Lerp, Window::Hann, Window::Hamming, Window::Triangle, Window::Sine,
+      Window::Rectangle, Window::Exponential, Window::HannExp, Window::Lanczos };
+    constexpr const char *kWindowNames[] = { "lerp", "hann", "hamming", "triangle", "sine",
+      "rectangle", "exponential", "hann exponential", "lanczos" };
+
+    float *frame = arranew(globalArena, float, kFFTSamples);
+    float *in[utils::kChannelsPerInOut], *out[utils::kChannelsPerInOut];
+    for (u32 i = 0; i < utils::kChannelsPerInOut; ++i)
+    {
+      in[i] = arranew(globalArena, float, kBlockSize);
+      out[i] = arranew(globalArena, float, kBlockSize);
+      for (u32 j = 0; j < kBlockSize; ++j)
+        in[i][j] = kLevel;
+    }
+    defer
+    {
+      for (u32 i = utils::kChannelsPerInOut; i > 0; --i)
+      {
+        utils::bumpArena::remove(out[i - 1]);
+        utils::bumpArena::remove(in[i - 1]);
+      }
+      utils::bumpArena::remove(frame);
+    };
+
+    utils::ScopedNoDenormals noDenormals{};
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+    plugin->initialise((float)kTestSampleRate, kBlockSize);
+
+    for (usize w = 0; w < countof(kWindows); ++w)
+    {
+      for (float overlap : kOverlaps)
+      {
+        Plugin::loadStateImmediately(plugin, {});
+        auto *engine = plugin->state_->soundEngine;
+        auto *windowType = engine->getParameter(Generation::SoundEngine::WindowType);
+        setScaledValue(windowType, Framework::getValueFromOptionId(kWindows[w], windowType->getParameterDetails()));
+        setScaledValue(engine->getParameter(Generation::SoundEngine::Overlap), overlap);
+
+        // the smallest sum of overlapping windows, windowed the way frames are before their table is ready
+        // lerp crossfades frames instead of windowing them
+        float minOverlappingSum = 1.0f;
+        if (kWindows[w] != Window::Lerp)
+        {
+          u32 hop = (u32)::floorf((float)kFFTSamples * (1.0f - overlap));
+          for (u32 i = 0; i < kFFTSamples; ++i)
+            frame[i] = 1.0f;
+          Framework::Buffer buffer{ .channels = 1, .size = kFFTSamples, .data = frame };
+          bool channels[] = { true };
+          Window window{};
+          window.applyWindow(buffer, 1, channels, kFFTSamples, kWindows[w], kAlphaLowerBound, hop);
+
+          minOverlappingSum = kFloatInf;
+          for (u32 i = 0; i < hop; ++i)
+          {
+            float overlappingSum = 0.0f;
+            for (u32 j = i; j < kFFTSamples; j += hop)
+              overlappingSum += frame[j];
+            minOverlappingSum = utils::min(minOverlappingSum, overlappingSum);
+          }
+        }
+
+        float lowestGain = kFloatInf, highestGain = 0.0f;
+        for (u32 i = 0; i < kSettleBlocks + kMeasuredBlocks; ++i)
+        {
+          plugin->process(in, out, kBlockSize, utils::kChannelsPerInOut, utils::kChannelsPerInOut);
+          if (i < kSettleBlocks)
+            continue;
+
+          for (u32 j = 0; j < utils::kChannelsPerInOut; ++j)
+            for (u32 k = 0; k < kBlockSize; ++k)
+            {
+              lowestGain = utils::min(lowestGain, out[j][k] / kLevel);
+              highestGain = utils::max(highestGain, out[j][k] / kLevel);
+            }
+        }
+
+        if (minOverlappingSum >= Window::kMinOverlappingSum)
+          context.check(lowestGain >= 1.0f - kTolerance && highestGain <= 1.0f + kTolerance,
+            "%s window, overlap %g: gain is between %.6f and %.6f", kWindowNames[w], (double)overlap,
+            (double)lowestGain, (double)highestGain);
+        else
+          context.check(highestGain <= 1.0f + kTolerance, "%s window, overlap %g: gain reaches %.6f, windows sum to %g",
+            kWindowNames[w], (double)overlap, (double)highestGain, (double)minOverlappingSum);
+      }
+    }
+  }
+
+  // a background load only builds the state, the main thread installs it together with its undo step
+  // and shows the messages from building it
+  void testBackgroundLoad(TestContext &context)
+  {
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+    plugin->initialise((float)kTestSampleRate, 1024);
+    Plugin::loadStateImmediately(plugin, {});
+
+    SaveCollector json{};
+    Plugin::saveState(plugin, &json, SaveCollector::write, true);
+
+    // a parameter missing from the save is reported while loading
+    char *brokenJson;
+    usize brokenJsonSize;
+    {
+      jsonArena = utils::bumpArena::createNested(globalArena, COMPLEX_KB(128));
+      defer
+      {
+        utils::bumpArena::destroy(jsonArena);
+        jsonArena = nullptr;
+      };
+
+      cjson *root = cjson_ParseWithOpts(json.view().data(), json.bytes.size(), nullptr, false);
+      cjson *lane = cjson_GetArrayItem(cjson_GetObjectItem(cjson_GetArrayItem(cjson_GetObjectItem(root, "tree"), 0), "processors"), 0);
+      cjson_DeleteItemFromArray(cjson_GetObjectItem(lane, "parameters"), 0);
+
+      char *text = cjson_Print(root, &brokenJsonSize, false);
+      brokenJson = arranew(globalArena, char, brokenJsonSize);
+      ::memcpy(brokenJson, text, brokenJsonSize);
+    }
+    defer{ utils::bumpArena::remove(brokenJson); };
+
+    auto *previousState = plugin->state_.get();
+    auto *previousAction = plugin->undoManager.getLastAction();
+    Plugin::loadState(plugin, { brokenJson, brokenJsonSize });
+    plugin->stateLoader = utils::thread{};
+
+    context.check(plugin->state_.get() == previousState, "the loader thread installed the state");
+    context.check(plugin->hasLoadedState.load(satomi::memory_order_acquire), "the loaded state wasn't handed over");
+    context.check(plugin->undoManager.getLastAction() == previousAction, "the loader thread added an undo step");
+    context.check(plugin->loadMessages_.find("Missing Parameter") != utils::string::npos,
+      "the loader thread's message boxes weren't collected (\"%s\")", (plugin->loadMessages_.empty()) ? "" : plugin->loadMessages_.data());
+
+    plugin->installLoadedState();
+    context.check(plugin->state_.get() != previousState && !plugin->hasLoadedState.load(satomi::memory_order_acquire),
+      "the loaded state wasn't installed");
+    context.check(plugin->loadMessages_.empty(), "the collected messages weren't shown");
+    context.check(plugin->undoManager.getLastAction() != previousAction, "installing the state didn't add an undo step");
+  }
+
+  // a preset loaded while audio is running is faded into once its state is primed, with both states' outputs lined up,
+  // so a passthrough preset has to keep outputting its input delayed by the reported latency all through the swap
+  // whether the new preset's fft size (and with it its latency) is the same, larger or smaller
+  void testStateCrossfade(TestContext &context)
+  {
+    constexpr u32 kBlockSize = 512;
+    constexpr u32 kSwapBlock = kTestSampleRate / kBlockSize;
+    constexpr u32 kBlocks = 3 * kSwapBlock;
+    constexpr u32 kOrders[] = { kDefaultFFTOrder, kDefaultFFTOrder + 2, kDefaultFFTOrder - 2 };
+    constexpr float kAmplitude = 0.5f;
+    // frames windowed before their table is built are normalised by the average overlapping sum
+    constexpr float kTolerance = 1e-2f * kAmplitude;
+
+    float *signal = arranew(globalArena, float, kBlocks * kBlockSize);
+    float *out[] = { arranew(globalArena, float, kBlockSize), arranew(globalArena, float, kBlockSize) };
+    defer
+    {
+      utils::bumpArena::remove(out[1]);
+      utils::bumpArena::remove(out[0]);
+      utils::bumpArena::remove(signal);
+    };
+    for (u32 i = 0; i < kBlocks * kBlockSize; ++i)
+      signal[i] = kAmplitude * (float)::sin(2.0 * kPi * 441.0 * (double)i / (double)kTestSampleRate);
+
+    utils::ScopedNoDenormals noDenormals{};
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+    plugin->isRenderingOffline.store(false, satomi::memory_order_relaxed);
+    plugin->initialise((float)kTestSampleRate, kBlockSize);
+
+    for (u32 order : kOrders)
+    {
+      Plugin::loadStateImmediately(plugin, {});
+      setScaledValue(plugin->state_->soundEngine->getParameter(Generation::SoundEngine::BlockSize), order);
+      SaveCollector preset{};
+      Plugin::saveState(plugin, &preset, SaveCollector::write, false);
+      Plugin::loadStateImmediately(plugin, {});
+
+      float maxError = 0.0f;
+      u32 worstPosition = 0, worstLatency = 0;
+      for (u32 block = 0; block < kBlocks; ++block)
+      {
+        if (block == kSwapBlock)
+        {
+          Plugin::loadState(plugin, preset.view());
+          plugin->stateLoader = utils::thread{};
+          plugin->installLoadedState();
+        }
+
+        float *in[] = { signal + block * kBlockSize, signal + block * kBlockSize };
+        plugin->process(in, out, kBlockSize, utils::kChannelsPerInOut, utils::kChannelsPerInOut);
+
+        // the old state has long settled by the last blocks before the swap
+        if (block + 8 < kSwapBlock)
+          continue;
+
+        u32 latency = plugin->latency.load(satomi::memory_order_relaxed);
+        for (u32 i = 0; i < utils::kChannelsPerInOut; ++i)
+          for (u32 j = 0; j < kBlockSize; ++j)
+          {
+            u32 position = block * kBlockSize + j;
+            float error = ::fabsf(out[i][j] - signal[position - latency]);
+            if (error > maxError)
+              maxError = error, worstPosition = position, worstLatency = latency;
+          }
+      }
+
+      context.check(maxError <= kTolerance, "fft order %u: output is off by %g at sample %u (swapped at %u, latency %u)",
+        order, (double)maxError, worstPosition, kSwapBlock * kBlockSize, worstLatency);
+    }
+  }
+
+  // bytes of pinned memory in the process, only available on linux
+  u64 getLockedBytes()
+  {
+    u64 lockedKB = 0;
+  #if COMPLEX_LINUX
+    FILE *status = ::fopen("/proc/self/status", "r");
+    if (!status)
+      return 0;
+    char line[256];
+    while (::fgets(line, (int)sizeof(line), status))
+      if (::sscanf(line, "VmLck: %llu kB", (unsigned long long *)&lockedKB) == 1)
+        break;
+    ::fclose(status);
+  #endif
+    return lockedKB * COMPLEX_KB(1);
+  }
+
+  // locks don't nest, so destroying a locked arena mustn't unpin pages of its neighbours or of the arena
+  // it's nested in, and mustn't leave pages it shared with them pinned
+  void testNestedPageLocks(TestContext &context)
+  {
+  #if COMPLEX_LINUX
+    // not a multiple of the page size, so that neighbours would share pages
+    constexpr usize kArenaSize = COMPLEX_KB(10);
+
+    auto *parent = utils::bumpArena::create(COMPLEX_MB(1), COMPLEX_MB(1));
+    defer{ utils::bumpArena::destroy(parent); };
+    u64 unlocked = getLockedBytes();
+
+    auto *first = utils::bumpArena::createNested(parent, kArenaSize, utils::bumpArena::LockPages);
+    auto *second = utils::bumpArena::createNested(parent, kArenaSize, utils::bumpArena::LockPages);
+    // the memlock limit or a sanitizer (asan turns mlock into a no-op) can keep anything from being pinned
+    if (getLockedBytes() < unlocked + 2 * kArenaSize)
+    {
+      ::fprintf(stderr, "  %s skipped: pages can't be locked here\n", context.name);
+      utils::bumpArena::destroy(second);
+      utils::bumpArena::destroy(first);
+      return;
+    }
+
+    utils::bumpArena::destroy(first);
+    u64 lockedSecond = getLockedBytes();
+    context.check(lockedSecond >= unlocked + kArenaSize, "destroying an arena unpinned its neighbour (%llu bytes left)",
+      (unsigned long long)(lockedSecond - unlocked));
+    utils::bumpArena::destroy(second);
+    context.check(getLockedBytes() == unlocked, "destroyed neighbours left %llu bytes pinned",
+      (unsigned long long)(getLockedBytes() - unlocked));
+
+    auto *outer = utils::bumpArena::createNested(parent, COMPLEX_KB(64), utils::bumpArena::LockPages);
+    u64 lockedOuter = getLockedBytes();
+    auto *inner = utils::bumpArena::createNested(outer, kArenaSize, utils::bumpArena::LockPages);
+    context.check(getLockedBytes() == lockedOuter, "an arena inside a locked one locked pages again");
+    utils::bumpArena::destroy(inner);
+    context.check(getLockedBytes() == lockedOuter, "destroying a nested arena unpinned %llu bytes of its parent",
+      (unsigned long long)(lockedOuter - getLockedBytes()));
+    utils::bumpArena::destroy(outer);
+    context.check(getLockedBytes() == unlocked, "destroyed arenas left %llu bytes pinned",
+      (unsigned long long)(getLockedBytes() - unlocked));
+  #else
+    (void)context;
+  #endif
+  }
+
+  //===========================================================================================
+  // Benchmarks
+  //
+  // page faults process() took since processPageFaults was last cleared, per call of what was measured
+  void printPageFaults(Plugin::ComplexPlugin *plugin, u64 calls, const char *callName)
+  {
+    u64 faults = plugin->processPageFaults.load(satomi::memory_order_relaxed);
+    ::printf("    %.1f page faults in process() per %s\n", (double)faults / (double)utils::max(calls, (u64)1), callName);
+  }
+
+  void benchmarkRender(BenchmarkContext &context)
+  {
+    constexpr u64 kFrames = 10 * kTestSampleRate;
+
+    float *noise = arranew(globalArena, float, kFrames * 2);
+    defer{ utils::bumpArena::remove(noise); };
+    TestNoise generator{};
+    for (u64 i = 0; i < kFrames * 2; ++i)
+      noise[i] = 0.5f * generator.next();
+
+    WavFile input = createTestInput(noise, kFrames);
+    utils::ScopedNoDenormals noDenormals{};
+    auto *plugin = createRenderPlugin(0);
+    defer{ destroyRenderPlugin(plugin); };
+    plugin->countPageFaults.store(true, satomi::memory_order_relaxed);
+
+    constexpr u32 kBlockSizes[] = { 256, 1024, 8192 };
+    for (u32 blockSize : kBlockSizes)
+    {
+      RenderSettings settings{};
+      settings.blockSize = blockSize;
+
+      // every render loads the preset again, so these are the faults of the blocks after a load
+      plugin->processPageFaults.store(0, satomi::memory_order_relaxed);
+      u64 renders = 0;
+
+      char label[64];
+      (void)stbsp_snprintf(label, (int)sizeof(label), "10s of noise, default preset, block %u", blockSize);
+      context.measure(label, [&]()
+        {
+          auto output = renderToMemory(plugin, settings, input, globalArena);
+          if (!output.empty())
+            utils::bumpArena::remove(output.data());
+          ++renders;
+        }, kFrames, "sample");
+      printPageFaults(plugin, renders, "render");
+    }
+  }
+
+  // what an instance pays for its fft plans, when every instance builds its own
+  // compared to when another instance already holds them in the shared cache
+  void benchmarkFFTPlanCreation(BenchmarkContext &context)
+  {
+    constexpr u32 kOrders = kMaxFFTOrder - kMinFFTOrder + 1;
+
+    auto createAndRelease = [](Framework::FFTPlanCache &cache)
+    {
+      Framework::FFT fft{};
+      fft.arena = globalArena;
+      fft.planCache = &cache;
+      fft.extendFFTOrders(kMinFFTOrder, kMaxFFTOrder);
+      fft.releaseFFTOrders();
+    };
+
+    context.measure("plans built per instance (unshared)", [&]()
+      {
+        Framework::FFTPlanCache privateCache{ .arena = globalArena };
+        createAndRelease(privateCache);
+      }, kOrders, "order");
+
+    // another instance keeps the plans alive like a running plugin would
+    Framework::FFT holder{};
+    holder.arena = globalArena;
+    holder.planCache = &executableStaticData.fftPlans;
+    holder.extendFFTOrders(kMinFFTOrder, kMaxFFTOrder);
+
+    context.measure("plans taken from the shared cache", [&]()
+      { createAndRelease(executableStaticData.fftPlans); }, kOrders, "order");
+  }
+
+  // Contrast and Clip as they were before their statistics were gathered read-only (6ea05dd),
+  // copying into the destination first and then making two or three more passes over it
+  // Contrast's per bin pow is taken at the tier the effect uses, so that only the passes differ
+  template<utils::MathPrecision Precision>
+  void runMultiPassContrast(Generation::EffectModule *effectModule, Generation::EffectData *effectData,
+    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination, u32 binCount, float sampleRate)
+{
+    using namespace Generation;
+    using namespace utils;
+    using namespace Framework;
+
+    // getting the boundaries in terms of bin position
+    auto [lowBoundIndices, highBoundIndices] = [&]()
+    {
+      auto shiftedBoundsIndices = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
+      return utils::pair{ toInt(shiftedBoundsIndices.first), toInt(shiftedBoundsIndices.second) };
+    }();
+    simd_mask isHighAboveLowMask = simd_int::greaterThanOrEqualSigned(highBoundIndices, lowBoundIndices);
+
+    simd_float slopeMultiplier = getTiltSlopeMultiplier(
+      getParameter(effectData, Dynamics::Contrast::Tilt)->getInternalValue<simd_float>(sampleRate),
+      sampleRate, binCount);
+
+    auto rawSource = source.sourceBuffer->get();
+    auto rawScratch = source.scratchBuffer->get();
+    auto rawDestination = destination->get();
+
+    // starting point is the weighted average
+    //
+    // weights should be determined based on human perception (e^(-index) or 2^(-index)?)
+    // because we're basing things on human perception
+    // we can take a subset of the entire spectrum to compute the average
+    // skip some high frequency content entirely, which is where the bulk of the bins are
+    // if we want XY% coverage we need to take the first
+    // `(kMinFrequency * (sampleRate / (2 * kMinFrequency))^XY) / (sampleRate / (2 * binCount))` number of bins
+    // then weighted avg = sum(magnitude[i] * weight[i]) / sum(weight[i])
+    // where the sum of all the weights is 1 / (log(base) * base^x)
+    //
+    // range is percentage of the all bins (determined by parameter)
+    // only the bins in that range participate
+
+    simd_float maxMagnitude = 0.0f;
+    simd_float minMagnitude = kFloatInf;
+    simd_float avg = 0.0f;
+    simd_float slope = 1.0f;
+
+    auto spans = getBoundsSpans(lowBoundIndices, highBoundIndices, binCount);
+    if (spans.isStereo)
+    {
+      // 2^(-i)
+      simd_float weight = 1.0f;
+      for (u32 i = 0; i < binCount; ++i)
+      {
+        // copy both un/processed data
+        rawDestination[i] = rawSource[i];
+        simd_mask isInsideBoundsMask = isInsideBounds(i, lowBoundIndices, highBoundIndices, isHighAboveLowMask);
+        rawScratch[i] = reinterpretToFloat(isInsideBoundsMask);
+        simd_float magnitude = slope * complexMagnitude(rawSource[i], true);
+        avg = merge(avg, avg + magnitude, isInsideBoundsMask);
+        maxMagnitude = merge(maxMagnitude, magnitude, simd_float::greaterThan(magnitude, maxMagnitude) & isInsideBoundsMask);
+        minMagnitude = merge(minMagnitude, magnitude, simd_float::lessThan(magnitude, minMagnitude) & isInsideBoundsMask);
+
+        weight *= 0.5f;
+        slope *= slopeMultiplier;
+      }
+    }
+    else
+    {
+      // the scratch mask is still read over the whole minimised range below
+      copyUnprocessedSpans(source.sourceBuffer, destination, spans);
+      spans.forEachUnprocessed([&](u32 begin, u32 end)
+        {
+          for (u32 i = begin; i < end; ++i)
+            rawScratch[i] = 0.0f;
+        });
+      spans.forEachProcessed([&](u32 begin, u32 end)
+        {
+          slope = utils::pow(slopeMultiplier, (float)begin);
+          for (u32 i = begin; i < end; ++i)
+          {
+            rawDestination[i] = rawSource[i];
+            rawScratch[i] = reinterpretToFloat(simd_mask{ kFullMask });
+            simd_float magnitude = slope * complexMagnitude(rawSource[i], true);
+            avg += magnitude;
+            maxMagnitude = simd_float::max(maxMagnitude, magnitude);
+            minMagnitude = simd_float::min(minMagnitude, magnitude);
+
+            slope *= slopeMultiplier;
+          }
+        });
+    }
+
+    {
+      // integral(0, inf, 2^(-i)), sum of all the weights
+      static constexpr simd_float kWeightSum = 1.0f / const_math::log(2.0f);
+      avg /= kWeightSum * (float)binCount;
+
+      simd_float avgDb = utils::amplitudeToDb(avg);
+      simd_float minDb = utils::amplitudeToDb(minMagnitude);
+      simd_float maxDb = utils::amplitudeToDb(maxMagnitude);
+
+      COMPLEX_ASSERT(simd_mask::anyMask(simd_float::greaterThan(avgDb, maxDb)) == 0);
+      COMPLEX_ASSERT(simd_mask::anyMask(simd_float::lessThan(avgDb, minDb)) == 0);
+
+      simd_float rangeParameter = getParameter(effectData, Dynamics::Contrast::Range)->getInternalValue<simd_float>(sampleRate);
+      simd_float dbRange = (maxDb - minDb) * rangeParameter;
+      simd_float newMinDb = simd_float::max(minDb, avgDb - dbRange * 0.5f);
+      maxDb = simd_float::min(newMinDb + dbRange, maxDb);
+      minDb = maxDb - dbRange;
+
+      minMagnitude = utils::dbToAmplitude(minDb);
+      maxMagnitude = utils::dbToAmplitude(maxDb);
+
+      // squaring the magnitudes because we use squared norms in the processing below
+      minMagnitude *= minMagnitude;
+      maxMagnitude *= maxMagnitude;
+    }
+
+    // minimising the bins to iterate on
+    auto [start, processedCount, _] = minimiseRange(lowBoundIndices, highBoundIndices, binCount, true);
+    slope = utils::pow(slopeMultiplier, (float)start);
+
+    simd_float inPower = 0.0f;
+    circularLoop([&](u32 index)
+      {
+        simd_float magnitude = slope * complexMagnitude(rawDestination[index], false);
+        rawScratch[index] &= simd_float::greaterThanOrEqual(magnitude, minMagnitude) &
+          simd_float::lessThanOrEqual(magnitude, maxMagnitude);
+        inPower += magnitude & rawScratch[index];
+        slope *= slopeMultiplier;
+      }, start, processedCount, binCount);
+
+    // calculating contrast
+    simd_float depthParameter = getParameter(effectData, Dynamics::Contrast::Depth)
+      ->getInternalValue<simd_float>(sampleRate);
+    simd_float contrast = depthParameter * depthParameter;
+    contrast = merge(Dynamics::kContrastMaxNegativeValue * contrast,
+      Dynamics::kContrastMaxPositiveValue * contrast,
+      simd_float::greaterThanOrEqual(depthParameter, 0.0f));
+
+    simd_float min = utils::exp(-80.0f / (contrast * 2.0f + 1.0f));
+    simd_float max = utils::exp( 80.0f / (contrast * 2.0f + 1.0f));
+    min = merge(1e-30f, min, simd_float::greaterThan(contrast, 0.0f));
+    max = merge(1e+30f, max, simd_float::greaterThan(contrast, 0.0f));
+
+    simd_int boundDistanceCount = (modOnce(binCount + highBoundIndices - lowBoundIndices, binCount) + 1)
+      & simd_int::notEqual(lowBoundIndices, highBoundIndices);
+    simd_float inScale = matchPower(toFloat(boundDistanceCount), inPower);
+
+    slope = utils::pow(slopeMultiplier, (float)start);
+
+    // applying gain and calculating outPower
+    simd_float outPower = 0.0f;
+    circularLoop([&](u32 index)
+      {
+        simd_float bin = slope * inScale * rawDestination[index];
+        simd_float magnitude = complexMagnitude(bin, true);
+
+        bin &= simd_float::lessThanOrEqual(min, magnitude);
+        bin = merge(bin, bin * utils::pow<Precision>(magnitude, contrast), simd_float::greaterThan(max, magnitude));
+
+        outPower += complexMagnitude(bin, false) & reinterpretToInt(rawScratch[index]);
+        rawDestination[index] = merge(rawDestination[index], bin / slope, reinterpretToInt(rawScratch[index]));
+        slope *= slopeMultiplier;
+      }, start, processedCount, binCount);
+
+    // normalising
+    simd_float outScale = matchPower(inPower, outPower);
+    circularLoop([&](u32 index)
+      {
+        rawDestination[index] *= merge(1.0f, outScale, reinterpretToInt(rawScratch[index]));
+      }, start, processedCount, binCount);
+  }
+
+  void runMultiPassClip(Generation::EffectModule *effectModule, Generation::EffectData *effectData,
+    Framework::ComplexDataSource &source, Framework::SimdBuffer *destination, u32 binCount, float sampleRate)
+{
+    using namespace Generation;
+    using namespace utils;
+    using namespace Framework;
+
+    static constexpr float kSilenceThreshold = 1e-30f;
+    static constexpr float kLoudestThreshold = 1e+30f;
+
+    // getting the boundaries in terms of bin position
+    auto [lowBoundIndices, highBoundIndices] = [&]()
+    {
+      auto shiftedBoundsIndices = getShiftedBounds(effectModule, EffectModule::BoundRepresentation::BinIndex, sampleRate, binCount);
+      return utils::pair{ toInt(shiftedBoundsIndices.first), toInt(shiftedBoundsIndices.second) };
+    }();
+    simd_mask isHighAboveLowMask = simd_int::greaterThanOrEqualSigned(highBoundIndices, lowBoundIndices);
+
+    COMPLEX_ASSERT(source.sourceBuffer->size == destination->size);
+
+    auto rawSource = source.sourceBuffer->get();
+    auto rawDestination = destination->get();
+
+    // getting the min/max power in the range selected
+    utils::pair<simd_float, simd_float> powerMinMax{ kLoudestThreshold, kSilenceThreshold };
+    auto spans = getBoundsSpans(lowBoundIndices, highBoundIndices, binCount);
+    if (spans.isStereo)
+    {
+      for (u32 j = 0; j < binCount; j++)
+      {
+        // while calculating the power min-max we can copy over data
+        rawDestination[j] = rawSource[j];
+
+        simd_float magnitude = complexMagnitude(rawDestination[j], false);
+        simd_mask isIndexOutside = isOutsideBounds(j, lowBoundIndices, highBoundIndices, isHighAboveLowMask);
+        powerMinMax.first  = merge(simd_float::min(powerMinMax.first , magnitude), powerMinMax.first , isIndexOutside);
+        powerMinMax.second = merge(simd_float::max(powerMinMax.second, magnitude), powerMinMax.second, isIndexOutside);
+      }
+    }
+    else
+    {
+      copyUnprocessedSpans(source.sourceBuffer, destination, spans);
+      spans.forEachProcessed([&](u32 begin, u32 end)
+        {
+          for (u32 j = begin; j < end; j++)
+          {
+            rawDestination[j] = rawSource[j];
+
+            simd_float magnitude = complexMagnitude(rawDestination[j], false);
+            powerMinMax.first  = simd_float::min(powerMinMax.first , magnitude);
+            powerMinMax.second = simd_float::max(powerMinMax.second, magnitude);
+          }
+        });
+    }
+
+    // minimising the bins to iterate on
+    auto [start, processedCount, _] = minimiseRange(lowBoundIndices, highBoundIndices, binCount, true);
+
+    // calculating clipping
+    simd_float thresholdParameter = getParameter(effectData, Dynamics::Clip::Threshold)
+      ->getInternalValue<simd_float>(sampleRate);
+    thresholdParameter = thresholdParameter * thresholdParameter * thresholdParameter;
+    simd_float threshold = utils::exp(utils::lerp(utils::log(simd_float::max(powerMinMax.first, 1e-36f)),
+                                    utils::log(simd_float::max(powerMinMax.second, 1e-36f)),
+                                    simd_float{ 1.0f } - thresholdParameter));
+    simd_float slopeMultiplier = getTiltSlopeMultiplier(
+      -getParameter(effectData, Dynamics::Clip::Tilt)->getInternalValue<simd_float>(sampleRate),
+      sampleRate, binCount);
+    // reset slope to the start of the covered range
+    threshold *= utils::pow(slopeMultiplier, (float)start);
+
+    // doing clipping
+    simd_float inPower = 0.0f;
+    simd_float outPower = 0.0f;
+    circularLoop([&](u32 index)
+      {
+        simd_mask isIndexInside = isInsideBounds(index, lowBoundIndices, highBoundIndices, isHighAboveLowMask);
+        simd_float magnitude = complexMagnitude(rawDestination[index], false);
+
+        // 0/0 and >0/0 masking, prevents NaN and Inf respectively
+        simd_float rescale = simd_float::sqrt(threshold / magnitude) &
+          simd_float::notEqual(threshold, 0.0f) & simd_float::notEqual(magnitude, 0.0f);
+        rawDestination[index] *= merge(1.0f, rescale,
+          simd_float::greaterThanOrEqual(magnitude, threshold) & isIndexInside);
+
+        inPower += magnitude & isIndexInside;
+        outPower += simd_float::min(magnitude, threshold) & isIndexInside;
+        threshold *= slopeMultiplier;
+      }, start, processedCount, binCount);
+
+    // normalising
+    simd_float outScale = matchPower(inPower, outPower);
+    outScale = merge(outScale, 1.0f, simd_float::isNan(outScale));
+    circularLoop([&](u32 index)
+      {
+        rawDestination[index] = merge(rawDestination[index] * outScale, rawDestination[index],
+          isOutsideBounds(index, lowBoundIndices, highBoundIndices, isHighAboveLowMask));
+      }, start, processedCount, binCount);
+  }
+
+  // a range wrapping around the spectrum is processed as two spans, with the tilt carried from one to the other
+  void benchmarkDynamicsTilt(BenchmarkContext &context)
+  {
+    constexpr uuid kTypes[] = { Generation::Dynamics::Types::Contrast, Generation::Dynamics::Types::Clip };
+    constexpr uuid kTiltIds[] = { Generation::Dynamics::Contrast::Tilt, Generation::Dynamics::Clip::Tilt };
+    constexpr const char *kTypeNames[] = { "contrast", "clip" };
+    // realtime processing is what has to keep up, so both run at the tiers it uses
+    constexpr Generation::EffectData::RunEffectFn *kReferences[] =
+      { runMultiPassContrast<utils::MathPrecision::Fast>, runMultiPassClip };
+
+    for (usize i = 0; i < countof(kTypes); ++i)
+    {
+      EffectHarness harness{};
+      harness.create(kTypes[i]);
+      defer{ harness.destroy(); };
+      harness.plugin->isRenderingOffline.store(false, satomi::memory_order_relaxed);
+      harness.setEffectValue(kTiltIds[i], 0.75f);
+
+      struct { const char *name; float low, high; } ranges[] =
+      {
+        { "whole spectrum", 0.0f, 1.0f },
+        { "range 0.3-0.7", 0.3f, 0.7f },
+        { "wrapped 0.7-0.3", 0.7f, 0.3f },
+      };
+      for (auto &range : ranges)
+      {
+        harness.setModuleValue(Generation::EffectModule::LowBound, range.low);
+        harness.setModuleValue(Generation::EffectModule::HighBound, range.high);
+
+        char label[64];
+        (void)stbsp_snprintf(label, (int)sizeof(label), "%s with tilt, %s", kTypeNames[i], range.name);
+        context.measure(label, [&]() { harness.run(); }, EffectHarness::kBinCount, "bin");
+
+        (void)stbsp_snprintf(label, (int)sizeof(label), "%s reference, %s", kTypeNames[i], range.name);
+        context.measure(label, [&]()
+          {
+            harness.source.invalidatePowers();
+            kReferences[i](harness.module, harness.effectData, harness.source, harness.output,
+              EffectHarness::kBinCount, (float)kTestSampleRate);
+          }, EffectHarness::kBinCount, "bin");
+      }
+    }
+  }
+
+  // the histogram selection against sorting both channels' tilted powers, which is what it replaces
+  void benchmarkRankThreshold(BenchmarkContext &context)
+  {
+    constexpr u32 kBinCounts[] = { (1U << 12) / 2 + 1, (1U << 15) / 2 + 1 };
+    constexpr float kSlopeMultiplier = 0.9995f;
+    constexpr float kFraction = 0.1f;
+
+    for (u32 binCount : kBinCounts)
+    {
+      RankThresholdInput input{};
+      input.create(binCount);
+      defer{ input.destroy(); };
+
+      simd_int lowIndices = 0;
+      simd_int highIndices = binCount - 1;
+
+      char label[64];
+      (void)stbsp_snprintf(label, (int)sizeof(label), "histogram selection, %u bins", binCount);
+      context.measure(label, [&]()
+        { (void)input.run(lowIndices, highIndices, kSlopeMultiplier, kFraction); }, binCount, "bin");
+
+      float *sorted = arranew(globalArena, float, binCount);
+      defer{ utils::bumpArena::remove(sorted); };
+      volatile float sink = 0.0f;
+      (void)stbsp_snprintf(label, (int)sizeof(label), "sort reference, %u bins", binCount);
+      context.measure(label, [&]()
+        {
+          for (u32 j = 0; j < utils::kChannelsPerInOut; ++j)
+          {
+            simd_float slope = 1.0f;
+            for (u32 i = 0; i < binCount; ++i)
+            {
+              sorted[i] = (input.powers[i] * slope * slope)[2 * j];
+              slope *= kSlopeMultiplier;
+            }
+            sortDescending(sorted, binCount);
+            sink = sorted[(u32)((float)binCount * kFraction + 0.5f) - 1];
+          }
+        }, binCount, "bin");
+    }
+  }
+
+  template<utils::MathPrecision Precision>
+  void benchmarkTranscendentalTier(BenchmarkContext &context, const char *tierName, simd_float *values, u32 count)
+  {
+    simd_float sink = 0.0f;
+    char label[64];
+
+    (void)stbsp_snprintf(label, (int)sizeof(label), "exp2, %s", tierName);
+    context.measure(label, [&]()
+      {
+        for (u32 i = 0; i < count; ++i)
+          sink += utils::exp2<Precision>(values[i]);
+      }, count * simd_float::size, "value");
+
+    (void)stbsp_snprintf(label, (int)sizeof(label), "log2, %s", tierName);
+    context.measure(label, [&]()
+      {
+        for (u32 i = 0; i < count; ++i)
+          sink += utils::log2<Precision>(values[i]);
+      }, count * simd_float::size, "value");
+
+    (void)stbsp_snprintf(label, (int)sizeof(label), "pow, %s", tierName);
+    context.measure(label, [&]()
+      {
+        for (u32 i = 0; i < count; ++i)
+          sink += utils::pow<Precision>(values[i], 0.75f);
+      }, count * simd_float::size, "value");
+
+    (void)stbsp_snprintf(label, (int)sizeof(label), "amplitudeToDb, %s", tierName);
+    context.measure(label, [&]()
+      {
+        for (u32 i = 0; i < count; ++i)
+          sink += utils::amplitudeToDb<Precision>(values[i]);
+      }, count * simd_float::size, "value");
+
+    (void)stbsp_snprintf(label, (int)sizeof(label), "dbToAmplitude, %s", tierName);
+    context.measure(label, [&]()
+      {
+        for (u32 i = 0; i < count; ++i)
+          sink += utils::dbToAmplitude<Precision>(values[i]);
+      }, count * simd_float::size, "value");
+
+    (void)stbsp_snprintf(label, (int)sizeof(label), "sqrt, %s", tierName);
+    context.measure(label, [&]()
+      {
+        for (u32 i = 0; i < count; ++i)
+          sink += utils::sqrt<Precision>(values[i]);
+      }, count * simd_float::size, "value");
+
+    (void)stbsp_snprintf(label, (int)sizeof(label), "invSqrt, %s", tierName);
+    context.measure(label, [&]()
+      {
+        for (u32 i = 0; i < count; ++i)
+          sink += utils::invSqrt<Precision>(values[i]);
+      }, count * simd_float::size, "value");
+
+    // every call gives a cos/sin pair for each pair of lanes
+    (void)stbsp_snprintf(label, (int)sizeof(label), "cis, %s", tierName);
+    context.measure(label, [&]()
+      {
+        for (u32 i = 0; i < count; ++i)
+          sink += utils::cis<Precision>(values[i]);
+      }, count * simd_float::size / 2, "pair");
+
+    // keeps the loops from being thrown away
+    volatile float result = sink[0];
+    (void)result;
+  }
+
+  void benchmarkTranscendentals(BenchmarkContext &context)
+  {
+    constexpr u32 kCount = 4096;
+
+    simd_float *values = arranew(globalArena, simd_float, kCount);
+    defer{ utils::bumpArena::remove(values); };
+    TestNoise generator{};
+    for (u32 i = 0; i < kCount; ++i)
+      for (u32 j = 0; j < simd_float::size; ++j)
+        values[i].set(j, 0.01f + 10.0f * (generator.next() + 1.0f));
+    // cis takes the same angle in both lanes of a pair
+    for (u32 i = 0; i < kCount; ++i)
+      for (u32 j = 1; j < simd_float::size; j += 2)
+        values[i].set(j, values[i][j - 1]);
+
+    benchmarkTranscendentalTier<utils::MathPrecision::Fast>(context, "fast", values, kCount);
+    benchmarkTranscendentalTier<utils::MathPrecision::Medium>(context, "medium", values, kCount);
+    benchmarkTranscendentalTier<utils::MathPrecision::Accurate>(context, "accurate", values, kCount);
+  }
+
+  // whole loads, from the data to the state being live, for both formats
+  // and the page faults processing takes right after one
+  void benchmarkStateLoad(BenchmarkContext &context)
+  {
+    constexpr u32 kModuleCounts[] = { 0, 64 };
+    // what createRoundTripPlugin initialises with
+    constexpr u32 kBlockSize = 1024;
+
+    for (u32 moduleCount : kModuleCounts)
+    {
+      auto *plugin = createRoundTripPlugin(moduleCount);
+      defer{ destroyRenderPlugin(plugin); };
+
+      SaveCollector json{}, binary{};
+      Plugin::saveState(plugin, &json, SaveCollector::write, true);
+      Plugin::saveState(plugin, &binary, SaveCollector::write, false);
+
+      char label[64];
+      (void)stbsp_snprintf(label, (int)sizeof(label), "json, %u modules (%zu bytes)", moduleCount, json.bytes.size());
+      context.measure(label, [&]() { Plugin::loadStateImmediately(plugin, json.view()); }, json.bytes.size(), "byte");
+      (void)stbsp_snprintf(label, (int)sizeof(label), "binary, %u modules (%zu bytes)", moduleCount, binary.bytes.size());
+      context.measure(label, [&]() { Plugin::loadStateImmediately(plugin, binary.view()); }, binary.bytes.size(), "byte");
+
+      // the first blocks after a load are the ones touching the new state's buffers
+      constexpr u32 kLoads = 16;
+      constexpr u32 kBlocksAfterLoad = 64;
+      float *in[utils::kChannelsPerInOut], *out[utils::kChannelsPerInOut];
+      for (u32 i = 0; i < utils::kChannelsPerInOut; ++i)
+      {
+        in[i] = arranew(globalArena, float, kBlockSize, {});
+        out[i] = arranew(globalArena, float, kBlockSize, {});
+      }
+      defer
+      {
+        for (u32 i = utils::kChannelsPerInOut; i > 0; --i)
+        {
+          utils::bumpArena::remove(out[i - 1]);
+          utils::bumpArena::remove(in[i - 1]);
+        }
+      };
+
+      utils::ScopedNoDenormals noDenormals{};
+      plugin->countPageFaults.store(true, satomi::memory_order_relaxed);
+      plugin->processPageFaults.store(0, satomi::memory_order_relaxed);
+      for (u32 i = 0; i < kLoads; ++i)
+      {
+        Plugin::loadStateImmediately(plugin, binary.view());
+        for (u32 j = 0; j < kBlocksAfterLoad; ++j)
+          plugin->process(in, out, kBlockSize, utils::kChannelsPerInOut, utils::kChannelsPerInOut);
+      }
+      plugin->countPageFaults.store(false, satomi::memory_order_relaxed);
+      (void)stbsp_snprintf(label, (int)sizeof(label), "load and %u blocks", kBlocksAfterLoad);
+      printPageFaults(plugin, kLoads, label);
+    }
+  }
+
+  constexpr usize kAnyChunkSize = ~(usize)0;
+
+  // serves a state to cplug_loadState the way a host would, at most chunkSize bytes per call
+  struct HostStream
+  {
+    utils::string_view data{};
+    usize chunkSize = kAnyChunkSize;
+    usize position = 0;
+    usize calls = 0;
+
+    static i64 read(const void *stateCtx, void *readPos, usize maxBytesToRead)
+    {
+      auto *self = (HostStream *)stateCtx;
+      usize size = utils::min(utils::min(maxBytesToRead, self->chunkSize), self->data.size() - self->position);
+      ::memcpy(readPos, self->data.data() + self->position, size);
+      self->position += size;
+      ++self->calls;
+      return (i64)size;
+    }
+  };
+
+  // reading megabyte sized states from the host, on its own and with the load after it
+  void benchmarkHostStateLoad(BenchmarkContext &context)
+  {
+    constexpr usize kStateSizes[] = { COMPLEX_MB(1), COMPLEX_MB(4), COMPLEX_MB(16) };
+    // hosts hand out anything from a few KB to the whole state per call
+    constexpr usize kChunkSizes[] = { COMPLEX_KB(4), kAnyChunkSize };
+    // what the reader did before it grew geometrically
+    constexpr usize kReferenceIncrease = COMPLEX_KB(4);
+
+    char *synthetic = arranew(globalArena, char, kStateSizes[countof(kStateSizes) - 1]);
+    defer{ utils::bumpArena::remove(synthetic); };
+    TestNoise generator{};
+    for (usize i = 0; i < kStateSizes[countof(kStateSizes) - 1]; ++i)
+      synthetic[i] = (char)(' ' + (u32)((generator.next() + 1.0f) * 47.0f));
+
+    // a host loads a state once, so the read also runs on fresh threads
+    // whose local scratch hasn't faulted in any of the pages it's going to use
+    auto measureCold = [](const auto &function)
+    {
+      constexpr u32 kColdReads = 8;
+      u64 microseconds = 0, pageFaults = 0;
+      for (u32 i = 0; i < kColdReads; ++i)
+      {
+        utils::thread reader = [&]()
+        {
+          u64 pageFaultsAtStart = utils::getPageFaultCount();
+          u64 start = utils::getMonotonicMicroseconds();
+          function();
+          microseconds += utils::getMonotonicMicroseconds() - start;
+          pageFaults += utils::getPageFaultCount() - pageFaultsAtStart;
+        };
+        reader = utils::thread{};
+      }
+      ::printf("    cold: %.1f ns/call, %.1f page faults per read\n",
+        (double)microseconds * 1000.0 / kColdReads, (double)pageFaults / kColdReads);
+    };
+
+    for (usize stateSize : kStateSizes)
+    {
+      for (usize chunkSize : kChunkSizes)
+      {
+        HostStream stream{ .data = { synthetic, stateSize }, .chunkSize = chunkSize };
+        char chunkName[16];
+        if (chunkSize == kAnyChunkSize)
+          (void)stbsp_snprintf(chunkName, (int)sizeof(chunkName), "any");
+        else
+          (void)stbsp_snprintf(chunkName, (int)sizeof(chunkName), "%zu KB", chunkSize / COMPLEX_KB(1));
+
+        auto read = [&]()
+        {
+          stream.position = 0;
+          stream.calls = 0;
+          auto state = readHostState(&stream, HostStream::read);
+          utils::bumpArena::remove(state.data());
+        };
+        auto readReference = [&]()
+        {
+          stream.position = 0;
+          stream.calls = 0;
+          usize capacity = kReferenceIncrease;
+          usize size{};
+          char *buffer = arranew(getLocalScratch(), char, capacity, {});
+          while (usize readBytes = (usize)HostStream::read(&stream, buffer + size, capacity - size))
+          {
+            size += readBytes;
+            if (size >= capacity)
+            {
+              capacity += kReferenceIncrease;
+              buffer = (char *)utils::bumpArena::resize(buffer, capacity, true);
+            }
+          }
+          utils::bumpArena::remove(buffer);
+        };
+
+        char label[64];
+        (void)stbsp_snprintf(label, (int)sizeof(label), "read, %zu MB, %s chunks", stateSize / COMPLEX_MB(1), chunkName);
+        context.measure(label, read, stateSize, "byte");
+        ::printf("    %zu readProc calls\n", stream.calls);
+        measureCold(read);
+
+        (void)stbsp_snprintf(label, (int)sizeof(label), "read reference, %zu MB, %s chunks", stateSize / COMPLEX_MB(1), chunkName);
+        context.measure(label, readReference, stateSize, "byte");
+        ::printf("    %zu readProc calls\n", stream.calls);
+        measureCold(readReference);
+      }
+    }
+
+    // a real state past 1 MB, through cplug_loadState up to it being installed
+    auto *plugin = createRoundTripPlugin(192);
+    defer{ destroyRenderPlugin(plugin); };
+
+    SaveCollector json{};
+    Plugin::saveState(plugin, &json, SaveCollector::write, true);
+    COMPLEX_ASSERT(json.bytes.size() >= COMPLEX_MB(1));
+
+    HostStream stream{ .data = json.view(), .chunkSize = COMPLEX_KB(4) };
+    char label[64];
+    (void)stbsp_snprintf(label, (int)sizeof(label), "cplug_loadState, json (%zu bytes)", json.bytes.size());
+    context.measure(label, [&]()
+      {
+        stream.position = 0;
+        cplug_loadState(plugin, &stream, HostStream::read);
+        plugin->stateLoader = utils::thread{};
+        plugin->installLoadedState();
+      }, json.bytes.size(), "byte");
+  }
+
+  struct TestEntry
+  {
+    const char *name;
+    void (*function)(TestContext &);
+  };
+
+  struct BenchmarkEntry
+  {
+    const char *name;
+    void (*function)(BenchmarkContext &);
+  };
+
+  constexpr TestEntry kTests[] =
+  {
+    { "render-determinism", testRenderDeterminism },
+    { "latency", testReportedLatency },
+    { "offline-matches-realtime", testOfflineMatchesRealtime },
+    { "audio-thread-guard-drain", testAudioThreadGuardDrain },
+    { "rank-threshold", testRankThreshold },
+    { "kernel-fusion", testKernelFusion },
+    { "transcendental-accuracy", testTranscendentalAccuracy },
+    { "streamed-binary-save", testStreamedBinarySave },
+    { "state-round-trip", testStateRoundTrip },
+    { "binary-nesting", testBinaryNesting },
+    { "bridge-descriptors", testBridgeDescriptors },
+    { "background-load", testBackgroundLoad },
+    { "state-crossfade", testStateCrossfade },
+    { "overlap-add-gain", testOverlapAddGain },
+    { "nested-page-locks", testNestedPageLocks },
+  };
+
+  constexpr BenchmarkEntry kBenchmarks[] =
+  {
+    { "render", benchmarkRender },
+    { "fft-plans", benchmarkFFTPlanCreation },
+    { "dynamics-tilt", benchmarkDynamicsTilt },
+    { "gate-rank", benchmarkRankThreshold },
+    { "transcendentals", benchmarkTranscendentals },
+    { "state-load", benchmarkStateLoad },
+    { "host-state-load", benchmarkHostStateLoad },
+  };
+
+  bool matchesFilters(const char *name, utils::span<const char *> filters)
+  {
+    if (filters.empty())
+      return true;
+
+    utils::string_view nameView{ name, utils::getStringSize(name) };
+    for (const char *filter : filters)
+    {
+      utils::string_view filterView{ filter, utils::getStringSize(filter) };
+      if (filterView.size() <= nameView.size() && nameView.find(filterView) != utils::string_view::npos)
+        return true;
+    }
+    return false;
+  }
+
+  int runTests(utils::span<const char *> filters)
+  {
+    u32 testsRun = 0, testsFailed = 0;
+    for (const auto &test : kTests)
+    {
+      if (!matchesFilters(test.name, filters))
+        continue;
+
+      TestContext context{ .name = test.name };
+      u64 violationsBefore = utils::AudioThreadGuard::getViolationCount();
+      u64 start = utils::getMonotonicMicroseconds();
+      test.function(context);
+      double seconds = (double)(utils::getMonotonicMicroseconds() - start) * 1e-6;
+
+      u64 violations = utils::AudioThreadGuard::getViolationCount() - violationsBefore - context.expectedViolations;
+      if (violations)
+        (void)printAudioThreadViolations();
+      context.check(!violations, "%llu realtime-unsafe operations on the audio thread", (unsigned long long)violations);
+
+      ++testsRun;
+      testsFailed += (context.failures) ? 1 : 0;
+      ::fprintf(stdout, "%-32s %s (%u checks, %.3fs)\n", test.name,
+        (context.failures) ? "FAILED" : "ok", context.checks, seconds);
+    }
+
+    ::fprintf(stdout, "%u of %u tests passed\n", testsRun - testsFailed, testsRun);
+    return (testsFailed || !testsRun) ? 1 : 0;
+  }
+
+  int runBenchmarks(utils::span<const char *> filters)
+  {
+    u32 benchmarksRun = 0;
+    for (const auto &benchmark : kBenchmarks)
+    {
+      if (!matchesFilters(benchmark.name, filters))
+        continue;
+
+      ::fprintf(stdout, "%s\n", benchmark.name);
+      ::fflush(stdout);
+      BenchmarkContext context{ .name = benchmark.name };
+      benchmark.function(context);
+      ++benchmarksRun;
+    }
+
+    return (benchmarksRun) ? 0 : 1;
+  }
+}
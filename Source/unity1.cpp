@@ -26,5 +26,9 @@
 
 #include "Plugin/Complex.cpp"
 #include "Plugin/Renderer.cpp"
+#ifdef COMPLEX_RENDER_CLI
+  #include "Plugin/CommandLine.cpp"
+  #include "Plugin/Tests.cpp"
+#endif
 
 //#include "crt/crt.cpp"
@@ -20,7 +20,9 @@
 #else
   #pragma GCC diagnostic push
   #pragma GCC diagnostic ignored "-Wmultichar"
-  #pragma GCC diagnostic ignored "-Wnullability-completeness"
+  #ifdef __clang__
+    #pragma GCC diagnostic ignored "-Wnullability-completeness"
+  #endif
 #endif
 
 #ifdef COMPLEX_WINDOWS
@@ -80,6 +82,8 @@ void  arena_free(void *pointer);
   #endif
 #elif COMPLEX_CLAP
   #include "Third Party/cplug/cplug_clap.c"
+#elif COMPLEX_RENDER_CLI
+  // complex-render drives the plugin itself, see Plugin/CommandLine.cpp
 #else
   #include "Third Party/cplug/cplug_vst3.c"
 #endif
@@ -87,8 +91,15 @@ void  arena_free(void *pointer);
 #define XFILES_MALLOC(size)       global_malloc(size)
 #define XFILES_REALLOC(ptr, size) global_realloc(ptr, size)
 #define XFILES_FREE(ptr)          global_free(ptr)
+#if !defined(NDEBUG) && defined(__GNUC__) && !defined(__clang__)
+  // xhl_files only knows clang's __builtin_debugtrap
+  #define XFILES_ASSERT(cond) (cond) ? (void)0 : __builtin_trap()
+#endif
 #define XHL_FILES_IMPL
 #include "Third Party/xhl/xhl_files.h"
+#if COMPLEX_LINUX
+  #include "Framework/xhl_files_linux.c"
+#endif
 
 #ifdef _MSC_VER
   #pragma warning (pop)
@@ -119,7 +130,10 @@ void  arena_free(void *pointer);
 #define PUGL_FREE global_free
 #include "Third Party/pugl/src/common.c"
 #include "Third Party/pugl/src/internal.c"
-#if COMPLEX_WINDOWS
+#if COMPLEX_RENDER_CLI
+  // complex-render never opens a window, so it doesn't need a windowing system
+  #include "Framework/pugl_headless.c"
+#elif COMPLEX_WINDOWS
   #include "Third Party/pugl/src/win.c"
   #include "Third Party/pugl/src/win_gl.c"
 #elif COMPLEX_LINUX
@@ -10,10 +10,11 @@ clap=0
 data=0
 hotreload=0
 reloadable=0
+render=0
 
 for arg in "$@"; do
   case "$arg" in
-    full|debug|release|vst|standalone|clap|data|hotreload|reloadable)
+    full|debug|release|vst|standalone|clap|data|hotreload|reloadable|render)
       declare "$arg=1"
       ;;
   esac
@@ -26,6 +27,7 @@ echo
 [[ $clap == 1 ]] && { echo "[clap build]"; vst=0; standalone=0; full=0; }
 [[ $vst == 1 ]] && { echo "[vst build]"; standalone=0; clap=0; full=0; }
 [[ $hotreload == 1 ]] && { echo "[hotreload build]"; full=0; }
+[[ $render == 1 ]] && { echo "[render cli build]"; vst=0; standalone=0; clap=0; hotreload=0; full=0; }
 [[ $reloadable == 1 ]] && echo "[reloadable version]"
 
 if [[ $release == 1 ]]; then
@@ -40,7 +42,7 @@ echo
 CXX=${CXX:-g++}
 CC=${CC:-gcc}
 
-command -v "$CXX" >/dev/null || { echo "clang++ not found"; exit 1; }
+command -v "$CXX" >/dev/null || { echo "$CXX not found"; exit 1; }
 
 TOP="$(cd "$(dirname "$0")" && pwd)"
 
@@ -62,7 +64,7 @@ stop_timer() {
 
 data_gen(){
     echo "[serialising data]"
-    pushd helpers >/dev/null
+    pushd Helpers >/dev/null
     rm -rf build
     mkdir build
     pushd build >/dev/null
@@ -88,10 +90,29 @@ project_compile() {
     )
 
     cflags=(-I"$TOP/Source" -Wall -Wno-missing-braces -Wno-multichar -DPUGL_STATIC -march=armv8.1-a)
+    c_only_flags=()
     ldflags=(-framework CoreFoundation -framework Foundation -framework CoreGraphics -framework CoreVideo -framework AppKit)
 
+    if [[ $(uname) == Linux ]]; then
+        sources=(
+          "$TOP/Source/unity1.cpp"
+          "$TOP/Source/unity2.cpp"
+        )
+        c_sources=(
+          "$TOP/Source/unity_extern.c"
+        )
+        cflags=(-I"$TOP/Source" -Wall -Wno-missing-braces -Wno-multichar -DPUGL_STATIC)
+        # posix parts of the c headers (file metadata, directory entries) are hidden by -std=c99
+        c_only_flags+=(-D_DEFAULT_SOURCE)
+        [[ $(uname -m) == x86_64 ]] && cflags+=(-msse4.1 -mfma)
+        ldflags=(-lX11 -lXext -lXrandr -lXcursor -lGL -lpthread -ldl -lm)
+        # the cli uses pugl's headless backend, so it doesn't link against x11/gl
+        [[ $render == 1 ]] && ldflags=(-lpthread -ldl -lm)
+    fi
+
     [[ $reloadable == 1 ]] && cflags+=(-DCOMPLEX_HOTRELOAD_DIR="\"$hotreload_dir\"")
 
+    bundle=1
     bundle_type="BNDL"
     if [[ $hotreload == 1 ]]; then
         build_dir=$hotreload_dir
@@ -115,14 +136,22 @@ project_compile() {
         bundle_type="APPL"
         cflags+=(-DCOMPLEX_STANDALONE)
         ldflags+=(-framework CoreAudio -framework CoreMIDI)
+    elif [[ $render == 1 ]]; then
+        rm -rf "$hotreload_dir"/*
+        build_dir=build/render
+        outfile="complex-render"
+        bundle=0
+        cflags+=(-DCOMPLEX_RENDER_CLI)
     fi
+    [[ $hotreload == 1 ]] && bundle=0
 
     if [[ $debug == 1 ]]; then
         [[ $hotreload == 0 ]] && build_dir="$build_dir/debug"
         cflags+=(-g -O0)
     else
         [[ $hotreload == 0 ]] && build_dir="$build_dir/release"
-        cflags+=(-O3 -flto)
+        # gcc warns that it links serially unless it's allowed to pick the number of jobs
+        [[ $(uname) == Linux ]] && cflags+=(-O3 -flto=auto) || cflags+=(-O3 -flto)
     fi
 
     [[ $data == 1 ]] && { data_gen; return; }
@@ -132,8 +161,8 @@ project_compile() {
     start_timer
     pushd "$build_dir" >/dev/null
 
-    if [[ $hotreload == 0 ]]; then
-        rm -rf ./*
+    [[ $hotreload == 0 ]] && rm -rf ./*
+    if [[ $bundle == 1 ]]; then
         mkdir -p "$outfile"
         mkdir -p "$outfile/Contents"
         mkdir -p "$outfile/Contents/MacOS"
@@ -147,11 +176,11 @@ project_compile() {
         pushd "MacOS" >/dev/null
     fi
 
-    "$CC" "${cflags[@]}" -std=c99 -o unity_extern.o -c "${c_sources[@]}"
+    "$CC" "${cflags[@]}" "${c_only_flags[@]}" -std=c99 -o unity_extern.o -c "${c_sources[@]}"
     "$CXX" "${cflags[@]}" -std=c++20 "${sources[@]}" unity_extern.o -o "$outfile" "${ldflags[@]}"
     rm -f ./*.o
 
-    if [[ $hotreload == 0 ]]; then
+    if [[ $bundle == 1 ]]; then
         popd >/dev/null
         popd >/dev/null
     fi